@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <string.h>     // For strlen, memcpy
 #include <fcntl.h>      // For open/read/close (SPIFFS file serving)
+#include <stdlib.h>     // For strtoul
+#include <stdatomic.h>  // Sample ring publication (ISR -> HTTP task)
 
 // FreeRTOS
 #include "freertos/FreeRTOS.h"
@@ -13,6 +15,7 @@
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 // #include "esp_flash.h" // Celowo usunięte
 
 // Wi-Fi
@@ -27,6 +30,14 @@
 
 // HTTP Server
 #include "esp_http_server.h"
+#include "web_static.h"
+#include "file_cache.h"
+#include "buf_pool.h"
+#include "json_stream.h"
+#include "httpd_workers.h"
+#include "metrics.h"
+#include "resp_writer.h"
+#include "log_ring.h"
 
 // --- Logging TAGs ---
 static const char *TAG_MAIN = "MAIN";
@@ -49,14 +60,42 @@ static const char *TAG_WEB = "WEB_SRV";
 #define ADC_READER_SAMPLE_FREQ  (20 * 1000)         // Częstotliwość próbkowania 20kHz
 #define ADC_READER_BUF_SIZE     512                 // Mniejszy całkowity rozmiar bufora
 #define ADC_READER_FRAME_SIZE   ADC_READER_READ_LEN // Rozmiar ramki = rozmiar odczytu (128)
+#define ADC_HISTORY_LEN         1024                // Ring uśrednionych ramek (~3 s przy 20 kHz), potęga 2
+
+// --- /data?since=&max= (batch + long-poll) ---
+#define DATA_BATCH_DEFAULT      256                 // Domyślna liczba próbek w odpowiedzi
+#define DATA_BATCH_MAX          256                 // Limit max= (rozmiar buforów s_data_batch_*)
+#define DATA_POLL_TIMEOUT_MS    2000                // Domyślny czas long-poll
+#define DATA_POLL_TIMEOUT_MAX   10000
+#define DATA_POLL_MAX_PARKED    4                   // Czekające long-polle; kolejne dostają 503
+#define DATA_POLL_TASK_STACK    4096
+
+// --- Worker pool (długie transfery poza zadaniem serwera) ---
+#define HTTP_WORKER_COUNT       2
+#define HTTP_WORKER_QUEUE_LEN   4
 
 // --- Web Server Configuration ---
 #define FILE_PATH_MAX           550                 // Zwiększony rozmiar bufora na ścieżkę
-#define SCRATCH_BUFSIZE         (10240)             // Bufor do odczytu plików (można zmniejszyć)
+#define STORAGE_BASE_PATH       "/storage"
+#define ASSETS_PARTITION        "assets"            // Tylko do odczytu, mapowana (esp_partition_mmap)
+#define FILE_CACHE_BUDGET       (32 * 1024)         // RAM na cache plików z SPIFFS
+#define FILE_CACHE_MAX_ENTRY    (16 * 1024)         // Większe pliki (my_img.jpeg) idą z flasha
+#define IO_BUF_SIZE             (4096)              // Bufor do odczytu plików (z puli, nie malloc)
+#define IO_BUF_COUNT            3                   // Liczba buforów w puli
 
 // --- Global Static Variables ---
 static adc_continuous_handle_t s_adc_handle = NULL;
 static volatile int s_latest_adc_value = 0;
+
+// Frame averages written by the ADC ISR; sample `seq` lives at [seq % ADC_HISTORY_LEN]
+static uint16_t s_adc_history[ADC_HISTORY_LEN];
+static _Atomic uint32_t s_adc_last_seq = 0;         // 0 = no sample yet
+static _Atomic uint32_t s_adc_waiters = 0;          // long-poll requests parked in s_data_polls
+static TaskHandle_t s_data_poll_task = NULL;        // completes parked long-polls, woken by the ISR
+
+// Liczniki eksportowane na /metrics (inkrementowane w ISR - tylko atomiki)
+static metrics_counter_t s_adc_frames = METRICS_COUNTER_INIT("adc_frames_total", "ADC conversion frames handled by the ISR");
+static metrics_counter_t s_adc_samples = METRICS_COUNTER_INIT("adc_samples_total", "ADC samples averaged on the reader channel");
 static httpd_handle_t s_web_server_handle = NULL;
 
 //==============================================================================
@@ -80,10 +119,23 @@ static bool IRAM_ATTR s_adc_conv_done_cb(adc_continuous_handle_t handle, const a
             count++;
         }
     }
+    metrics_counter_inc(&s_adc_frames);
+    metrics_counter_add(&s_adc_samples, count);
+
+    BaseType_t must_yield = pdFALSE;
     if (count > 0) {
         s_latest_adc_value = (int)(sum / count);
+
+        // Publish into the history ring: data first, then the sequence number
+        uint32_t seq = atomic_load_explicit(&s_adc_last_seq, memory_order_relaxed) + 1;
+        s_adc_history[seq % ADC_HISTORY_LEN] = (uint16_t)s_latest_adc_value;
+        atomic_store_explicit(&s_adc_last_seq, seq, memory_order_release);
+
+        if (atomic_load_explicit(&s_adc_waiters, memory_order_relaxed) > 0) {
+            vTaskNotifyGiveFromISR(s_data_poll_task, &must_yield);
+        }
     }
-    return true;
+    return must_yield == pdTRUE;
 }
 
 /**
@@ -92,23 +144,6 @@ static bool IRAM_ATTR s_adc_conv_done_cb(adc_continuous_handle_t handle, const a
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 { /* Empty */ }
 
-/**
- * @brief Simple helper to set MIME type based on file extension
- */
-static esp_err_t set_content_type_from_file(httpd_req_t *req, const char *filepath)
-{
-    const char *type = "text/plain";
-    if (strstr(filepath, ".html")) type = "text/html";
-    else if (strstr(filepath, ".js")) type = "application/javascript";
-    else if (strstr(filepath, ".css")) type = "text/css";
-    else if (strstr(filepath, ".png")) type = "image/png";
-    else if (strstr(filepath, ".ico")) type = "image/x-icon";
-    else if (strstr(filepath, ".jpg")) type = "image/jpeg";
-    else if (strstr(filepath, ".json")) type = "application/json";
-    return httpd_resp_set_type(req, type);
-}
-
-
 //==============================================================================
 // ADC Reader Implementation
 //==============================================================================
@@ -120,6 +155,50 @@ static int adc_reader_get_value(void) {
     return s_latest_adc_value;
 }
 
+/**
+ * @brief Copies buffered frame averages newer than @p since into @p out.
+ *
+ * @param since     Last sequence number the client has seen (0 = none)
+ * @param out       Destination for up to @p max values
+ * @param first_seq Sequence number of out[0]
+ * @param last_seq  Newest sequence number available
+ * @return number of values copied
+ */
+static size_t adc_reader_get_history(uint32_t since, uint16_t *out, size_t max,
+                                     uint32_t *first_seq, uint32_t *last_seq)
+{
+    uint32_t last = atomic_load_explicit(&s_adc_last_seq, memory_order_acquire);
+    uint32_t oldest = last >= ADC_HISTORY_LEN ? last - ADC_HISTORY_LEN + 1 : 1;
+    uint32_t first = since + 1 > oldest ? since + 1 : oldest;
+
+    *last_seq = last;
+    if (last < first) {
+        *first_seq = first;
+        return 0;
+    }
+    size_t n = last - first + 1;
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_adc_history[(first + i) % ADC_HISTORY_LEN];
+    }
+
+    // Drop values the ISR may have overwritten while we were copying
+    uint32_t now = atomic_load_explicit(&s_adc_last_seq, memory_order_acquire);
+    uint32_t still_valid = now >= ADC_HISTORY_LEN ? now - ADC_HISTORY_LEN + 1 : 1;
+    if (first < still_valid) {
+        size_t lost = still_valid - first;
+        if (lost >= n) {
+            n = 0;
+        } else {
+            memmove(out, out + lost, (n - lost) * sizeof(*out));
+            n -= lost;
+        }
+        first = still_valid;
+    }
+    *first_seq = first;
+    return n;
+}
+
 /**
  * @brief Initializes ADC in continuous mode.
  */
@@ -250,69 +329,216 @@ static void wifi_init_softap(void)
  * *** BEZ OCHRONY FLASH GUARD - RYZYKO CRASHU POZOSTAJE ***
  */
 static esp_err_t root_get_handler(httpd_req_t *req)
+{
+    // Obsługa nagłówka Range (wznawianie pobierania) jest w web_static
+    return web_static_send_file(req, STORAGE_BASE_PATH "/index.html", NULL);
+}
+
+/**
+ * @brief Handler plików statycznych (np. /my_img.jpeg) z partycji SPIFFS
+ */
+static esp_err_t static_file_get_handler(httpd_req_t *req)
 {
     char filepath[FILE_PATH_MAX];
-    snprintf(filepath, sizeof(filepath), "/storage/index.html");
+    size_t uri_len = strcspn(req->uri, "?#");
 
-    // Bezpośredni dostęp do SPIFFS - może powodować konflikt z ADC ISR
-    int fd = open(filepath, O_RDONLY, 0);
-    if (fd == -1) {
-        ESP_LOGE(TAG_WEB, "Failed to open %s", filepath);
-        httpd_resp_send_404(req);
+    // Nie pozwalamy wyjść poza /storage
+    if (strstr(req->uri, "..") != NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid path");
+        return ESP_FAIL;
+    }
+    if (uri_len + sizeof(STORAGE_BASE_PATH) > sizeof(filepath)) {
+        httpd_resp_send_err(req, HTTPD_414_URI_TOO_LONG, "Path too long");
         return ESP_FAIL;
     }
+    snprintf(filepath, sizeof(filepath), STORAGE_BASE_PATH "%.*s", (int)uri_len, req->uri);
+    return web_static_send_file(req, filepath, NULL);
+}
+
+/**
+ * @brief Zwraca wartość parametru liczbowego z query stringa lub @p def
+ */
+static uint32_t query_get_u32(const char *query, const char *key, uint32_t def)
+{
+    char val[12];
+    if (query == NULL || httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK) {
+        return def;
+    }
+    return (uint32_t)strtoul(val, NULL, 10);
+}
 
-    // set_content_type_from_file musi być zdefiniowana przed tą linią
-    set_content_type_from_file(req, filepath);
+// Próbki dla data_send_batch poza stosem (512 B): jeden bufor na każde wywołujące zadanie.
+// /data jest HTTPD_WORKERS_INLINE, więc handler działa tylko w zadaniu serwera.
+static uint16_t s_data_batch_httpd[DATA_BATCH_MAX];
+static uint16_t s_data_batch_poll[DATA_BATCH_MAX];
 
-    char *chunk = (char *)malloc(SCRATCH_BUFSIZE);
-    if (!chunk) {
-         ESP_LOGE(TAG_WEB, "Failed to allocate scratch buffer");
-         close(fd);
-         httpd_resp_send_500(req);
-         return ESP_FAIL;
+/**
+ * @brief Odpowiedź /data?since=: próbki po @p since (najwyżej @p max) jako JSON/CBOR.
+ * @param values bufor DATA_BATCH_MAX próbek należący do wywołującego zadania
+ */
+static esp_err_t data_send_batch(httpd_req_t *req, uint32_t since, uint32_t max, uint16_t *values)
+{
+    uint32_t first_seq, last_seq;
+    size_t n = adc_reader_get_history(since, values, max, &first_seq, &last_seq);
+
+    // Streamed: 256 values do not fit a single stack buffer comfortably.
+    // resp_writer skleja małe kawałki w chunki wielkości segmentu TCP
+    char chunk[256];
+    json_stream_t js;
+    resp_writer_t w;
+    resp_writer_init(&w, req);
+    json_stream_init_flush(&js, chunk, sizeof(chunk), resp_writer_sink, &w);
+    json_stream_negotiate(&js, req); // JSON albo CBOR (Accept: application/cbor)
+    json_stream_begin_object(&js);
+    json_stream_kv_uint(&js, "first", first_seq);
+    json_stream_kv_uint(&js, "cursor", n > 0 ? first_seq + n - 1 : since); // since= dla kolejnego zapytania
+    json_stream_kv_uint(&js, "last", last_seq);
+    json_stream_key(&js, "values");
+    json_stream_begin_array(&js);
+    for (size_t i = 0; i < n; i++) {
+        json_stream_uint(&js, values[i]);
     }
+    json_stream_end_array(&js);
+    json_stream_end_object(&js);
+    if (json_stream_finish(&js) != ESP_OK) {
+        resp_writer_discard(&w);
+        httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+        return ESP_FAIL;
+    }
+    return resp_writer_finish(&w);
+}
 
-    ssize_t read_bytes;
-    esp_err_t send_err = ESP_OK;
-    do {
-        read_bytes = read(fd, chunk, SCRATCH_BUFSIZE); // Odczyt może powodować konflikt
-        if (read_bytes == -1) {
-            ESP_LOGE(TAG_WEB, "Error reading file : %s", filepath);
-            send_err = ESP_FAIL; break;
-        } else if (read_bytes > 0) {
-            if (httpd_resp_send_chunk(req, chunk, read_bytes) != ESP_OK) {
-                ESP_LOGE(TAG_WEB, "File sending failed!");
-                send_err = ESP_FAIL; break;
+// Long-poll zaparkowany do czasu nowych próbek albo upływu terminu
+typedef struct {
+    httpd_req_t *req;           // kopia async; NULL = wolne miejsce
+    uint32_t since;
+    uint32_t max;
+    int64_t deadline_us;
+} data_poll_t;
+
+static data_poll_t s_data_polls[DATA_POLL_MAX_PARKED];
+static portMUX_TYPE s_data_polls_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Kończy zaparkowane long-polle: budzone przez ISR przy nowej ramce
+ *        i przez handler przy nowym parkowaniu, inaczej śpi do najbliższego terminu.
+ */
+static void data_poll_task(void *arg)
+{
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        int64_t next = now + DATA_POLL_TIMEOUT_MAX * 1000LL;
+        uint32_t last = atomic_load(&s_adc_last_seq);
+
+        for (size_t i = 0; i < DATA_POLL_MAX_PARKED; i++) {
+            portENTER_CRITICAL(&s_data_polls_mux);
+            data_poll_t poll = s_data_polls[i];
+            bool due = poll.req && (last > poll.since || poll.deadline_us <= now);
+            if (due) s_data_polls[i].req = NULL;
+            portEXIT_CRITICAL(&s_data_polls_mux);
+
+            if (due) {
+                atomic_fetch_sub(&s_adc_waiters, 1);
+                data_send_batch(poll.req, poll.since, poll.max, s_data_batch_poll);
+                httpd_req_async_handler_complete(poll.req);
+            } else if (poll.req && poll.deadline_us < next) {
+                next = poll.deadline_us;
             }
         }
-    } while (read_bytes > 0);
-
-    close(fd);
-    free(chunk);
-
-    if (send_err == ESP_OK && read_bytes == 0) {
-         ESP_LOGI(TAG_WEB, "File '%s' sending complete", filepath);
-         httpd_resp_send_chunk(req, NULL, 0);
-         return ESP_OK;
-    } else {
-         httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
-         return ESP_FAIL;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((next - now) / 1000) + 1);
     }
 }
 
+/**
+ * @brief Odkłada @p req do czasu nowych danych; zadanie serwera od razu wraca.
+ *
+ * @return ESP_OK gdy zaparkowany, ESP_ERR_NO_MEM gdy brak miejsca
+ */
+static esp_err_t data_poll_park(httpd_req_t *req, uint32_t since, uint32_t max, uint32_t timeout_ms)
+{
+    httpd_req_t *copy = NULL;
+    if (httpd_req_async_handler_begin(req, &copy) != ESP_OK) return ESP_ERR_NO_MEM;
+
+    // Licznik przed wpisem: ISR musi budzić zadanie, gdy tylko ktoś czeka
+    atomic_fetch_add(&s_adc_waiters, 1);
+    bool parked = false;
+    portENTER_CRITICAL(&s_data_polls_mux);
+    for (size_t i = 0; i < DATA_POLL_MAX_PARKED && !parked; i++) {
+        if (s_data_polls[i].req == NULL) {
+            s_data_polls[i] = (data_poll_t){
+                .req = copy, .since = since, .max = max,
+                .deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000,
+            };
+            parked = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_data_polls_mux);
+
+    if (!parked) {
+        atomic_fetch_sub(&s_adc_waiters, 1);
+        httpd_req_async_handler_complete(copy);
+        return ESP_ERR_NO_MEM;
+    }
+    // Próbka mogła przyjść tuż przed wpisem - zadanie sprawdzi to samo
+    xTaskNotifyGive(s_data_poll_task);
+    return ESP_OK;
+}
+
+/**
+ * @brief /data?since=<seq>&max=<n>[&timeout=<ms>] - wszystkie próbki po seq
+ *        w jednej odpowiedzi; czeka (long-poll), jeśli nie ma nic nowego.
+ */
+static esp_err_t data_batch_handler(httpd_req_t *req, const char *query)
+{
+    uint32_t since = query_get_u32(query, "since", 0);
+    uint32_t max = query_get_u32(query, "max", DATA_BATCH_DEFAULT);
+    uint32_t timeout_ms = query_get_u32(query, "timeout", DATA_POLL_TIMEOUT_MS);
+    if (max == 0 || max > DATA_BATCH_MAX) max = DATA_BATCH_MAX;
+    if (timeout_ms > DATA_POLL_TIMEOUT_MAX) timeout_ms = DATA_POLL_TIMEOUT_MAX;
+
+    // A client ahead of us (e.g. after a reboot) starts over from the oldest sample
+    if (since > atomic_load(&s_adc_last_seq)) since = 0;
+
+    // Long-poll nie blokuje ani zadania serwera, ani workerów - czeka w s_data_polls
+    if (timeout_ms > 0 && atomic_load(&s_adc_last_seq) <= since) {
+        if (data_poll_park(req, since, max, timeout_ms) == ESP_OK) return ESP_OK;
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, "Too many pending polls", HTTPD_RESP_USE_STRLEN);
+    }
+    return data_send_batch(req, since, max, s_data_batch_httpd);
+}
+
 /**
  * @brief Handler danych JSON (endpoint /data)
  */
 static esp_err_t data_get_handler(httpd_req_t *req)
 {
     // adc_reader_get_value musi być zdefiniowana przed tą linią
-    ESP_LOGI(TAG_WEB, "/data handler entered"); // Log testowy
-    httpd_resp_set_type(req, "application/json");
+    LOG_RING_D(TAG_WEB, "/data handler entered"); // Log testowy - wycinany przy kompilacji (poziom INFO)
+
+    // Z parametrem since= odpowiadamy paczką próbek zamiast jednej wartości
+    char query[64];
+    size_t query_len = httpd_req_get_url_query_len(req);
+    if (query_len > 0 && query_len < sizeof(query) &&
+        httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        strstr(query, "since=") != NULL) {
+        return data_batch_handler(req, query);
+    }
+
     int adc_val = adc_reader_get_value();
     char resp_str[64];
-    snprintf(resp_str, sizeof(resp_str), "{\"adcValue\": %d}", adc_val);
-    httpd_resp_send(req, resp_str, HTTPD_RESP_USE_STRLEN);
+    json_stream_t js;
+    json_stream_init(&js, resp_str, sizeof(resp_str));
+    json_stream_negotiate(&js, req);
+    json_stream_begin_object(&js);
+    json_stream_kv_int(&js, "adcValue", adc_val);
+    json_stream_end_object(&js);
+    if (json_stream_finish(&js) != ESP_OK) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    httpd_resp_send(req, resp_str, json_stream_len(&js));
     return ESP_OK;
 }
 
@@ -324,19 +550,54 @@ static esp_err_t start_webserver(void)
     // Handlery root_get_handler i data_get_handler muszą być zdefiniowane PRZED tą funkcją
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.lru_purge_enable = true;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    httpd_workers_config_t workers_cfg = HTTPD_WORKERS_DEFAULT_CONFIG();
+    workers_cfg.num_workers = HTTP_WORKER_COUNT;
+    workers_cfg.queue_len = HTTP_WORKER_QUEUE_LEN;
+    esp_err_t ret = httpd_workers_start(&workers_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG_WEB, "Error starting HTTP workers: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (xTaskCreate(data_poll_task, "data_poll", DATA_POLL_TASK_STACK, NULL, 5, &s_data_poll_task) != pdPASS) {
+        ESP_LOGE(TAG_WEB, "Error creating long-poll task");
+        return ESP_ERR_NO_MEM;
+    }
 
     ESP_LOGI(TAG_WEB, "Starting server on port: '%d'", config.server_port);
-    esp_err_t ret = httpd_start(&s_web_server_handle, &config);
+    ret = httpd_start(&s_web_server_handle, &config);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG_WEB, "Registering URI handlers");
 
-        // Handler dla /data
+        // Handler dla /data (krótki, inline; long-poll parkuje się w s_data_polls)
         httpd_uri_t data_uri = { .uri = "/data", .method = HTTP_GET, .handler = data_get_handler };
-        httpd_register_uri_handler(s_web_server_handle, &data_uri);
+        httpd_workers_register_uri(s_web_server_handle, &data_uri, HTTPD_WORKERS_INLINE);
 
-        // Handler dla roota '/'
+        // Handler dla roota '/' - transfer pliku na workerze
         httpd_uri_t root_uri = { .uri = "/", .method = HTTP_GET, .handler = root_get_handler };
-        httpd_register_uri_handler(s_web_server_handle, &root_uri);
+        httpd_workers_register_uri(s_web_server_handle, &root_uri, HTTPD_WORKERS_OFFLOAD);
+
+        // Statystyki: cache plików, pula buforów, fragmentacja sterty
+        httpd_uri_t stats_uri = { .uri = "/stats", .method = HTTP_GET, .handler = web_static_stats_handler };
+        httpd_workers_register_uri(s_web_server_handle, &stats_uri, HTTPD_WORKERS_INLINE);
+
+        // Kolejka workerów i opóźnienia per endpoint
+        httpd_uri_t workers_uri = { .uri = "/workers", .method = HTTP_GET, .handler = httpd_workers_stats_handler };
+        httpd_workers_register_uri(s_web_server_handle, &workers_uri, HTTPD_WORKERS_INLINE);
+
+        // Eksport Prometheus: histogramy opóźnień per endpoint, sterta, ADC
+        httpd_uri_t metrics_uri = { .uri = "/metrics", .method = HTTP_GET, .handler = metrics_prometheus_handler };
+        httpd_workers_register_uri(s_web_server_handle, &metrics_uri, HTTPD_WORKERS_INLINE);
+
+        // Ostatnie wpisy z bufora logów w RAM
+        httpd_uri_t logs_uri = { .uri = "/logs", .method = HTTP_GET, .handler = log_ring_http_handler };
+        httpd_workers_register_uri(s_web_server_handle, &logs_uri, HTTPD_WORKERS_INLINE);
+
+        // Pozostałe pliki z /storage (rejestrowany jako ostatni - wildcard)
+        httpd_uri_t static_uri = { .uri = "/*", .method = HTTP_GET, .handler = static_file_get_handler };
+        httpd_workers_register_uri(s_web_server_handle, &static_uri, HTTPD_WORKERS_OFFLOAD);
 
         return ESP_OK;
     }
@@ -373,16 +634,30 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
-    // 2. SPIFFS
+    // 2. Pula buforów I/O - przed Wi-Fi, zanim sterta się pofragmentuje
+    ESP_ERROR_CHECK(buf_pool_init(IO_BUF_SIZE, IO_BUF_COUNT));
+    metrics_register_system();
+    resp_writer_register_metrics();
+    metrics_register(&s_adc_frames.base);
+    metrics_register(&s_adc_samples.base);
+    // Logi z gorących ścieżek idą do bufora w RAM; wypisuje je zadanie o niskim priorytecie
+    log_ring_start_console(1, 200);
+
+    // 3. SPIFFS
     ESP_ERROR_CHECK(init_spiffs());
+    ESP_ERROR_CHECK(file_cache_init(FILE_CACHE_BUDGET, FILE_CACHE_MAX_ENTRY));
+    // Partycja "assets" mapowana do pamięci - pliki idą z flasha bez kopiowania
+    if (web_static_mount_assets(ASSETS_PARTITION, STORAGE_BASE_PATH) != ESP_OK) {
+        ESP_LOGW(TAG_MAIN, "No asset partition, serving from SPIFFS only");
+    }
 
-    // 3. Wi-Fi
+    // 4. Wi-Fi
     wifi_init_softap();
 
-    // 4. ADC
+    // 5. ADC
     ESP_ERROR_CHECK(adc_reader_init());
 
-    // 5. Web Server
+    // 6. Web Server
     ESP_ERROR_CHECK(start_webserver());
 
     ESP_LOGI(TAG_MAIN, "Initialization finished. System running.");
@@ -0,0 +1,198 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include <actuator.h>
+#include <metrics.h>
+#include "actuator_bench.h"
+
+#define AB_PORT             8089        // 8090: its httpd control port
+#define AB_BURST            50
+#define AB_FAILS            3
+#define AB_WAIT_MS          1000
+
+static struct {
+    volatile bool hold;         // apply blocks while set
+    volatile bool busy;         // apply entered and is holding
+    int32_t values[AB_BURST];   // in apply order
+    volatile uint32_t count;
+} s_out;
+
+static esp_err_t ab_apply(int32_t value, void *ctx)
+{
+    if (s_out.count < AB_BURST) s_out.values[s_out.count] = value;
+    s_out.busy = true;
+    while (s_out.hold) vTaskDelay(pdMS_TO_TICKS(1));
+    s_out.busy = false;
+    s_out.count++;
+    return ESP_OK;
+}
+
+static esp_err_t ab_apply_fail(int32_t value, void *ctx)
+{
+    return ESP_ERR_TIMEOUT;
+}
+
+// Waits until @p id has applied or failed @p done commands in total
+static bool wait_done(int id, uint32_t done, actuator_stats_t *stats)
+{
+    int64_t deadline = esp_timer_get_time() + AB_WAIT_MS * 1000LL;
+    do {
+        actuator_get_stats(id, stats);
+        if (stats->applied + stats->failed >= done) return true;
+        vTaskDelay(pdMS_TO_TICKS(1));
+    } while (esp_timer_get_time() < deadline);
+    return false;
+}
+
+// Sets while the driver holds the previous value: only the newest is applied
+static int run_coalesce(int id)
+{
+    s_out.count = 0;
+    s_out.hold = true;
+    actuator_set(id, 0, esp_timer_get_time());
+    int64_t deadline = esp_timer_get_time() + AB_WAIT_MS * 1000LL;
+    while (!s_out.busy && esp_timer_get_time() < deadline) vTaskDelay(pdMS_TO_TICKS(1));
+    for (int32_t v = 1; v <= AB_BURST; v++) actuator_set(id, v, esp_timer_get_time());
+    s_out.hold = false;
+
+    actuator_stats_t stats;
+    bool done = wait_done(id, 2, &stats);
+    vTaskDelay(pdMS_TO_TICKS(20));      // nothing else may follow
+    actuator_get_stats(id, &stats);
+    printf("actuator burst of %d while busy: %u applied, %u coalesced, last %ld\n", AB_BURST,
+           (unsigned)stats.applied, (unsigned)stats.coalesced, (long)stats.value);
+    if (!done || s_out.count != 2 || s_out.values[0] != 0 || s_out.values[1] != AB_BURST ||
+        stats.value != AB_BURST || stats.coalesced != AB_BURST - 1 || stats.commands != AB_BURST + 1) {
+        printf("actuator: burst not coalesced to the newest value\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int run_lookup(int id)
+{
+    int failures = 0;
+    actuator_stats_t before, after;
+    actuator_get_stats(id, &before);
+    esp_err_t found = actuator_command("ab_out", 7, esp_timer_get_time());
+    bool applied = wait_done(id, before.applied + before.failed + 1, &after) && after.value == 7;
+    if (found != ESP_OK || !applied) {
+        printf("actuator: command by name not applied (%s)\n", esp_err_to_name(found));
+        failures++;
+    }
+
+    const char *unknown[] = { "nope", "ab_ou", "ab_out2", "" };
+    for (size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); i++) {
+        esp_err_t err = actuator_command(unknown[i], 1, esp_timer_get_time());
+        if (err != ESP_ERR_NOT_FOUND) {
+            printf("actuator: unknown name \"%s\" gave %s\n", unknown[i], esp_err_to_name(err));
+            failures++;
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(20));
+    actuator_get_stats(id, &before);
+    if (before.commands != after.commands || before.value != 7) {
+        printf("actuator: unknown name reached a registered actuator\n");
+        failures++;
+    }
+    return failures;
+}
+
+static int run_failing(int id)
+{
+    actuator_stats_t stats;
+    bool done = true;
+    for (int i = 0; i < AB_FAILS; i++) {
+        actuator_set(id, i, esp_timer_get_time());
+        done = done && wait_done(id, i + 1, &stats);
+    }
+    printf("actuator driver error: %u failed, %u applied\n", (unsigned)stats.failed, (unsigned)stats.applied);
+    if (!done || stats.failed != AB_FAILS || stats.applied != 0) {
+        printf("actuator: driver errors not counted as failures\n");
+        return 1;
+    }
+    return 0;
+}
+
+// actuator_latency_seconds_count for @p name as scraped from /metrics, -1 if missing
+static long scrape_count(const char *name)
+{
+    static char body[16384];
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(AB_PORT) };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { .tv_sec = 5 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    const char *req = "GET /metrics HTTP/1.1\r\nHost: bench\r\nConnection: close\r\n\r\n";
+    size_t len = 0;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 && send(fd, req, strlen(req), 0) > 0) {
+        int n;
+        while (len < sizeof(body) - 1 && (n = recv(fd, body + len, sizeof(body) - 1 - len, 0)) > 0) len += n;
+    }
+    close(fd);
+    body[len] = '\0';
+
+    // The exporter flushes whole lines, so chunk framing never splits one
+    char key[64];
+    snprintf(key, sizeof(key), "actuator_latency_seconds_count{actuator=\"%s\"} ", name);
+    const char *p = strstr(body, key);
+    long count = -1;
+    if (p) sscanf(p + strlen(key), "%ld", &count);
+    return count;
+}
+
+static int check_histogram(int out_id)
+{
+    httpd_handle_t server = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = AB_PORT;
+    config.ctrl_port = AB_PORT + 1;
+    if (httpd_start(&server, &config) != ESP_OK) {
+        printf("actuator: cannot listen on %d\n", AB_PORT);
+        return 1;
+    }
+    const httpd_uri_t uri = { .uri = "/metrics", .method = HTTP_GET, .handler = metrics_prometheus_handler };
+    httpd_register_uri_handler(server, &uri);
+
+    actuator_stats_t out;
+    actuator_get_stats(out_id, &out);
+    long applied = scrape_count("ab_out"), failed = scrape_count("ab_fail");
+    httpd_stop(server);
+    printf("actuator latency: avg %u us, max %u us; histogram count %ld (applied %u), %ld for the failing one\n",
+           out.applied ? (unsigned)(out.latency_total_us / out.applied) : 0, (unsigned)out.latency_max_us, applied,
+           (unsigned)out.applied, failed);
+    if (applied <= 0 || applied != (long)out.applied || failed != 0) {
+        printf("actuator: latency histogram does not match the applied commands\n");
+        return 1;
+    }
+    return 0;
+}
+
+int actuator_bench_run(void)
+{
+    int out_id, fail_id;
+    if (actuator_register("ab_out", ab_apply, NULL, &out_id) != ESP_OK ||
+        actuator_register("ab_fail", ab_apply_fail, NULL, &fail_id) != ESP_OK ||
+        actuator_start(5) != ESP_OK) {
+        printf("actuator: setup failed\n");
+        return 1;
+    }
+    esp_log_level_set("actuator", ESP_LOG_ERROR);       // every failure below is expected
+    int failures = 0;
+    failures += run_coalesce(out_id);
+    failures += run_lookup(out_id);
+    failures += run_failing(fail_id);
+    failures += check_histogram(out_id);
+    esp_log_level_set("actuator", ESP_LOG_INFO);
+    return failures;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * @brief actuator: a burst of sets while the driver is busy must coalesce
+ *        to the newest value, commands by name must find registered
+ *        actuators and reject unknown ones, driver errors must be counted
+ *        as failures, and applied commands must show up in the latency
+ *        histogram on /metrics.
+ *
+ * @return number of failed checks
+ */
+int actuator_bench_run(void);
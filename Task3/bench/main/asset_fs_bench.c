@@ -0,0 +1,306 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <asset_fs.h>
+#include "asset_fs_bench.h"
+
+// The bundle goes to the "assets" partition of the emulated flash (partitions.csv),
+// the same files to the host filesystem for the read() path
+#define AF_PARTITION        "assets"
+#define AF_DIR              "/tmp/asset_fs_bench"
+#define AF_FILES            8           // served by the throughput run
+#define AF_SMALL_FILES      248         // only looked up
+#define AF_ENTRIES          (AF_FILES + AF_SMALL_FILES + 1)
+#define AF_SMALL_SIZE       64
+#define AF_CHUNK            4096        // buf_pool buffer size on the device
+#define AF_ROUNDS           400
+#define AF_LOOKUPS          200000
+
+// 1 KB .. 128 KB, roughly what a web UI ships
+static const size_t s_sizes[AF_FILES] = { 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072 };
+
+// An index entry pointing past the image; lookups must refuse it
+#define AF_CORRUPT_NAME     "/corrupt.js"
+
+static uint32_t s_rng = 0x2545f491;
+
+static uint32_t next_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void file_name(char *buf, size_t size, int i)
+{
+    if (i < AF_FILES) snprintf(buf, size, "/f%d.js", i);
+    else if (i < AF_FILES + AF_SMALL_FILES) snprintf(buf, size, "/img/s%03d.png", i - AF_FILES);
+    else snprintf(buf, size, AF_CORRUPT_NAME);
+}
+
+static size_t file_size(int i)
+{
+    return i < AF_FILES ? s_sizes[i] : i < AF_FILES + AF_SMALL_FILES ? AF_SMALL_SIZE : 0;
+}
+
+static size_t align_up(size_t n)
+{
+    return (n + ASSET_FS_ALIGN - 1) & ~(size_t)(ASSET_FS_ALIGN - 1);
+}
+
+static int cmp_hash(const void *a, const void *b)
+{
+    uint32_t ha = ((const asset_fs_entry_t *)a)->name_hash, hb = ((const asset_fs_entry_t *)b)->name_hash;
+    return ha < hb ? -1 : ha > hb;
+}
+
+// The layout mkassets.py writes, without gzip variants; digests are not checked here
+static uint8_t *build_image(uint8_t *const files[], size_t *image_size)
+{
+    char name[32];
+    size_t names_size = 0;
+    for (int i = 0; i < AF_ENTRIES; i++) {
+        file_name(name, sizeof(name), i);
+        names_size += strlen(name) + 1;
+    }
+    size_t offset = align_up(sizeof(asset_fs_header_t) + AF_ENTRIES * sizeof(asset_fs_entry_t) + names_size);
+    size_t size = offset;
+    for (int i = 0; i < AF_ENTRIES; i++) size = align_up(size + file_size(i));
+
+    uint8_t *img = calloc(1, size);
+    if (!img) return NULL;
+    asset_fs_header_t hdr = {
+        .magic = ASSET_FS_MAGIC, .version = ASSET_FS_VERSION, .count = AF_ENTRIES,
+        .image_size = size, .names_size = names_size,
+    };
+    memcpy(img, &hdr, sizeof(hdr));
+
+    static asset_fs_entry_t entries[AF_ENTRIES];
+    size_t name_offset = sizeof(hdr) + sizeof(entries);
+    for (int i = 0; i < AF_ENTRIES; i++) {
+        file_name(name, sizeof(name), i);
+        entries[i] = (asset_fs_entry_t){
+            .name_hash = asset_fs_hash(name), .name_offset = name_offset,
+            .offset = offset, .size = file_size(i),
+        };
+        if (files[i]) {
+            memcpy(entries[i].digest, files[i], ASSET_FS_DIGEST_LEN);
+            memcpy(img + offset, files[i], file_size(i));
+        } else {
+            entries[i].size = size;     // the corrupt entry
+        }
+        memcpy(img + name_offset, name, strlen(name) + 1);
+        name_offset += strlen(name) + 1;
+        offset = align_up(offset + file_size(i));
+    }
+    qsort(entries, AF_ENTRIES, sizeof(entries[0]), cmp_hash);
+    memcpy(img + sizeof(hdr), entries, sizeof(entries));
+    *image_size = size;
+    return img;
+}
+
+static bool write_file(const char *path, const uint8_t *data, size_t size)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return false;
+    bool ok = write(fd, data, size) == (ssize_t)size;
+    return close(fd) == 0 && ok;
+}
+
+// What web_static does with the bytes, reduced to touching each one
+static uint32_t consume(const uint8_t *data, size_t len)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < len; i++) sum += data[i];
+    return sum;
+}
+
+// Write @p hdr over the image's header and expect the mount to refuse it
+static int check_rejected(const esp_partition_t *part, const uint8_t *img, size_t img_size,
+                          const asset_fs_header_t *hdr, const char *what)
+{
+    esp_partition_erase_range(part, 0, part->size);
+    esp_partition_write(part, 0, img, img_size);
+    esp_partition_write(part, 0, hdr, sizeof(*hdr));
+    if (asset_fs_mount(AF_PARTITION) == ESP_OK) {
+        printf("asset_fs: mounted a bundle with %s\n", what);
+        return 1;
+    }
+    return 0;
+}
+
+// Returns the number of failed checks
+static int setup(void)
+{
+    int failures = 0;
+    uint8_t *files[AF_ENTRIES] = { 0 };
+    uint8_t *img = NULL;
+    size_t img_size = 0;
+    char name[32], path[64];
+
+    mkdir(AF_DIR, 0755);
+    for (int i = 0; i < AF_FILES + AF_SMALL_FILES; i++) {
+        files[i] = malloc(file_size(i));
+        if (!files[i]) goto out;
+        for (size_t j = 0; j < file_size(i); j++) files[i][j] = (uint8_t)next_rand();
+    }
+    for (int i = 0; i < AF_FILES; i++) {
+        file_name(name, sizeof(name), i);
+        snprintf(path, sizeof(path), AF_DIR "%s", name);
+        if (!write_file(path, files[i], s_sizes[i])) goto out;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, AF_PARTITION);
+    img = build_image(files, &img_size);
+    if (!part || !img || img_size > part->size) goto out;
+
+    // Headers the mount must refuse, before the valid one (a mount is for good)
+    asset_fs_header_t hdr;
+    memcpy(&hdr, img, sizeof(hdr));
+    asset_fs_header_t bad = hdr;
+    bad.magic ^= 1;
+    failures += check_rejected(part, img, img_size, &bad, "a wrong magic");
+    bad = hdr;
+    bad.version = ASSET_FS_VERSION - 1;
+    failures += check_rejected(part, img, img_size, &bad, "an old version");
+    bad = hdr;
+    bad.image_size = part->size + 1;
+    failures += check_rejected(part, img, img_size, &bad, "an image larger than the partition");
+    bad = hdr;
+    bad.names_size = hdr.image_size;
+    failures += check_rejected(part, img, img_size, &bad, "tables past the image end");
+
+    esp_partition_erase_range(part, 0, part->size);
+    esp_partition_write(part, 0, img, img_size);
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = asset_fs_mount(AF_PARTITION);
+    int64_t t1 = esp_timer_get_time();
+    if (err != ESP_OK) goto out;
+    printf("asset_fs mount (%d files, %u KB)  %u us\n", AF_ENTRIES, (unsigned)(img_size / 1024),
+           (unsigned)(t1 - t0));
+
+    // Every file found with its content, nothing else
+    if (asset_fs_count() != AF_ENTRIES) failures++;
+    for (int i = 0; i < AF_FILES + AF_SMALL_FILES; i++) {
+        asset_fs_file_t f;
+        char etag[sizeof(f.etag)], *p = etag;
+        *p++ = '"';
+        for (int j = 0; j < ASSET_FS_DIGEST_LEN; j++, p += 2) snprintf(p, 3, "%02x", files[i][j]);
+        strcpy(p, "\"");
+        file_name(name, sizeof(name), i);
+        if (!asset_fs_find(name, &f) || f.size != file_size(i) || f.gz_data ||
+            memcmp(f.data, files[i], f.size) != 0 || strcmp(f.etag, etag) != 0) {
+            printf("asset_fs: %s not found intact\n", name);
+            failures++;
+        }
+    }
+    asset_fs_file_t f;
+    if (asset_fs_find("/missing.js", &f) || asset_fs_find("/f0.j", &f) || asset_fs_find("", &f)) {
+        printf("asset_fs: found a file not in the bundle\n");
+        failures++;
+    }
+    if (asset_fs_find(AF_CORRUPT_NAME, &f)) {
+        printf("asset_fs: returned an entry reaching past the image\n");
+        failures++;
+    }
+
+    for (int i = 0; i < AF_ENTRIES; i++) free(files[i]);
+    free(img);
+    return failures;
+
+out:
+    printf("asset_fs: setup failed\n");
+    for (int i = 0; i < AF_ENTRIES; i++) free(files[i]);
+    free(img);
+    return failures + 1;
+}
+
+// ns per asset_fs_find for names in the bundle and names that are not
+static void run_lookups(void)
+{
+    static char names[AF_FILES + AF_SMALL_FILES][32];
+    static char missing[AF_FILES + AF_SMALL_FILES][32];
+    for (int i = 0; i < AF_FILES + AF_SMALL_FILES; i++) {
+        file_name(names[i], sizeof(names[i]), i);
+        snprintf(missing[i], sizeof(missing[i]), "/nope/%d.css", i);
+    }
+
+    asset_fs_file_t f;
+    unsigned found = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < AF_LOOKUPS; i++) found += asset_fs_find(names[next_rand() % (AF_FILES + AF_SMALL_FILES)], &f);
+    int64_t t1 = esp_timer_get_time();
+    for (int i = 0; i < AF_LOOKUPS; i++) found += asset_fs_find(missing[next_rand() % (AF_FILES + AF_SMALL_FILES)], &f);
+    int64_t t2 = esp_timer_get_time();
+    printf("asset_fs lookup (%d files)  hit %5.0f ns  miss %5.0f ns  (%u found)\n", AF_ENTRIES,
+           (t1 - t0) * 1000.0 / AF_LOOKUPS, (t2 - t1) * 1000.0 / AF_LOOKUPS, found);
+}
+
+static double cpu_ms(void)
+{
+    return clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+// Every file once per round, mapped and through read(); wall time and CPU time per MB
+static int run_throughput(void)
+{
+    static uint8_t chunk[AF_CHUNK];
+    char name[32], path[64];
+    uint32_t sum_mapped = 0, sum_read = 0;
+    size_t total = 0;
+    for (int i = 0; i < AF_FILES; i++) total += s_sizes[i];
+    double mb = (double)total * AF_ROUNDS / (1024 * 1024);
+
+    int64_t t0 = esp_timer_get_time();
+    double c0 = cpu_ms();
+    for (int r = 0; r < AF_ROUNDS; r++) {
+        for (int i = 0; i < AF_FILES; i++) {
+            asset_fs_file_t f;
+            file_name(name, sizeof(name), i);
+            if (asset_fs_find(name, &f)) sum_mapped += consume(f.data, f.size);
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+    double c1 = cpu_ms();
+    for (int r = 0; r < AF_ROUNDS; r++) {
+        for (int i = 0; i < AF_FILES; i++) {
+            file_name(name, sizeof(name), i);
+            snprintf(path, sizeof(path), AF_DIR "%s", name);
+            int fd = open(path, O_RDONLY, 0);
+            if (fd == -1) continue;
+            ssize_t n;
+            while ((n = read(fd, chunk, sizeof(chunk))) > 0) sum_read += consume(chunk, n);
+            close(fd);
+        }
+    }
+    int64_t t2 = esp_timer_get_time();
+    double c2 = cpu_ms();
+
+    printf("asset_fs (%d files, %u KB)  mapped %7.0f MB/s  %6.2f ms CPU/MB   read() %7.0f MB/s  %6.2f ms CPU/MB\n",
+           AF_FILES, (unsigned)(total / 1024),
+           mb / ((t1 - t0) / 1e6), (c1 - c0) / mb, mb / ((t2 - t1) / 1e6), (c2 - c1) / mb);
+    if (sum_mapped != sum_read) {
+        printf("asset_fs: mapped bytes differ from the files\n");
+        return 1;
+    }
+    return 0;
+}
+
+int asset_fs_bench_run(void)
+{
+    int failures = setup();
+    if (failures == 0) {
+        run_lookups();
+        failures += run_throughput();
+    }
+    return failures;
+}
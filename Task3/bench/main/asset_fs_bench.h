@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief asset_fs mount checks (bad headers refused, corrupt entries not
+ *        returned, every file found intact), mount and lookup times, then
+ *        throughput and CPU time per MB served from the mapped bundle
+ *        against open/read()/close through a buffer, as web_static does.
+ *
+ * @return number of failed checks
+ */
+int asset_fs_bench_run(void);
@@ -0,0 +1,477 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include <control_transport.h>
+#include <control_msg.h>
+#include <json_reader.h>
+#include "lossy_net.h"
+#include "control_channel_bench.h"
+#include "outbox_bench.h"
+#include "json_bench.h"
+#include "codec_bench.h"
+#include "fanout_bench.h"
+#include "reconnect_bench.h"
+#include "log_ring_bench.h"
+#include "state_store_bench.h"
+#include "actuator_bench.h"
+#include "file_cache_bench.h"
+#include "json_stream_bench.h"
+#include "asset_fs_bench.h"
+#include "http_load_bench.h"
+#include "uri_router_bench.h"
+
+static const char *TAG = "bench";
+
+// Both ends run here; sockets go over the loopback interface
+#define BENCH_HOST          "127.0.0.1"
+#define BENCH_HTTP_PORT     8080
+#define BENCH_UDP_PORT      3333
+#define BENCH_MESSAGES      2000
+#define BENCH_BURST         8           // messages handed over before each poll in the throughput run
+#define BENCH_POLL_MS       1000
+#define BENCH_LOSS_PCT      20          // datagrams lost each way in the lossy UDP run
+#define BENCH_LOSSY_MESSAGES 500
+
+// Receiver state, updated by the receive callback like the receiver's state store
+typedef struct {
+    control_data_t state;
+    uint32_t applied;
+    uint32_t rejected;
+} bench_rx_t;
+
+// Binary payloads, encoded and decoded as by the sender and receiver
+static size_t encode_control(int i, uint8_t *buf, size_t size)
+{
+    control_data_t data = { .toggle = i & 1 };
+    snprintf(data.message, sizeof(data.message), "Message #%d", i);
+    return control_msg_encode_binary(&data, buf, size);
+}
+
+static esp_err_t bench_recv(const void *payload, size_t len, void *ctx)
+{
+    bench_rx_t *rx = ctx;
+    if (control_msg_decode_binary(payload, len, &rx->state) != ESP_OK) {
+        rx->rejected++;
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx->applied++;
+    return ESP_OK;
+}
+
+static bench_rx_t s_http_rx;
+static bench_rx_t s_udp_rx;
+static bench_rx_t s_loopback_rx;
+
+static esp_err_t control_post_handler(httpd_req_t *req)
+{
+    return control_transport_http_serve(req, bench_recv, &s_http_rx);
+}
+
+// JSON payloads, as the receiver's /control takes them
+static esp_err_t bench_recv_json(const void *payload, size_t len, void *ctx)
+{
+    bench_rx_t *rx = ctx;
+    if (control_msg_decode_json(payload, len, &rx->state) != ESP_OK) {
+        rx->rejected++;
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx->applied++;
+    return ESP_OK;
+}
+
+static esp_err_t control_json_post_handler(httpd_req_t *req)
+{
+    return control_transport_http_serve(req, bench_recv_json, &s_http_rx);
+}
+
+// JSON parsed as it arrives, as the receiver's /control does it
+typedef struct {
+    control_data_t next;
+    json_reader_bind_t bind;
+    json_reader_t reader;
+} bench_stream_t;
+
+static esp_err_t stream_chunk(const void *chunk, size_t len, void *ctx)
+{
+    return json_reader_feed(&((bench_stream_t *)ctx)->reader, chunk, len);
+}
+
+static esp_err_t stream_end(esp_err_t err, void *ctx)
+{
+    bench_stream_t *st = ctx;
+    if (err == ESP_OK) err = json_reader_finish(&st->reader);
+    if (err == ESP_OK && !json_reader_bind_has_all(&st->bind)) err = ESP_ERR_INVALID_ARG;
+    if (err != ESP_OK) {
+        s_http_rx.rejected++;
+        return err;
+    }
+    s_http_rx.state = st->next;
+    s_http_rx.applied++;
+    return ESP_OK;
+}
+
+static esp_err_t control_stream_post_handler(httpd_req_t *req)
+{
+    bench_stream_t st;
+    control_msg_json_bind(&st.bind, &st.next, NULL, NULL);
+    json_reader_init(&st.reader, json_reader_bind_cb, &st.bind);
+    return control_transport_http_serve_stream(req, stream_chunk, stream_end, &st);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// One message at a time: send, then poll until confirmed. Gives the per-message latency.
+static void run_closed_loop(control_transport_t *t, bench_rx_t *rx)
+{
+    uint32_t *latency = calloc(BENCH_MESSAGES, sizeof(uint32_t));
+    if (!latency) return;
+    size_t samples = 0;
+    uint8_t payload[CONTROL_MSG_BINARY_MAX];
+    control_transport_stats_t st;
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_MESSAGES; i++) {
+        control_transport_get_stats(t, &st);
+        uint32_t delivered = st.delivered;
+
+        esp_err_t err = control_transport_send(t, payload, encode_control(i, payload, sizeof(payload)));
+        if (err == ESP_OK) err = control_transport_poll(t, BENCH_POLL_MS);
+        if (err != ESP_OK) ESP_LOGW(TAG, "%s: message %d: %s", t->name, i, esp_err_to_name(err));
+
+        control_transport_get_stats(t, &st);
+        if (st.delivered != delivered) latency[samples++] = st.latency_last_us;
+    }
+    double elapsed_s = (esp_timer_get_time() - start) / 1e6;
+
+    qsort(latency, samples, sizeof(uint32_t), cmp_u32);
+    printf("%-8s closed  %8.0f msg/s  p50 %6u us  p99 %6u us  max %6u us  delivered %u/%d  applied %u\n",
+           t->name, samples / elapsed_s,
+           samples ? (unsigned)latency[samples / 2] : 0, samples ? (unsigned)latency[samples * 99 / 100] : 0,
+           samples ? (unsigned)latency[samples - 1] : 0, (unsigned)samples, BENCH_MESSAGES, (unsigned)rx->applied);
+    free(latency);
+}
+
+// BENCH_BURST messages per poll: HTTP pipelines them, UDP keeps them in its window
+static void run_burst(control_transport_t *t, bench_rx_t *rx)
+{
+    uint8_t payload[CONTROL_MSG_BINARY_MAX];
+    control_transport_stats_t before, after;
+    control_transport_get_stats(t, &before);
+    uint32_t applied_before = rx->applied;
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_MESSAGES; i++) {
+        esp_err_t err = control_transport_send(t, payload, encode_control(i, payload, sizeof(payload)));
+        if (err == ESP_OK && (i + 1) % BENCH_BURST == 0) err = control_transport_poll(t, BENCH_POLL_MS);
+        if (err != ESP_OK) ESP_LOGW(TAG, "%s: message %d: %s", t->name, i, esp_err_to_name(err));
+    }
+    control_transport_poll(t, BENCH_POLL_MS);
+    double elapsed_s = (esp_timer_get_time() - start) / 1e6;
+
+    control_transport_get_stats(t, &after);
+    uint32_t delivered = after.delivered - before.delivered;
+    uint64_t total_us = after.latency_total_us - before.latency_total_us;
+    printf("%-8s burst%-2d %8.0f msg/s  avg %6u us  delivered %u/%d  failed %u  applied %u\n",
+           t->name, BENCH_BURST, delivered / elapsed_s, delivered ? (unsigned)(total_us / delivered) : 0,
+           (unsigned)delivered, BENCH_MESSAGES, (unsigned)(after.failed - before.failed),
+           (unsigned)(rx->applied - applied_before));
+}
+
+// Returns the number of failed checks
+static int run(control_transport_t *t, bench_rx_t *rx)
+{
+    int failures = 0;
+    run_closed_loop(t, rx);
+    run_burst(t, rx);
+
+    // Every transport must leave the receiver on the newest state, having rejected nothing
+    char last[sizeof(rx->state.message)];
+    snprintf(last, sizeof(last), "Message #%d", BENCH_MESSAGES - 1);
+    if (strcmp(rx->state.message, last) != 0) {
+        ESP_LOGE(TAG, "%s: receiver ended on '%s'", t->name, rx->state.message);
+        failures++;
+    }
+    if (rx->rejected != 0) {
+        ESP_LOGE(TAG, "%s: receiver rejected %u payloads", t->name, (unsigned)rx->rejected);
+        failures++;
+    }
+    control_transport_close(t);
+    return failures;
+}
+
+// udp_control over a link losing BENCH_LOSS_PCT% of the datagrams both ways
+// (lossy_net.c): retransmits must still leave the receiver on the newest state
+static int run_lossy(control_transport_t *t, bench_rx_t *rx)
+{
+    int failures = 0;
+    uint8_t payload[CONTROL_MSG_BINARY_MAX];
+    uint32_t applied_before = rx->applied, rejected_before = rx->rejected;
+    uint32_t dropped_before = lossy_net_dropped();
+    control_transport_stats_t st;
+
+    lossy_net_set_loss(BENCH_LOSS_PCT);
+    for (int i = 0; i < BENCH_LOSSY_MESSAGES; i++) {
+        control_transport_send(t, payload, encode_control(i, payload, sizeof(payload)));
+        control_transport_poll(t, 2);
+    }
+    int64_t end = esp_timer_get_time() + 10 * 1000000LL;
+    do {
+        control_transport_poll(t, 100);
+        control_transport_get_stats(t, &st);
+    } while (st.in_flight > 0 && esp_timer_get_time() < end);
+    lossy_net_set_loss(0);
+
+    printf("%-8s loss%-2d  delivered %u/%d  failed %u  applied %u  datagrams dropped %u\n",
+           t->name, BENCH_LOSS_PCT, (unsigned)st.delivered, BENCH_LOSSY_MESSAGES, (unsigned)st.failed,
+           (unsigned)(rx->applied - applied_before), (unsigned)(lossy_net_dropped() - dropped_before));
+
+    char last[sizeof(rx->state.message)];
+    snprintf(last, sizeof(last), "Message #%d", BENCH_LOSSY_MESSAGES - 1);
+    if (st.in_flight != 0 || strcmp(rx->state.message, last) != 0 || rx->rejected != rejected_before) {
+        ESP_LOGE(TAG, "%s loss: receiver on '%s', %u in flight", t->name, rx->state.message,
+                 (unsigned)st.in_flight);
+        failures++;
+    }
+    if (lossy_net_dropped() == dropped_before) {
+        ESP_LOGE(TAG, "%s loss: no datagram was dropped", t->name);
+        failures++;
+    }
+    control_transport_close(t);
+    return failures;
+}
+
+static esp_err_t send_state(control_transport_t *t, const char *message)
+{
+    control_data_t data = { .toggle = true };
+    snprintf(data.message, sizeof(data.message), "%s", message);
+    uint8_t payload[CONTROL_MSG_BINARY_MAX];
+    esp_err_t err = control_transport_send(t, payload, control_msg_encode_binary(&data, payload, sizeof(payload)));
+    return err == ESP_OK ? control_transport_poll(t, BENCH_POLL_MS) : err;
+}
+
+// A frame of a closed sender's session, delayed in the network until a new
+// sender has taken over, must not be applied
+static int run_stale_session(bench_rx_t *rx)
+{
+    control_transport_t *t = NULL;
+    uint8_t stale[64];
+    size_t stale_len = 0;
+
+    if (control_transport_udp_open(BENCH_HOST, BENCH_UDP_PORT, &t) == ESP_OK) {
+        control_data_t data = { .toggle = true };
+        snprintf(data.message, sizeof(data.message), "Old session");
+        uint8_t payload[CONTROL_MSG_BINARY_MAX];
+        control_transport_send(t, payload, control_msg_encode_binary(&data, payload, sizeof(payload)));
+        stale_len = lossy_net_last_sent(stale, sizeof(stale));
+        control_transport_poll(t, BENCH_POLL_MS);
+        control_transport_close(t);
+    }
+    if (stale_len == 0 || control_transport_udp_open(BENCH_HOST, BENCH_UDP_PORT, &t) != ESP_OK) {
+        ESP_LOGE(TAG, "stale session: setup failed");
+        return 1;
+    }
+
+    int failures = 0;
+    send_state(t, "New session");
+    uint32_t applied = rx->applied;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in to = { .sin_family = AF_INET, .sin_port = htons(BENCH_UDP_PORT) };
+    to.sin_addr.s_addr = inet_addr(BENCH_HOST);
+    sendto(sock, stale, stale_len, 0, (struct sockaddr *)&to, sizeof(to));
+    close(sock);
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    if (strcmp(rx->state.message, "New session") != 0 || rx->applied != applied) {
+        ESP_LOGE(TAG, "stale session: receiver on '%s' after the old frame", rx->state.message);
+        failures++;
+    }
+    // The challenge the stale frame drew must not get in the way of the live session
+    send_state(t, "New session, 2");
+    if (strcmp(rx->state.message, "New session, 2") != 0) {
+        ESP_LOGE(TAG, "stale session: live sender not applied, receiver on '%s'", rx->state.message);
+        failures++;
+    }
+    printf("udp      stale session frame %s\n", failures ? "APPLIED" : "ignored");
+    control_transport_close(t);
+    return failures;
+}
+
+// The largest JSON message (every byte escaped) must cross the HTTP transport whole
+static int run_json_largest(void)
+{
+    control_transport_t *t = NULL;
+    if (control_transport_http_open(BENCH_HOST, BENCH_HTTP_PORT, "/control/json",
+                                    CONTROL_TRANSPORT_JSON, &t) != ESP_OK) {
+        ESP_LOGE(TAG, "http json: setup failed");
+        return 1;
+    }
+    control_data_t data = { .toggle = false };
+    memset(data.message, 0x01, sizeof(data.message) - 1);
+    char json[CONTROL_MSG_JSON_MAX];
+    size_t len = control_msg_encode_json(&data, json, sizeof(json));
+    uint32_t applied = s_http_rx.applied;
+
+    esp_err_t err = len ? control_transport_send(t, json, len) : ESP_ERR_INVALID_SIZE;
+    if (err == ESP_OK) err = control_transport_poll(t, BENCH_POLL_MS);
+    bool ok = err == ESP_OK && s_http_rx.applied == applied + 1 &&
+              strcmp(s_http_rx.state.message, data.message) == 0;
+    printf("http json: largest message (%u bytes) %s\n", (unsigned)len,
+           ok ? "delivered" : esp_err_to_name(err == ESP_OK ? ESP_FAIL : err));
+    control_transport_close(t);
+    return ok ? 0 : 1;
+}
+
+// One POST on its own connection; the response status, or -1
+static int post_raw(const char *path, const char *body, size_t len)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(BENCH_HTTP_PORT) };
+    addr.sin_addr.s_addr = inet_addr(BENCH_HOST);
+    if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        if (sock >= 0) close(sock);
+        return -1;
+    }
+    char head[160];
+    int n = snprintf(head, sizeof(head), "POST %s HTTP/1.1\r\nHost: bench\r\nContent-Type: application/json\r\n"
+                     "Content-Length: %u\r\nConnection: close\r\n\r\n", path, (unsigned)len);
+    int status = -1;
+    char resp[64];
+    // The server may answer a rejected body before reading all of it
+    if (send(sock, head, n, 0) == n && send(sock, body, len, MSG_NOSIGNAL) >= 0 &&
+        recv(sock, resp, sizeof(resp) - 1, 0) > 12) {
+        status = atoi(resp + 9);
+    }
+    close(sock);
+    return status;
+}
+
+// Bodies past CONTROL_CHANNEL_MAX_BODY through the streaming path: parsed as they arrive
+static int run_json_stream(void)
+{
+    static char body[4096];
+    int failures = 0;
+    uint32_t applied = s_http_rx.applied;
+
+    // A valid document, mostly whitespace
+    size_t len = snprintf(body, sizeof(body), "{\"toggle\":true,%*s\"message\":\"Streamed\"}", 3000, "");
+    int status = post_raw("/control/stream", body, len);
+    bool ok = status == 200 && s_http_rx.applied == applied + 1 && strcmp(s_http_rx.state.message, "Streamed") == 0;
+    printf("http stream: %u-byte document answered %d%s\n", (unsigned)len, status, ok ? "" : ", not applied");
+    failures += !ok;
+
+    // Broken at the start: rejected, never applied
+    len = snprintf(body, sizeof(body), "{\"toggle\":tru%*s}", 3000, "");
+    status = post_raw("/control/stream", body, len);
+    ok = status == 400 && s_http_rx.applied == applied + 1;
+    printf("http stream: %u-byte broken document answered %d\n", (unsigned)len, status);
+    failures += !ok;
+    return failures;
+}
+
+static httpd_handle_t start_http_receiver(void)
+{
+    httpd_handle_t server = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = BENCH_HTTP_PORT;
+    if (httpd_start(&server, &config) != ESP_OK) return NULL;
+
+    const httpd_uri_t control_uri = {
+        .uri = "/control",
+        .method = HTTP_POST,
+        .handler = control_post_handler,
+    };
+    httpd_register_uri_handler(server, &control_uri);
+    const httpd_uri_t control_json_uri = {
+        .uri = "/control/json",
+        .method = HTTP_POST,
+        .handler = control_json_post_handler,
+    };
+    httpd_register_uri_handler(server, &control_json_uri);
+    const httpd_uri_t control_stream_uri = {
+        .uri = "/control/stream",
+        .method = HTTP_POST,
+        .handler = control_stream_post_handler,
+    };
+    httpd_register_uri_handler(server, &control_stream_uri);
+    return server;
+}
+
+void app_main(void)
+{
+    control_transport_t *t = NULL;
+    int failures = 0;
+
+    printf("%d messages per run\n", BENCH_MESSAGES);
+
+    if (control_transport_loopback_open(CONTROL_TRANSPORT_BINARY, bench_recv, &s_loopback_rx, &t) == ESP_OK) {
+        failures += run(t, &s_loopback_rx);
+    } else {
+        ESP_LOGE(TAG, "loopback: setup failed");
+        failures++;
+    }
+
+    if (control_transport_udp_listen(BENCH_UDP_PORT, bench_recv, &s_udp_rx) == ESP_OK &&
+        control_transport_udp_open(BENCH_HOST, BENCH_UDP_PORT, &t) == ESP_OK) {
+        failures += run(t, &s_udp_rx);
+        if (control_transport_udp_open(BENCH_HOST, BENCH_UDP_PORT, &t) == ESP_OK) {
+            failures += run_lossy(t, &s_udp_rx);
+        } else {
+            failures++;
+        }
+        failures += run_stale_session(&s_udp_rx);
+    } else {
+        ESP_LOGE(TAG, "udp: setup failed");
+        failures++;
+    }
+
+    // Binary payloads over HTTP too, so the runs differ only in transport
+    httpd_handle_t server = start_http_receiver();
+    if (server && control_transport_http_open(BENCH_HOST, BENCH_HTTP_PORT, "/control",
+                                              CONTROL_TRANSPORT_BINARY, &t) == ESP_OK) {
+        failures += run(t, &s_http_rx);
+        failures += run_json_largest();
+        failures += run_json_stream();
+    } else {
+        ESP_LOGE(TAG, "http: setup failed");
+        failures++;
+    }
+    if (server) httpd_stop(server);
+
+    failures += control_channel_bench_run();
+    failures += outbox_bench_run();
+    failures += json_bench_run();
+    failures += codec_bench_run();
+    failures += fanout_bench_run();
+    failures += reconnect_bench_run();
+    failures += log_ring_bench_run();
+    failures += state_store_bench_run();
+    failures += actuator_bench_run();
+    failures += file_cache_bench_run();
+    failures += json_stream_bench_run();
+    failures += asset_fs_bench_run();
+    // Before uri_router_bench adds its routes to /metrics and /workers
+    failures += http_load_bench_run();
+    failures += uri_router_bench_run();
+
+    // Non-zero exit status on any failed check, so a script running the bench can tell
+    printf("%d check(s) failed\n", failures);
+    fflush(stdout);
+    if (getenv("HTTP_LOAD_SERVE")) {
+        for (;;) vTaskDelay(portMAX_DELAY);     // http_load_bench left its server running
+    }
+    exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,154 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <control_msg.h>
+#include "codec_bench.h"
+
+#define CODEC_FUZZ_ROUNDS   20000
+#define CODEC_BENCH_ROUNDS  100000
+
+// Fixed seed, so a failure reproduces
+static uint32_t s_rng = 0x12345678;
+
+static uint32_t next_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Pieces that exercise escaping and multi-byte UTF-8 as well as plain text
+static const char *const s_pieces[] = {
+    "a", "Z", "7", " ", "#", "\"", "\\", "/", "\n", "\t", "\x01", "\x1f", "\x7f", "\xc3\xa9", "\xe2\x82\xac",
+    "\xf0\x9f\x98\x80",
+};
+
+static void random_msg(control_data_t *msg)
+{
+    memset(msg, 0, sizeof(*msg));
+    msg->toggle = next_rand() & 1;
+    size_t target = next_rand() % sizeof(msg->message);
+    size_t len = 0;
+    while (len < target) {
+        const char *piece = s_pieces[next_rand() % (sizeof(s_pieces) / sizeof(s_pieces[0]))];
+        size_t n = strlen(piece);
+        if (len + n >= sizeof(msg->message)) break;
+        memcpy(msg->message + len, piece, n);
+        len += n;
+    }
+}
+
+static bool same(const control_data_t *a, const control_data_t *b)
+{
+    return a->toggle == b->toggle && strcmp(a->message, b->message) == 0;
+}
+
+// A decoder may reject damaged input but must never accept something it cannot encode again
+static bool check_mutated(uint8_t *buf, size_t len, bool json)
+{
+    size_t n = len ? next_rand() % (len + 1) : 0;      // truncate
+    for (int flips = next_rand() % 4; flips > 0 && n > 0; flips--) {
+        buf[next_rand() % n] ^= 1u << (next_rand() % 8);
+    }
+
+    control_data_t out, again;
+    uint8_t enc[CONTROL_MSG_JSON_MAX];
+    if (json) {
+        if (control_msg_decode_json((const char *)buf, n, &out) != ESP_OK) return true;
+        size_t m = control_msg_encode_json(&out, (char *)enc, sizeof(enc));
+        return m > 0 && control_msg_decode_json((const char *)enc, m, &again) == ESP_OK && same(&out, &again);
+    }
+    if (control_msg_decode_binary(buf, n, &out) != ESP_OK) return true;
+    size_t m = control_msg_encode_binary(&out, enc, sizeof(enc));
+    return m > 0 && control_msg_decode_binary(enc, m, &again) == ESP_OK && same(&out, &again);
+}
+
+static int fuzz(void)
+{
+    int failures = 0;
+    control_data_t msg, out;
+    uint8_t bin[CONTROL_MSG_BINARY_MAX];
+    char json[CONTROL_MSG_JSON_MAX];
+
+    for (int i = 0; i < CODEC_FUZZ_ROUNDS; i++) {
+        random_msg(&msg);
+
+        size_t len = control_msg_encode_binary(&msg, bin, sizeof(bin));
+        if (len == 0 || control_msg_decode_binary(bin, len, &out) != ESP_OK || !same(&msg, &out)) {
+            printf("codec: binary round trip %d failed\n", i);
+            failures++;
+        }
+        if (!check_mutated(bin, len, false)) {
+            printf("codec: mutated binary %d re-encodes differently\n", i);
+            failures++;
+        }
+
+        len = control_msg_encode_json(&msg, json, sizeof(json));
+        if (len == 0 || control_msg_decode_json(json, len, &out) != ESP_OK || !same(&msg, &out)) {
+            printf("codec: json round trip %d failed: %.*s\n", i, (int)len, json);
+            failures++;
+        }
+        if (!check_mutated((uint8_t *)json, len, true)) {
+            printf("codec: mutated json %d re-encodes differently\n", i);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// Every byte of the longest message escaped as \u00XX: the largest JSON encoding
+static int check_largest(void)
+{
+    control_data_t msg = { .toggle = false }, out;
+    memset(msg.message, 0x01, sizeof(msg.message) - 1);
+    char json[CONTROL_MSG_JSON_MAX];
+    size_t len = control_msg_encode_json(&msg, json, sizeof(json));
+    if (len == 0 || control_msg_decode_json(json, len, &out) != ESP_OK || !same(&msg, &out)) {
+        printf("codec: largest json message does not fit CONTROL_MSG_JSON_MAX (%u)\n", (unsigned)sizeof(json));
+        return 1;
+    }
+    return 0;
+}
+
+int codec_bench_run(void)
+{
+    int failures = fuzz();
+    printf("codec fuzz: %d round trips per format, %d failures\n", CODEC_FUZZ_ROUNDS, failures);
+    failures += check_largest();
+
+    control_data_t msg = { .toggle = true }, out;
+    snprintf(msg.message, sizeof(msg.message), "Message #%d", 1999);
+    uint8_t bin[CONTROL_MSG_BINARY_MAX];
+    char json[CONTROL_MSG_JSON_MAX];
+    size_t bin_len = 0, json_len = 0;
+    int bad = 0;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < CODEC_BENCH_ROUNDS; i++) {
+        msg.toggle = i & 1;
+        bin_len = control_msg_encode_binary(&msg, bin, sizeof(bin));
+    }
+    int64_t t1 = esp_timer_get_time();
+    for (int i = 0; i < CODEC_BENCH_ROUNDS; i++) {
+        bad += control_msg_decode_binary(bin, bin_len, &out) != ESP_OK;
+    }
+    int64_t t2 = esp_timer_get_time();
+    for (int i = 0; i < CODEC_BENCH_ROUNDS; i++) {
+        msg.toggle = i & 1;
+        json_len = control_msg_encode_json(&msg, json, sizeof(json));
+    }
+    int64_t t3 = esp_timer_get_time();
+    for (int i = 0; i < CODEC_BENCH_ROUNDS; i++) {
+        bad += control_msg_decode_json(json, json_len, &out) != ESP_OK;
+    }
+    int64_t t4 = esp_timer_get_time();
+
+    printf("codec binary (%3u bytes)  encode %6.0f ns/msg  decode %6.0f ns/msg\n", (unsigned)bin_len,
+           (t1 - t0) * 1000.0 / CODEC_BENCH_ROUNDS, (t2 - t1) * 1000.0 / CODEC_BENCH_ROUNDS);
+    printf("codec json   (%3u bytes)  encode %6.0f ns/msg  decode %6.0f ns/msg%s\n", (unsigned)json_len,
+           (t3 - t2) * 1000.0 / CODEC_BENCH_ROUNDS, (t4 - t3) * 1000.0 / CODEC_BENCH_ROUNDS,
+           bad ? "  (decode failed)" : "");
+    return failures + (bad != 0);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief Round-trip fuzz the control_msg codecs, check the largest JSON
+ *        message fits CONTROL_MSG_JSON_MAX, then print encode/decode ns per message.
+ *
+ * @return number of failed checks
+ */
+int codec_bench_run(void);
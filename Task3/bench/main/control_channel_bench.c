@@ -0,0 +1,204 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <control_channel.h>
+#include "control_channel_bench.h"
+
+#define CC_HOST             "127.0.0.1"
+#define CC_PORT             8085        // canned responses
+#define CC_SILENT_PORT      8086        // listens, never accepts
+#define CC_TIMEOUT_MS       300
+
+typedef struct {
+    const char *name;
+    const char *reply;
+    bool ok;
+} reply_case_t;
+
+static const reply_case_t s_cases[] = {
+    { "200 with body",      "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok", true },
+    { "204 keep-alive",     "HTTP/1.1 204 No Content\r\ncontent-length:0\r\nConnection: keep-alive\r\n\r\n", true },
+    { "no reason phrase",   "HTTP/1.1 200\r\nContent-Length: 0\r\n\r\n", true },
+    { "1.0 close",          "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n", true },
+    { "status not digits",  "HTTP/1.1 2x0 OK\r\nContent-Length: 0\r\n\r\n", false },
+    { "short status line",  "HTTP/1.1 20\r\nContent-Length: 0\r\n\r\n", false },
+    { "not HTTP",           "HTTX/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", false },
+    { "negative length",    "HTTP/1.1 200 OK\r\nContent-Length: -1\r\n\r\n", false },
+    { "length trailer",     "HTTP/1.1 200 OK\r\nContent-Length: 5x\r\n\r\nhello", false },
+    { "empty length",       "HTTP/1.1 200 OK\r\nContent-Length:\r\n\r\n", false },
+    { "huge length",        "HTTP/1.1 200 OK\r\nContent-Length: 99999999999\r\n\r\n", false },
+    { "two lengths",        "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nContent-Length: 3\r\n\r\nabc", false },
+    { "line without colon", "HTTP/1.1 200 OK\r\nX-Broken\r\nContent-Length: 0\r\n\r\n", false },
+    { "bare LF",            "HTTP/1.1 200 OK\nContent-Length: 0\r\n\r\n", false },
+    { "empty header",       "\r\n\r\n", false },
+    { "chunked",            "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n", false },
+};
+
+// Longer than the channel's receive buffer without ever ending the header
+static char s_oversized[700];
+
+static const char *volatile s_reply;   // NULL: read the request, then close without answering
+static volatile int s_listen_fd = -1;
+static volatile bool s_server_done;
+
+static int listen_on(uint16_t port, int backlog)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    addr.sin_addr.s_addr = inet_addr(CC_HOST);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, backlog) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Answers every read with s_reply; one request per read is enough at pipeline depth 1
+static void server_task(void *arg)
+{
+    char buf[512];
+    for (;;) {
+        int fd = accept(s_listen_fd, NULL, NULL);
+        if (fd < 0) break;
+        const char *reply;
+        while (recv(fd, buf, sizeof(buf), 0) > 0 && (reply = s_reply) != NULL) {
+            send(fd, reply, strlen(reply), 0);
+        }
+        close(fd);
+    }
+    s_server_done = true;
+    vTaskDelete(NULL);
+}
+
+static control_channel_t *open_channel(uint16_t port, size_t depth)
+{
+    control_channel_config_t cfg = CONTROL_CHANNEL_DEFAULT_CONFIG();
+    cfg.host = CC_HOST;
+    cfg.port = port;
+    cfg.pipeline_depth = depth;
+    cfg.timeout_ms = CC_TIMEOUT_MS;
+    control_channel_t *ch = NULL;
+    return control_channel_open(&cfg, &ch) == ESP_OK ? ch : NULL;
+}
+
+// Two requests, so a well-formed body is consumed before the second response is read
+static esp_err_t exchange(const char *reply)
+{
+    s_reply = reply;
+    control_channel_t *ch = open_channel(CC_PORT, 1);
+    if (!ch) return ESP_ERR_NO_MEM;
+    esp_err_t err = control_channel_send(ch, "{}", 2);
+    if (err == ESP_OK) err = control_channel_send(ch, "{}", 2);
+    if (err == ESP_OK) err = control_channel_flush(ch);
+    control_channel_close(ch);
+    return err;
+}
+
+static int run_replies(void)
+{
+    int failures = 0;
+    size_t n = sizeof(s_cases) / sizeof(s_cases[0]);
+    for (size_t i = 0; i < n; i++) {
+        esp_err_t err = exchange(s_cases[i].reply);
+        if ((err == ESP_OK) != s_cases[i].ok) {
+            printf("control_channel: '%s' gave %s\n", s_cases[i].name, esp_err_to_name(err));
+            failures++;
+        }
+    }
+
+    memcpy(s_oversized, "HTTP/1.1 200 OK\r\nX-Pad: ", 24);
+    memset(s_oversized + 24, 'a', sizeof(s_oversized) - 25);
+    if (exchange(s_oversized) == ESP_OK) {
+        printf("control_channel: unterminated oversized header accepted\n");
+        failures++;
+    }
+    printf("control_channel: %d response cases, %d failed\n", (int)n + 1, failures);
+    return failures;
+}
+
+// A receiver that drops every connection: the requests stay queued and must be reported
+static int run_dropped(void)
+{
+    s_reply = NULL;
+    control_channel_t *ch = open_channel(CC_PORT, 4);
+    if (!ch) return 1;
+    for (int i = 0; i < 3; i++) control_channel_send(ch, "{}", 2);
+    esp_err_t err = control_channel_poll(ch, CC_TIMEOUT_MS);
+
+    control_channel_stats_t st;
+    control_channel_get_stats(ch, &st);
+    control_channel_close(ch);
+    if (err == ESP_OK || st.in_flight != 3) {
+        printf("control_channel: after drops poll gave %s, in_flight %u (3 queued)\n",
+               esp_err_to_name(err), (unsigned)st.in_flight);
+        return 1;
+    }
+    return 0;
+}
+
+// Fill the accept backlog of a socket nobody accepts on; further SYNs go unanswered
+static int run_connect_timeout(void)
+{
+    int lfd = listen_on(CC_SILENT_PORT, 0);
+    if (lfd < 0) {
+        printf("control_channel: cannot listen on %d\n", CC_SILENT_PORT);
+        return 1;
+    }
+    int fillers[4];
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(CC_SILENT_PORT) };
+    addr.sin_addr.s_addr = inet_addr(CC_HOST);
+    for (int i = 0; i < 4; i++) {
+        fillers[i] = socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(fillers[i], F_SETFL, O_NONBLOCK);
+        connect(fillers[i], (struct sockaddr *)&addr, sizeof(addr));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    int failures = 0;
+    control_channel_t *ch = open_channel(CC_SILENT_PORT, 1);
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = ch ? control_channel_send(ch, "{}", 2) : ESP_ERR_NO_MEM;
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    printf("control_channel: connect to a full backlog: %s after %u ms (timeout %d ms)\n",
+           esp_err_to_name(err), (unsigned)elapsed_ms, CC_TIMEOUT_MS);
+    // One connect attempt per send(); allow for scheduling slack
+    if (err != ESP_ERR_TIMEOUT || elapsed_ms > 3 * CC_TIMEOUT_MS) failures++;
+
+    control_channel_close(ch);
+    for (int i = 0; i < 4; i++) close(fillers[i]);
+    close(lfd);
+    return failures;
+}
+
+int control_channel_bench_run(void)
+{
+    s_listen_fd = listen_on(CC_PORT, 4);
+    if (s_listen_fd < 0) {
+        printf("control_channel: cannot listen on %d\n", CC_PORT);
+        return 1;
+    }
+    s_server_done = false;
+    xTaskCreate(server_task, "cc_server", 4096, NULL, 5, NULL);
+
+    int failures = 0;
+    failures += run_replies();
+    failures += run_dropped();
+
+    shutdown(s_listen_fd, SHUT_RDWR);
+    while (!s_server_done) vTaskDelay(1);
+    close(s_listen_fd);
+
+    failures += run_connect_timeout();
+    return failures;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief control_channel against a raw TCP receiver: well-formed and
+ *        malformed response headers, the queue depth reported after the
+ *        connection drops, and connect() to a receiver that never answers
+ *        the SYN returning within timeout_ms.
+ *
+ * @return number of failed checks
+ */
+int control_channel_bench_run(void);
@@ -0,0 +1,219 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <control_fanout.h>
+#include <control_outbox.h>
+#include "fanout_bench.h"
+
+#define FANOUT_BENCH_UPDATES    50
+#define FANOUT_BENCH_RTT_MS     10      // stand-in receiver: time to apply and answer
+#define FANOUT_BENCH_SLOW_MS    200     // the slow receiver in the last run
+#define FANOUT_BENCH_WAIT_MS    2000    // per update, for every peer to confirm
+
+// Stand-in receivers: loopback transports that take rtt_ms to apply a message
+typedef struct {
+    uint32_t rtt_ms;
+    uint32_t applied;
+    control_data_t state;
+} stand_in_t;
+
+static stand_in_t s_peers[CONTROL_FANOUT_MAX_PEERS];
+
+static esp_err_t stand_in_recv(const void *payload, size_t len, void *ctx)
+{
+    stand_in_t *peer = ctx;
+    vTaskDelay(pdMS_TO_TICKS(peer->rtt_ms));
+    if (control_msg_decode_binary(payload, len, &peer->state) != ESP_OK) return ESP_ERR_INVALID_ARG;
+    peer->applied++;
+    return ESP_OK;
+}
+
+// control_fanout_open_fn_t: the last MAC byte picks the stand-in
+static esp_err_t open_stand_in(const char *host, const uint8_t mac[6], void *ctx, control_transport_t **out)
+{
+    return control_transport_loopback_open(CONTROL_TRANSPORT_BINARY, stand_in_recv, &s_peers[mac[5]], out);
+}
+
+static void peer_mac(size_t i, uint8_t mac[6])
+{
+    const uint8_t base[6] = { 0x02, 0, 0, 0, 0, 0 };
+    memcpy(mac, base, 6);
+    mac[5] = i;
+}
+
+static void add_peers(size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t mac[6];
+        peer_mac(i, mac);
+        control_fanout_station_join(mac);
+        control_fanout_station_address(mac, 0x0204a8c0 + (i << 24));    // 192.168.4.2 + i
+    }
+}
+
+static void remove_peers(size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t mac[6];
+        peer_mac(i, mac);
+        control_fanout_station_leave(mac);
+    }
+    vTaskDelay(pdMS_TO_TICKS(FANOUT_BENCH_SLOW_MS + 50));     // outbox tasks finish and close
+}
+
+// Each update waits until every peer confirmed it, so the latencies do not overlap
+static void run_updates(int *round, control_fanout_stats_t *before, control_fanout_stats_t *after)
+{
+    control_data_t data = { 0 };
+    control_fanout_get_stats(before);
+    for (int i = 0; i < FANOUT_BENCH_UPDATES; i++, (*round)++) {
+        control_fanout_stats_t st;
+        control_fanout_get_stats(&st);
+        uint32_t complete = st.complete;
+
+        data.toggle = *round & 1;
+        snprintf(data.message, sizeof(data.message), "Update #%d", *round);
+        control_fanout_put("control", &data);
+
+        int64_t deadline = esp_timer_get_time() + FANOUT_BENCH_WAIT_MS * 1000LL;
+        do {
+            vTaskDelay(1);
+            control_fanout_get_stats(&st);
+        } while (st.complete == complete && esp_timer_get_time() < deadline);
+    }
+    control_fanout_get_stats(after);
+}
+
+// Every update reached every peer, and each peer ended on the last one
+static int check_run(const char *name, size_t n, int round, const control_fanout_stats_t *before,
+                     const control_fanout_stats_t *after)
+{
+    int failures = 0;
+    uint32_t complete = after->complete - before->complete;
+    if (complete != FANOUT_BENCH_UPDATES) {
+        printf("fanout %s: %u of %d updates reached every peer\n", name, (unsigned)complete, FANOUT_BENCH_UPDATES);
+        failures++;
+    }
+    char last[sizeof(((control_data_t *)0)->message)];
+    snprintf(last, sizeof(last), "Update #%d", round - 1);
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(s_peers[i].state.message, last) != 0) {
+            printf("fanout %s: peer %u ended on '%s', not '%s'\n", name, (unsigned)i, s_peers[i].state.message, last);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static volatile uint32_t s_single_delivered;
+
+static void on_single_delivered(const char *key, int64_t put_us, void *ctx)
+{
+    s_single_delivered++;
+}
+
+// The sender before the fan-out: one control_outbox to one receiver, put to confirmed
+static double single_outbox_ms(int round)
+{
+    control_transport_t *t = NULL;
+    control_outbox_t *ob = NULL;
+    control_outbox_config_t config = CONTROL_OUTBOX_DEFAULT_CONFIG();
+    config.name = "single";
+    config.min_interval_ms = 0;
+    config.on_delivered = on_single_delivered;
+    s_peers[0] = (stand_in_t) { .rtt_ms = FANOUT_BENCH_RTT_MS };
+    if (control_transport_loopback_open(CONTROL_TRANSPORT_BINARY, stand_in_recv, &s_peers[0], &t) != ESP_OK ||
+        control_outbox_create(&config, t, &ob) != ESP_OK) {
+        if (t) control_transport_close(t);
+        return -1;
+    }
+
+    control_data_t data = { 0 };
+    for (int i = 0; i < FANOUT_BENCH_UPDATES; i++, round++) {
+        uint32_t delivered = s_single_delivered;
+        data.toggle = round & 1;
+        snprintf(data.message, sizeof(data.message), "Update #%d", round);
+        control_outbox_put(ob, "control", &data);
+        int64_t deadline = esp_timer_get_time() + FANOUT_BENCH_WAIT_MS * 1000LL;
+        while (s_single_delivered == delivered && esp_timer_get_time() < deadline) vTaskDelay(1);
+    }
+    // Measured by the outbox itself, as the fan-out measures its updates
+    control_outbox_stats_t st;
+    control_outbox_get_stats(ob, &st);
+    control_outbox_delete(ob);
+    vTaskDelay(pdMS_TO_TICKS(FANOUT_BENCH_RTT_MS * 2));    // the task finishes and closes
+    return st.delivered == FANOUT_BENCH_UPDATES ? st.latency_total_us / 1000.0 / st.delivered : -1;
+}
+
+int fanout_bench_run(void)
+{
+    control_fanout_config_t config = CONTROL_FANOUT_DEFAULT_CONFIG();
+    config.open = open_stand_in;
+    config.outbox.min_interval_ms = 0;
+    if (control_fanout_init(&config) != ESP_OK) {
+        printf("fanout: init failed\n");
+        return 1;
+    }
+
+    int failures = 0;
+    int round = 0;
+    double single = single_outbox_ms(round);
+    round += FANOUT_BENCH_UPDATES;
+    printf("fanout baseline  one control_outbox, one receiver  avg %6.1f ms\n", single);
+    if (single < 0) failures++;
+
+    for (size_t n = 1; n <= CONTROL_FANOUT_MAX_PEERS; n++) {
+        for (size_t i = 0; i < n; i++) s_peers[i] = (stand_in_t) { .rtt_ms = FANOUT_BENCH_RTT_MS };
+        add_peers(n);
+        vTaskDelay(pdMS_TO_TICKS(FANOUT_BENCH_RTT_MS * 2));   // catch-up sends of the current state
+
+        control_fanout_stats_t before, after;
+        run_updates(&round, &before, &after);
+        remove_peers(n);
+
+        uint32_t complete = after.complete - before.complete;
+        double avg = complete ? (after.latency_total_us - before.latency_total_us) / 1000.0 / complete : 0;
+        printf("fanout %u peers  all-peers avg %6.1f ms  complete %u/%d\n", (unsigned)n, avg, (unsigned)complete,
+               FANOUT_BENCH_UPDATES);
+        failures += check_run("run", n, round, &before, &after);
+        // In parallel: n peers cost about what one receiver did, not n times as much
+        if (single > 0 && avg > 2 * single) {
+            printf("fanout %u peers: %.1f ms is over twice the one-receiver %.1f ms\n", (unsigned)n, avg, single);
+            failures++;
+        }
+    }
+
+    // One slow receiver: the others keep their own latency
+    size_t n = CONTROL_FANOUT_MAX_PEERS;
+    for (size_t i = 0; i < n; i++) {
+        s_peers[i] = (stand_in_t) { .rtt_ms = i == n - 1 ? FANOUT_BENCH_SLOW_MS : FANOUT_BENCH_RTT_MS };
+    }
+    add_peers(n);
+    vTaskDelay(pdMS_TO_TICKS(FANOUT_BENCH_SLOW_MS * 2));
+    control_fanout_stats_t before, after;
+    run_updates(&round, &before, &after);
+    for (size_t i = 0; i < n; i++) {
+        control_fanout_peer_info_t peer;
+        if (control_fanout_get_peer(i, &peer) != ESP_OK || !peer.outbox.delivered) {
+            printf("fanout slow run: peer %u delivered nothing\n", (unsigned)i);
+            failures++;
+            continue;
+        }
+        double avg = peer.outbox.latency_total_us / 1000.0 / peer.outbox.delivered;
+        printf("fanout slow run  peer %u (%3u ms)  avg %6.1f ms  delivered %u\n", (unsigned)i,
+               (unsigned)s_peers[i].rtt_ms, avg, (unsigned)peer.outbox.delivered);
+        if (s_peers[i].rtt_ms == FANOUT_BENCH_RTT_MS && avg > FANOUT_BENCH_SLOW_MS / 2) {
+            printf("fanout slow run: peer %u held up by the slow one\n", (unsigned)i);
+            failures++;
+        }
+    }
+    uint32_t complete = after.complete - before.complete;
+    printf("fanout slow run  all-peers avg %6.1f ms\n",
+           complete ? (after.latency_total_us - before.latency_total_us) / 1000.0 / complete : 0);
+    failures += check_run("slow run", n, round, &before, &after);
+    remove_peers(n);
+    return failures;
+}
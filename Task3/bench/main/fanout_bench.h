@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * @brief Time control_fanout updates reaching 1..CONTROL_FANOUT_MAX_PEERS stand-in
+ *        receivers, against the sender's path before the fan-out (one
+ *        control_outbox, one receiver), and with one slow receiver.
+ *        Fails if an update misses a peer, if n peers take over twice
+ *        the one-receiver time, or if the slow peer holds up the others.
+ *
+ * @return number of failed checks
+ */
+int fanout_bench_run(void);
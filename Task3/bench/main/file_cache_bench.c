@@ -0,0 +1,226 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <file_cache.h>
+#include "file_cache_bench.h"
+
+// Files live on the host filesystem; the linux target has no SPIFFS
+#define FC_DIR              "/tmp/file_cache_bench"
+#define FC_FILES            32
+#define FC_FILE_SIZE        2048
+#define FC_HOT_FILES        4           // requested 90% of the time
+#define FC_BUDGET           (8 * FC_FILE_SIZE)
+#define FC_MAX_ENTRY        (2 * FC_FILE_SIZE)
+#define FC_REQUESTS         20000
+#define FC_WRITES           500         // rewrites of the raced file
+
+static uint32_t s_rng = 0x9e3779b9;
+
+static uint32_t next_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void file_path(char *buf, size_t size, int i)
+{
+    snprintf(buf, size, FC_DIR "/f%02d.html", i);
+}
+
+static bool write_file(const char *path, size_t size, char fill)
+{
+    char buf[512];
+    memset(buf, fill, sizeof(buf));
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return false;
+    bool ok = true;
+    for (size_t done = 0; ok && done < size; ) {
+        size_t n = size - done < sizeof(buf) ? size - done : sizeof(buf);
+        ok = write(fd, buf, n) == (ssize_t)n;
+        done += n;
+    }
+    return close(fd) == 0 && ok;
+}
+
+// What web_static does with the bytes, reduced to touching each one
+static uint32_t consume(const uint8_t *data, size_t len)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < len; i++) sum += data[i];
+    return sum;
+}
+
+static uint32_t read_fd(int fd)
+{
+    uint8_t chunk[1024];
+    uint32_t sum = 0;
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) sum += consume(chunk, n);
+    return sum;
+}
+
+static int pick_file(void)
+{
+    if (next_rand() % 10 != 0) return next_rand() % FC_HOT_FILES;
+    return FC_HOT_FILES + next_rand() % (FC_FILES - FC_HOT_FILES);
+}
+
+// ns per request for the same request sequence, cached and straight from the filesystem
+static int run_mix(void)
+{
+    int failures = 0;
+    char path[64];
+    uint32_t sum_cached = 0, sum_plain = 0;
+    file_cache_stats_t before, after;
+    file_cache_get_stats(&before);
+
+    uint32_t seed = s_rng;
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < FC_REQUESTS; i++) {
+        file_path(path, sizeof(path), pick_file());
+        int fd;
+        const file_cache_entry_t *e = file_cache_acquire(path, &fd);
+        if (e) {
+            sum_cached += consume(file_cache_data(e), file_cache_size(e));
+            file_cache_release(e);
+        } else if (fd != -1) {
+            sum_cached += read_fd(fd);
+            close(fd);
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+    s_rng = seed;
+    for (int i = 0; i < FC_REQUESTS; i++) {
+        file_path(path, sizeof(path), pick_file());
+        int fd = open(path, O_RDONLY, 0);
+        if (fd == -1) continue;
+        sum_plain += read_fd(fd);
+        close(fd);
+    }
+    int64_t t2 = esp_timer_get_time();
+    file_cache_get_stats(&after);
+
+    uint32_t hits = after.hits - before.hits, misses = after.misses - before.misses;
+    printf("file_cache mix (%d files, %d hot, %u KB budget)  cached %6.0f ns/req  plain read %6.0f ns/req"
+           "  hits %u misses %u evictions %u\n",
+           FC_FILES, FC_HOT_FILES, (unsigned)(FC_BUDGET / 1024),
+           (t1 - t0) * 1000.0 / FC_REQUESTS, (t2 - t1) * 1000.0 / FC_REQUESTS,
+           (unsigned)hits, (unsigned)misses, (unsigned)(after.evictions - before.evictions));
+    if (sum_cached != sum_plain) {
+        printf("file_cache: cached bytes differ from the files\n");
+        failures++;
+    }
+    if (hits + misses != FC_REQUESTS || hits < FC_REQUESTS / 2) {
+        printf("file_cache: unexpected hit count %u\n", (unsigned)hits);
+        failures++;
+    }
+    return failures;
+}
+
+// Too large to cache: the caller gets the handle the cache opened, at offset 0
+static int check_uncacheable(void)
+{
+    const char *path = FC_DIR "/big.bin";
+    if (!write_file(path, FC_MAX_ENTRY + 1, 'B')) return 1;
+    int fd;
+    const file_cache_entry_t *e = file_cache_acquire(path, &fd);
+    if (e) {
+        file_cache_release(e);
+        printf("file_cache: oversized file was cached\n");
+        return 1;
+    }
+    uint32_t sum = fd != -1 ? read_fd(fd) : 0;
+    if (fd != -1) close(fd);
+    if (sum != (uint32_t)'B' * (FC_MAX_ENTRY + 1)) {
+        printf("file_cache: oversized file not handed back whole (fd %d)\n", fd);
+        return 1;
+    }
+    return 0;
+}
+
+static volatile bool s_stop;
+static const char *const s_raced = FC_DIR "/raced.html";
+
+static void touch(const char *path)
+{
+    int fd;
+    const file_cache_entry_t *e = file_cache_acquire(path, &fd);
+    if (e) file_cache_release(e);
+    if (fd != -1) close(fd);
+}
+
+// Keeps refilling the raced file while the writer replaces it: a budget's worth
+// of cold files between lookups evicts it every time
+static void reader_task(void *arg)
+{
+    char path[64];
+    for (int n = 0; !s_stop; n++) {
+        touch(s_raced);
+        for (int i = 0; i < FC_BUDGET / FC_FILE_SIZE; i++) {
+            file_path(path, sizeof(path), FC_HOT_FILES + (n + i) % (FC_FILES - FC_HOT_FILES));
+            touch(path);
+        }
+    }
+    *(volatile bool *)arg = true;
+    vTaskDelete(NULL);
+}
+
+static int run_race(void)
+{
+    int failures = 0;
+    volatile bool done[2] = { false, false };
+    char content[FC_FILE_SIZE];
+
+    s_stop = false;
+    xTaskCreate(reader_task, "fc_reader0", 4096, (void *)&done[0], 5, NULL);
+    xTaskCreate(reader_task, "fc_reader1", 4096, (void *)&done[1], 5, NULL);
+    for (int v = 0; v < FC_WRITES; v++) {
+        memset(content, 'a' + v % 26, sizeof(content));
+        if (file_cache_write_file(s_raced, content, sizeof(content)) != ESP_OK) {
+            failures++;
+            continue;
+        }
+        // Whatever the readers were doing, the next hit must be the new contents
+        int fd;
+        const file_cache_entry_t *e = file_cache_acquire(s_raced, &fd);
+        if (e) {
+            if (file_cache_size(e) != sizeof(content) || memcmp(file_cache_data(e), content, sizeof(content)) != 0) {
+                failures++;
+            }
+            file_cache_release(e);
+        }
+        if (fd != -1) close(fd);
+    }
+    s_stop = true;
+    while (!done[0] || !done[1]) vTaskDelay(1);
+
+    printf("file_cache race: %d writes against 2 readers, %d stale reads\n", FC_WRITES, failures);
+    return failures;
+}
+
+int file_cache_bench_run(void)
+{
+    mkdir(FC_DIR, 0755);
+    char path[64];
+    for (int i = 0; i < FC_FILES; i++) {
+        file_path(path, sizeof(path), i);
+        if (!write_file(path, FC_FILE_SIZE, 'A' + i % 26)) {
+            printf("file_cache: cannot create %s\n", path);
+            return 1;
+        }
+    }
+    if (file_cache_init(FC_BUDGET, FC_MAX_ENTRY) != ESP_OK) return 1;
+
+    int failures = run_mix();
+    failures += check_uncacheable();
+    failures += run_race();
+    return failures;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief file_cache against plain open/read/close for a hot/cold request mix,
+ *        then a writer racing readers to check no stale copy outlives a write.
+ *
+ * @return number of failed checks
+ */
+int file_cache_bench_run(void);
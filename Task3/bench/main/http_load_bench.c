@@ -0,0 +1,641 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <buf_pool.h>
+#include <control_msg.h>
+#include <control_transport.h>
+#include <httpd_workers.h>
+#include <json_stream.h>
+#include <metrics.h>
+#include <resp_writer.h>
+#include <web_static.h>
+#include "http_load_bench.h"
+
+#define HL_PORT             8081
+#define HL_DIR              "/tmp/http_load_bench"
+#define HL_CLIENTS          4           // concurrent keep-alive connections
+#define HL_WARMUP           100         // requests per client left out of the results
+#define HL_REQUESTS         2000        // measured requests per client
+#define HL_IO_TIMEOUT_S     5
+#define HL_RESP_MAX         (64 * 1024)
+#define HL_BATCH_VALUES     256         // Task2's DATA_BATCH_MAX
+#define HL_SEG_REQUESTS     1000        // per variant in the chunking run
+#define HL_SOAK_WARMUP      200         // per client, before the heap is sampled
+#define HL_SOAK_REQUESTS    20000       // per client
+#define HL_SOAK_SETTLE_MS   200         // closed sessions and workers going idle
+
+// The request mix, weighted like Task2's traffic plus the receiver's /control
+typedef struct {
+    const char *name;
+    const char *request;        // full request head and body
+    int weight;
+} hl_req_t;
+
+#define HL_CONTROL_BODY     "{\"toggle\":true,\"message\":\"bench\"}"
+
+static const hl_req_t s_mix[] = {
+    { "GET /index.html", "GET /index.html HTTP/1.1\r\nHost: bench\r\n\r\n", 4 },
+    { "GET /big.bin",    "GET /big.bin HTTP/1.1\r\nHost: bench\r\n\r\n", 1 },
+    { "GET /stats",      "GET /stats HTTP/1.1\r\nHost: bench\r\n\r\n", 4 },
+    { "GET /workers",    "GET /workers HTTP/1.1\r\nHost: bench\r\n\r\n", 1 },
+    { "GET /metrics",    "GET /metrics HTTP/1.1\r\nHost: bench\r\n\r\n", 1 },
+    { "POST /control",   "POST /control HTTP/1.1\r\nHost: bench\r\nContent-Type: application/json\r\n"
+                         "Content-Length: 33\r\n\r\n" HL_CONTROL_BODY, 4 },
+};
+#define HL_MIX_LEN          (sizeof(s_mix) / sizeof(s_mix[0]))
+
+_Static_assert(sizeof(HL_CONTROL_BODY) - 1 == 33, "Content-Length of the /control request");
+
+typedef struct {
+    uint32_t seed;
+    uint32_t *latency[HL_MIX_LEN];  // us, HL_REQUESTS slots each
+    size_t samples[HL_MIX_LEN];
+    uint32_t errors;
+    int64_t elapsed_us;
+    volatile bool done;
+} hl_client_t;
+
+static httpd_handle_t s_server;
+static control_data_t s_control;
+
+static uint32_t next_rand(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+// --- Server: the handlers Task2 and the receiver register, minus the hardware ---
+
+static esp_err_t control_recv(const void *payload, size_t len, void *ctx)
+{
+    return control_msg_decode_json(payload, len, &s_control);
+}
+
+static esp_err_t control_post_handler(httpd_req_t *req)
+{
+    return control_transport_http_serve(req, control_recv, NULL);
+}
+
+static esp_err_t static_file_handler(httpd_req_t *req)
+{
+    char filepath[128];
+    size_t uri_len = strcspn(req->uri, "?");
+    if (strstr(req->uri, "..") || uri_len + sizeof(HL_DIR) > sizeof(filepath)) {
+        httpd_resp_send_404(req);
+        return ESP_FAIL;
+    }
+    snprintf(filepath, sizeof(filepath), HL_DIR "%.*s", (int)uri_len, req->uri);
+    return web_static_send_file(req, filepath, NULL);
+}
+
+// Task2's /data batch, flushed per 256 bytes straight to httpd (as before
+// resp_writer) or through resp_writer
+static esp_err_t send_batch(httpd_req_t *req, bool coalesce)
+{
+    char chunk[256];
+    json_stream_t js;
+    resp_writer_t w;
+    if (coalesce) {
+        resp_writer_init(&w, req);
+        json_stream_init_flush(&js, chunk, sizeof(chunk), resp_writer_sink, &w);
+    } else {
+        json_stream_init_httpd(&js, chunk, sizeof(chunk), req);
+    }
+    json_stream_begin_object(&js);
+    json_stream_kv_uint(&js, "first", 1000);
+    json_stream_kv_uint(&js, "cursor", 1000 + HL_BATCH_VALUES - 1);
+    json_stream_kv_uint(&js, "last", 1000 + HL_BATCH_VALUES - 1);
+    json_stream_key(&js, "values");
+    json_stream_begin_array(&js);
+    for (uint32_t i = 0; i < HL_BATCH_VALUES; i++) json_stream_uint(&js, (i * 2654435761u) % 4096);
+    json_stream_end_array(&js);
+    json_stream_end_object(&js);
+    if (json_stream_finish(&js) != ESP_OK) {
+        if (coalesce) resp_writer_discard(&w);
+        httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+        return ESP_FAIL;
+    }
+    return coalesce ? resp_writer_finish(&w) : httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t batch_direct_handler(httpd_req_t *req)
+{
+    return send_batch(req, false);
+}
+
+static esp_err_t batch_coalesced_handler(httpd_req_t *req)
+{
+    return send_batch(req, true);
+}
+
+static bool write_file(const char *path, size_t size)
+{
+    char buf[1024];
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return false;
+    bool ok = true;
+    for (size_t done = 0; ok && done < size; done += sizeof(buf)) {
+        for (size_t i = 0; i < sizeof(buf); i++) buf[i] = 'a' + (done + i) % 26;
+        size_t n = size - done < sizeof(buf) ? size - done : sizeof(buf);
+        ok = write(fd, buf, n) == (ssize_t)n;
+    }
+    return close(fd) == 0 && ok;
+}
+
+static esp_err_t start_server(void)
+{
+    mkdir(HL_DIR, 0755);
+    // index.html fits the file cache, big.bin is streamed through buf_pool
+    if (!write_file(HL_DIR "/index.html", 4 * 1024) || !write_file(HL_DIR "/big.bin", 32 * 1024)) {
+        return ESP_FAIL;
+    }
+    esp_err_t err = buf_pool_init(4096, 4);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;
+    resp_writer_register_metrics();
+    httpd_workers_config_t wcfg = HTTPD_WORKERS_DEFAULT_CONFIG();
+    err = httpd_workers_start(&wcfg);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = HL_PORT;
+    config.ctrl_port = HL_PORT + 1;
+    config.max_open_sockets = HL_CLIENTS + 2;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    config.lru_purge_enable = true;
+    config.max_uri_handlers = 12;
+    if ((err = httpd_start(&s_server, &config)) != ESP_OK) return err;
+
+    // Registered as in Task2, so the per-route metrics and queueing are measured too
+    const struct { httpd_uri_t uri; httpd_workers_mode_t mode; } routes[] = {
+        { { .uri = "/stats", .method = HTTP_GET, .handler = web_static_stats_handler }, HTTPD_WORKERS_INLINE },
+        { { .uri = "/workers", .method = HTTP_GET, .handler = httpd_workers_stats_handler }, HTTPD_WORKERS_INLINE },
+        { { .uri = "/metrics", .method = HTTP_GET, .handler = metrics_prometheus_handler }, HTTPD_WORKERS_INLINE },
+        { { .uri = "/control", .method = HTTP_POST, .handler = control_post_handler }, HTTPD_WORKERS_INLINE },
+        { { .uri = "/batch/direct", .method = HTTP_GET, .handler = batch_direct_handler }, HTTPD_WORKERS_INLINE },
+        { { .uri = "/batch/coalesced", .method = HTTP_GET, .handler = batch_coalesced_handler }, HTTPD_WORKERS_INLINE },
+        { { .uri = "/*", .method = HTTP_GET, .handler = static_file_handler }, HTTPD_WORKERS_OFFLOAD },
+    };
+    for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++) {
+        if ((err = httpd_workers_register_uri(s_server, &routes[i].uri, routes[i].mode)) != ESP_OK) return err;
+    }
+    return ESP_OK;
+}
+
+// --- Client ---
+
+typedef struct {
+    int fd;
+    char buf[HL_RESP_MAX];
+    size_t len;
+} hl_conn_t;
+
+static int connect_server(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(HL_PORT) };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { .tv_sec = HL_IO_TIMEOUT_S };
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Read until @p c->buf holds @p want bytes
+static bool fill(hl_conn_t *c, size_t want)
+{
+    if (want > sizeof(c->buf)) return false;
+    while (c->len < want) {
+        ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        c->len += n;
+    }
+    return true;
+}
+
+static void consume(hl_conn_t *c, size_t n)
+{
+    memmove(c->buf, c->buf + n, c->len - n);
+    c->len -= n;
+}
+
+// Offset just past the next CRLF at or after @p from, 0 if not buffered yet
+static size_t find_line(hl_conn_t *c, size_t from, const char *delim)
+{
+    size_t dlen = strlen(delim);
+    for (size_t i = from; i + dlen <= c->len; i++) {
+        if (memcmp(c->buf + i, delim, dlen) == 0) return i + dlen;
+    }
+    return 0;
+}
+
+static bool fill_until(hl_conn_t *c, size_t from, const char *delim, size_t *end)
+{
+    while ((*end = find_line(c, from, delim)) == 0) {
+        if (!fill(c, c->len + 1)) return false;
+    }
+    return true;
+}
+
+// One response, Content-Length or chunked. Returns the status code, 0 on a broken response.
+// @p chunks (may be NULL) gets the number of body chunks, terminator excluded.
+static int read_response(hl_conn_t *c, int *chunks)
+{
+    if (chunks) *chunks = 0;
+    size_t head;
+    if (!fill_until(c, 0, "\r\n\r\n", &head)) return 0;
+    int status = 0;
+    if (sscanf(c->buf, "HTTP/1.%*d %d", &status) != 1) return 0;
+
+    long content_length = -1;
+    bool chunked = false;
+    for (size_t line = find_line(c, 0, "\r\n"); line < head - 2; line = find_line(c, line, "\r\n")) {
+        const char *l = c->buf + line;
+        if (strncasecmp(l, "Content-Length:", 15) == 0) content_length = strtol(l + 15, NULL, 10);
+        else if (strncasecmp(l, "Transfer-Encoding:", 18) == 0) chunked = strncasecmp(l + 18, " chunked", 8) == 0;
+    }
+    consume(c, head);
+
+    if (!chunked) {
+        size_t body = content_length > 0 ? (size_t)content_length : 0;
+        if (!fill(c, body)) return 0;
+        consume(c, body);
+        return status;
+    }
+    for (;;) {
+        size_t line;
+        if (!fill_until(c, 0, "\r\n", &line)) return 0;
+        size_t size = strtoul(c->buf, NULL, 16);
+        if (!fill(c, line + size + 2)) return 0;
+        consume(c, line + size + 2);
+        if (size == 0) return status;
+        if (chunks) (*chunks)++;
+    }
+}
+
+static int pick(uint32_t *seed)
+{
+    static int total;
+    if (total == 0) {
+        for (size_t i = 0; i < HL_MIX_LEN; i++) total += s_mix[i].weight;
+    }
+    int r = next_rand(seed) % total;
+    for (size_t i = 0; i < HL_MIX_LEN; i++) {
+        if ((r -= s_mix[i].weight) < 0) return i;
+    }
+    return 0;
+}
+
+// Back-to-back requests on one keep-alive connection, reconnecting after errors
+static void client_task(void *arg)
+{
+    hl_client_t *cl = arg;
+    hl_conn_t *c = malloc(sizeof(*c));
+    if (!c) {
+        cl->errors = HL_WARMUP + HL_REQUESTS;
+        cl->done = true;
+        vTaskDelete(NULL);
+        return;
+    }
+    c->fd = -1;
+    int64_t start = 0;
+
+    for (int n = 0; n < HL_WARMUP + HL_REQUESTS; n++) {
+        if (n == HL_WARMUP) start = esp_timer_get_time();
+        int r = pick(&cl->seed);
+        if (c->fd < 0) {
+            c->fd = connect_server();
+            c->len = 0;
+        }
+        int64_t t0 = esp_timer_get_time();
+        size_t len = strlen(s_mix[r].request);
+        int status = c->fd >= 0 && send(c->fd, s_mix[r].request, len, 0) == (ssize_t)len ? read_response(c, NULL) : 0;
+        uint32_t us = esp_timer_get_time() - t0;
+
+        if (status != 200) {
+            if (status == 0 && c->fd >= 0) {
+                close(c->fd);
+                c->fd = -1;
+            }
+            if (n >= HL_WARMUP) cl->errors++;
+            continue;
+        }
+        if (n >= HL_WARMUP) cl->latency[r][cl->samples[r]++] = us;
+    }
+    cl->elapsed_us = esp_timer_get_time() - start;
+    if (c->fd >= 0) close(c->fd);
+    free(c);
+    cl->done = true;
+    vTaskDelete(NULL);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void print_row(const char *name, uint32_t *lat, size_t n, double seconds)
+{
+    if (n == 0) {
+        printf("http_load %-16s      no samples\n", name);
+        return;
+    }
+    qsort(lat, n, sizeof(uint32_t), cmp_u32);
+    printf("http_load %-16s %8.0f req/s  p50 %6u us  p90 %6u us  p99 %6u us  max %6u us  n %u\n",
+           name, n / seconds, (unsigned)lat[n / 2], (unsigned)lat[n * 9 / 10],
+           (unsigned)lat[n * 99 / 100], (unsigned)lat[n - 1], (unsigned)n);
+}
+
+// Percentiles per request and overall; throughput over the slowest client's window
+static void report(hl_client_t *clients)
+{
+    static uint32_t all[HL_CLIENTS * HL_REQUESTS];
+    static uint32_t one[HL_CLIENTS * HL_REQUESTS];
+    size_t total = 0;
+    int64_t elapsed = 1;
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        if (clients[k].elapsed_us > elapsed) elapsed = clients[k].elapsed_us;
+    }
+    double seconds = elapsed / 1e6;
+
+    for (size_t r = 0; r < HL_MIX_LEN; r++) {
+        size_t n = 0;
+        for (int k = 0; k < HL_CLIENTS; k++) {
+            memcpy(one + n, clients[k].latency[r], clients[k].samples[r] * sizeof(uint32_t));
+            memcpy(all + total, clients[k].latency[r], clients[k].samples[r] * sizeof(uint32_t));
+            n += clients[k].samples[r];
+            total += clients[k].samples[r];
+        }
+        print_row(s_mix[r].name, one, n, seconds);
+    }
+    print_row("total", all, total, seconds);
+}
+
+typedef struct {
+    const char *name;
+    const char *request;
+} hl_seg_case_t;
+
+static const hl_seg_case_t s_seg_cases[] = {
+    { "/data batch, direct",    "GET /batch/direct HTTP/1.1\r\nHost: bench\r\n\r\n" },
+    { "/data batch, coalesced", "GET /batch/coalesced HTTP/1.1\r\nHost: bench\r\n\r\n" },
+    // web_static merges each part header with its data
+    { "multipart, 8 ranges",    "GET /big.bin HTTP/1.1\r\nHost: bench\r\nRange: bytes=0-99,1000-1099,"
+                                "2000-2099,3000-3099,4000-4099,5000-5099,6000-6099,7000-7099\r\n\r\n" },
+};
+
+// Chunks (each at least one send, so at least one TCP segment) per response and
+// sequential req/s, before and after coalescing
+static int run_segments(void)
+{
+    int failures = 0;
+    hl_conn_t *c = malloc(sizeof(*c));
+    if (!c) return 1;
+    c->fd = connect_server();
+    c->len = 0;
+    if (c->fd < 0) {
+        free(c);
+        return 1;
+    }
+    int chunks_per_case[sizeof(s_seg_cases) / sizeof(s_seg_cases[0])];
+    for (size_t k = 0; k < sizeof(s_seg_cases) / sizeof(s_seg_cases[0]); k++) {
+        const hl_seg_case_t *sc = &s_seg_cases[k];
+        size_t len = strlen(sc->request);
+        int chunks = 0, status = 0;
+        int64_t t0 = esp_timer_get_time();
+        int n;
+        for (n = 0; n < HL_SEG_REQUESTS; n++) {
+            if (send(c->fd, sc->request, len, 0) != (ssize_t)len) break;
+            status = read_response(c, &chunks);
+            if (status != 200 && status != 206) break;
+        }
+        int64_t t1 = esp_timer_get_time();
+        if (n != HL_SEG_REQUESTS) {
+            printf("http_load: %s failed after %d requests (status %d)\n", sc->name, n, status);
+            failures++;
+            break;
+        }
+        chunks_per_case[k] = chunks;
+        printf("http_load %-24s %3d chunks/response  %8.0f req/s\n", sc->name, chunks,
+               HL_SEG_REQUESTS / ((t1 - t0) / 1e6));
+    }
+    // The batch is about 1.2 KB: a chunk per 256 bytes before, one segment-sized chunk after
+    if (failures == 0 && chunks_per_case[1] >= chunks_per_case[0]) {
+        printf("http_load: resp_writer did not reduce the chunk count\n");
+        failures++;
+    }
+
+    // With the pool drained resp_writer must send unbuffered, not allocate from the heap
+    void *held[16];
+    size_t nheld = 0;
+    while (nheld < sizeof(held) / sizeof(held[0]) && (held[nheld] = buf_pool_try_get(0)) != NULL) nheld++;
+    buf_pool_stats_t before, after;
+    buf_pool_get_stats(&before);
+    size_t len = strlen(s_seg_cases[1].request);
+    int chunks = 0;
+    int status = send(c->fd, s_seg_cases[1].request, len, 0) == (ssize_t)len ? read_response(c, &chunks) : 0;
+    buf_pool_get_stats(&after);
+    for (size_t i = 0; i < nheld; i++) buf_pool_put(held[i]);
+    printf("http_load /data batch, pool drained  %3d chunks/response  heap fallbacks %u\n",
+           chunks, (unsigned)(after.exhausted - before.exhausted));
+    if (status != 200 || after.exhausted != before.exhausted || after.try_failed == before.try_failed) {
+        printf("http_load: resp_writer without a pool buffer: status %d\n", status);
+        failures++;
+    }
+    close(c->fd);
+    free(c);
+    return failures;
+}
+
+// The buf_pool and web_static paths only: streamed and ranged files, the
+// cached file and resp_writer's pool buffer
+static const char *const s_soak[] = {
+    "GET /big.bin HTTP/1.1\r\nHost: bench\r\n\r\n",
+    "GET /big.bin HTTP/1.1\r\nHost: bench\r\nRange: bytes=0-99,5000-5099,30000-30099\r\n\r\n",
+    "GET /big.bin HTTP/1.1\r\nHost: bench\r\nRange: bytes=4000-\r\n\r\n",
+    "GET /index.html HTTP/1.1\r\nHost: bench\r\n\r\n",
+    "GET /batch/coalesced HTTP/1.1\r\nHost: bench\r\n\r\n",
+};
+
+typedef struct {
+    uint32_t seed;
+    int requests;
+    uint32_t errors;
+    volatile bool done;
+} hl_soak_client_t;
+
+static void soak_client_task(void *arg)
+{
+    hl_soak_client_t *cl = arg;
+    hl_conn_t *c = malloc(sizeof(*c));
+    if (!c) {
+        cl->errors = cl->requests;
+        cl->done = true;
+        vTaskDelete(NULL);
+        return;
+    }
+    c->fd = -1;
+    for (int n = 0; n < cl->requests; n++) {
+        const char *req = s_soak[next_rand(&cl->seed) % (sizeof(s_soak) / sizeof(s_soak[0]))];
+        if (c->fd < 0) {
+            c->fd = connect_server();
+            c->len = 0;
+        }
+        size_t len = strlen(req);
+        int status = c->fd >= 0 && send(c->fd, req, len, 0) == (ssize_t)len ? read_response(c, NULL) : 0;
+        if (status != 200 && status != 206) {
+            cl->errors++;
+            if (c->fd >= 0) close(c->fd);
+            c->fd = -1;
+        }
+    }
+    if (c->fd >= 0) close(c->fd);
+    free(c);
+    cl->done = true;
+    vTaskDelete(NULL);
+}
+
+// HL_CLIENTS connections hammering the pool at once; returns the failed requests
+static uint32_t soak(int requests, uint32_t seed)
+{
+    static hl_soak_client_t clients[HL_CLIENTS];
+    char name[16];
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        clients[k] = (hl_soak_client_t){ .seed = seed * (k + 1), .requests = requests };
+        snprintf(name, sizeof(name), "hl_soak%d", k);
+        xTaskCreate(soak_client_task, name, 4096, &clients[k], 5, NULL);
+    }
+    uint32_t errors = 0;
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        while (!clients[k].done) vTaskDelay(pdMS_TO_TICKS(10));
+        errors += clients[k].errors;
+    }
+    vTaskDelay(pdMS_TO_TICKS(HL_SOAK_SETTLE_MS));
+    return errors;
+}
+
+// Heap and pool before and after a long run: the largest free block must
+// not shrink and every pool buffer must come back
+static int run_soak(void)
+{
+    int failures = 0;
+    // Lazily allocated state (sessions, the file cache entry) is in place before the baseline
+    uint32_t errors = soak(HL_SOAK_WARMUP, 0x2545f491u);
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest_before = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    buf_pool_stats_t before, after;
+    buf_pool_get_stats(&before);
+
+    int64_t t0 = esp_timer_get_time();
+    errors += soak(HL_SOAK_REQUESTS, 0x6c078965u);
+    double seconds = (esp_timer_get_time() - t0) / 1e6;
+
+    size_t free_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest_after = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    buf_pool_get_stats(&after);
+    printf("http_load soak: %d clients x %d requests in %.1f s, %u failed\n", HL_CLIENTS, HL_SOAK_REQUESTS,
+           seconds, (unsigned)errors);
+    printf("http_load soak: free heap %u -> %u, largest block %u -> %u\n", (unsigned)free_before,
+           (unsigned)free_after, (unsigned)largest_before, (unsigned)largest_after);
+    printf("http_load soak: pool %u acquired, %u waited, %u heap fallbacks, in use %u -> %u (max %u of %u)\n",
+           (unsigned)(after.acquired - before.acquired), (unsigned)(after.waited - before.waited),
+           (unsigned)(after.exhausted - before.exhausted), (unsigned)before.in_use, (unsigned)after.in_use,
+           (unsigned)after.in_use_max, (unsigned)after.count);
+    if (errors) {
+        printf("http_load: %u soak requests failed\n", (unsigned)errors);
+        failures++;
+    }
+    if (largest_after < largest_before) {
+        printf("http_load: largest free block shrank by %u bytes over the soak\n",
+               (unsigned)(largest_before - largest_after));
+        failures++;
+    }
+    if (after.acquired == before.acquired) {
+        printf("http_load: the soak never took a pool buffer\n");
+        failures++;
+    }
+    if (after.in_use != 0) {
+        printf("http_load: %u pool buffer(s) not returned after the soak\n", (unsigned)after.in_use);
+        failures++;
+    }
+    return failures;
+}
+
+int http_load_bench_run(void)
+{
+    int failures = 0;
+    if (start_server() != ESP_OK) {
+        printf("http_load: server setup failed\n");
+        return 1;
+    }
+
+    static hl_client_t clients[HL_CLIENTS];
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        clients[k].seed = 0x9e3779b9u * (k + 1);    // same mix on every run
+        for (size_t r = 0; r < HL_MIX_LEN; r++) {
+            clients[k].latency[r] = malloc(HL_REQUESTS * sizeof(uint32_t));
+            if (!clients[k].latency[r]) {
+                printf("http_load: out of memory\n");
+                return failures + 1;
+            }
+        }
+    }
+    printf("http_load: %d clients, keep-alive, %d requests each after %d warm-up\n",
+           HL_CLIENTS, HL_REQUESTS, HL_WARMUP);
+    char name[16];
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        snprintf(name, sizeof(name), "hl_client%d", k);
+        xTaskCreate(client_task, name, 4096, &clients[k], 5, NULL);
+    }
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        while (!clients[k].done) vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    report(clients);
+
+    uint32_t errors = 0;
+    for (int k = 0; k < HL_CLIENTS; k++) errors += clients[k].errors;
+    if (errors) {
+        printf("http_load: %u requests failed\n", (unsigned)errors);
+        failures++;
+    }
+    if (strcmp(s_control.message, "bench") != 0) {
+        printf("http_load: /control did not reach the receive callback\n");
+        failures++;
+    }
+    for (int k = 0; k < HL_CLIENTS; k++) {
+        for (size_t r = 0; r < HL_MIX_LEN; r++) free(clients[k].latency[r]);
+    }
+    failures += run_segments();
+    failures += run_soak();
+
+    if (getenv("HTTP_LOAD_SERVE")) {
+        printf("http_load: serving on port %d once the benches are done (HTTP_LOAD_SERVE)\n", HL_PORT);
+    } else {
+        httpd_stop(s_server);
+    }
+    return failures;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * @brief Closed-loop load on the shared HTTP handlers (web_static files and
+ *        /stats, /metrics, /workers, /control) served by esp_http_server on
+ *        the host: req/s and latency percentiles per request and overall.
+ *        Then chunks per response and req/s for Task2's /data batch sent
+ *        per 256-byte flush and through resp_writer, and for a multipart
+ *        range response. Last a soak of the buf_pool and web_static paths:
+ *        the largest free heap block must not shrink over it and every
+ *        pool buffer must be returned.
+ *
+ * With HTTP_LOAD_SERVE set in the environment the server is left running
+ * and the bench app does not exit, so tools/http_bench.py --profile bench
+ * can drive it too.
+ *
+ * @return number of failed checks (requests answered with an error or not at
+ *         all, heap or pool buffers lost over the soak)
+ */
+int http_load_bench_run(void);
@@ -0,0 +1,123 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+#include <json_reader.h>
+#include <control_msg.h>
+#include "json_bench.h"
+
+#define JSON_BENCH_ROUNDS   20000
+#define JSON_BENCH_CHUNK    64      // the receiver's httpd_req_recv() chunk
+
+static const char *const s_bodies[] = {
+    "{\"toggle\":true,\"message\":\"Message #42\"}",
+    "{\"toggle\": false, \"message\": \"caf\\u00e9 \\\"quoted\\\" and a longer message to fill the buffer a bit\","
+    " \"actuators\": {\"led\": 1, \"relay\": false}}",
+};
+
+static bool parse_reader(const char *body, size_t len, control_data_t *out)
+{
+    json_reader_bind_t bind;
+    control_msg_json_bind(&bind, out, NULL, NULL);
+    json_reader_t r;
+    json_reader_init(&r, json_reader_bind_cb, &bind);
+    for (size_t i = 0; i < len; i += JSON_BENCH_CHUNK) {
+        json_reader_feed(&r, body + i, len - i < JSON_BENCH_CHUNK ? len - i : JSON_BENCH_CHUNK);
+    }
+    return json_reader_finish(&r) == ESP_OK && json_reader_bind_has_all(&bind);
+}
+
+// What the receiver did before: build the tree, pick the members, free it
+static bool parse_cjson(const char *body, size_t len, control_data_t *out)
+{
+    cJSON *root = cJSON_ParseWithLength(body, len);
+    if (!root) return false;
+    cJSON *toggle = cJSON_GetObjectItemCaseSensitive(root, "toggle");
+    cJSON *message = cJSON_GetObjectItemCaseSensitive(root, "message");
+    bool ok = cJSON_IsBool(toggle) && cJSON_IsString(message) && message->valuestring;
+    if (ok) {
+        out->toggle = cJSON_IsTrue(toggle);
+        snprintf(out->message, sizeof(out->message), "%s", message->valuestring);
+    }
+    cJSON_Delete(root);
+    return ok;
+}
+
+static double time_ns(bool (*parse)(const char *, size_t, control_data_t *), const char *body, size_t len)
+{
+    control_data_t out;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < JSON_BENCH_ROUNDS; i++) {
+        memset(&out, 0, sizeof(out));
+        if (!parse(body, len, &out)) return -1;
+    }
+    return (esp_timer_get_time() - start) * 1000.0 / JSON_BENCH_ROUNDS;
+}
+
+// Numbers as RFC 8259 defines them, alone and as a member; strtod takes more
+static const struct {
+    const char *text;
+    bool ok;
+} s_numbers[] = {
+    { "0", true }, { "-0", true }, { "42", true }, { "-17", true }, { "3.25", true },
+    { "0.5", true }, { "1e3", true }, { "1E+3", true }, { "2.5e-3", true }, { "-0.0e0", true },
+    { "1.", false }, { "01", false }, { "-01", false }, { ".5", false }, { "-", false },
+    { "1e", false }, { "1e+", false }, { "1.e3", false }, { "+1", false }, { "--1", false },
+    { "1.2.3", false }, { "1e3e3", false }, { "0x10", false }, { "00", false }, { "1-2", false },
+};
+
+static esp_err_t ignore(const json_reader_value_t *value, void *ctx)
+{
+    return ESP_OK;
+}
+
+// Whole and one byte at a time, so a number split across feeds is checked too
+static esp_err_t parse_split(const char *text, size_t step)
+{
+    json_reader_t r;
+    json_reader_init(&r, ignore, NULL);
+    size_t len = strlen(text);
+    for (size_t i = 0; i < len; i += step) json_reader_feed(&r, text + i, len - i < step ? len - i : step);
+    return json_reader_finish(&r);
+}
+
+static int run_numbers(void)
+{
+    int failures = 0;
+    size_t n = sizeof(s_numbers) / sizeof(s_numbers[0]);
+    for (size_t i = 0; i < n; i++) {
+        char member[48];
+        snprintf(member, sizeof(member), "{\"n\":%s}", s_numbers[i].text);
+        const char *docs[] = { s_numbers[i].text, member };
+        for (size_t d = 0; d < 2; d++) {
+            bool whole = parse_split(docs[d], JSON_BENCH_CHUNK) == ESP_OK;
+            bool bytewise = parse_split(docs[d], 1) == ESP_OK;
+            if (whole != s_numbers[i].ok || bytewise != s_numbers[i].ok) {
+                printf("json number: '%s' %s\n", docs[d], s_numbers[i].ok ? "rejected" : "accepted");
+                failures++;
+            }
+        }
+    }
+    printf("json numbers: %u cases, %d failed\n", (unsigned)n, failures);
+    return failures;
+}
+
+int json_bench_run(void)
+{
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(s_bodies) / sizeof(s_bodies[0]); i++) {
+        size_t len = strlen(s_bodies[i]);
+        control_data_t a = { 0 }, b = { 0 };
+        if (!parse_reader(s_bodies[i], len, &a) || !parse_cjson(s_bodies[i], len, &b) ||
+            a.toggle != b.toggle || strcmp(a.message, b.message) != 0) {
+            printf("json body %u: parsers disagree\n", (unsigned)i);
+            failures++;
+            continue;
+        }
+        printf("json body %u (%3u bytes)  json_reader %7.0f ns/msg  cJSON_Parse %7.0f ns/msg\n", (unsigned)i,
+               (unsigned)len, time_ns(parse_reader, s_bodies[i], len), time_ns(parse_cjson, s_bodies[i], len));
+    }
+    failures += run_numbers();
+    return failures;
+}
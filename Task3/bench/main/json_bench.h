@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief Time json_reader against cJSON_Parse on /control bodies and print
+ *        ns per message, then check json_reader's number grammar.
+ *
+ * @return number of failed checks
+ */
+int json_bench_run(void);
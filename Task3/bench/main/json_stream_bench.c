@@ -0,0 +1,335 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+#include <json_stream.h>
+#include "json_stream_bench.h"
+
+#define JS_BENCH_ROUNDS     20000
+#define JS_DATA_VALUES      64      // samples in a /data response
+
+// --- Writer checks: call sequences that must produce an exact output or an error ---
+
+typedef void (*writer_fn_t)(json_stream_t *js);
+
+static void w_nested(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_kv_string(js, "s", "a\"b\\c\n\x01");
+    json_stream_kv_int(js, "i", -42);
+    json_stream_key(js, "a");
+    json_stream_begin_array(js);
+    json_stream_uint(js, 1);
+    json_stream_bool(js, false);
+    json_stream_null(js);
+    json_stream_begin_object(js);
+    json_stream_end_object(js);
+    json_stream_end_array(js);
+    json_stream_end_object(js);
+}
+
+static void w_value_without_key(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_uint(js, 1);
+    json_stream_end_object(js);
+}
+
+static void w_value_after_member(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_kv_uint(js, "a", 1);
+    json_stream_string(js, "b");
+    json_stream_end_object(js);
+}
+
+static void w_container_without_key(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_begin_array(js);
+    json_stream_end_array(js);
+    json_stream_end_object(js);
+}
+
+static void w_key_in_array(json_stream_t *js)
+{
+    json_stream_begin_array(js);
+    json_stream_key(js, "a");
+    json_stream_uint(js, 1);
+    json_stream_end_array(js);
+}
+
+static void w_key_after_key(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_key(js, "a");
+    json_stream_key(js, "b");
+    json_stream_uint(js, 1);
+    json_stream_end_object(js);
+}
+
+static void w_key_without_value(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_key(js, "a");
+    json_stream_end_object(js);
+}
+
+static void w_mismatched_close(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_end_array(js);
+}
+
+static void w_unclosed(json_stream_t *js)
+{
+    json_stream_begin_array(js);
+}
+
+static void w_overflow(json_stream_t *js)
+{
+    json_stream_begin_array(js);
+    for (int i = 0; i < 64; i++) json_stream_uint(js, 1000000 + i);
+    json_stream_end_array(js);
+}
+
+typedef struct {
+    const char *name;
+    writer_fn_t fn;
+    json_stream_format_t format;
+    esp_err_t expect;
+    const char *output;         // expected JSON, when expect is ESP_OK
+} writer_case_t;
+
+static const writer_case_t s_cases[] = {
+    { "nested",              w_nested,                JSON_STREAM_FMT_JSON, ESP_OK,
+      "{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"i\":-42,\"a\":[1,false,null,{}]}" },
+    { "nested cbor",         w_nested,                JSON_STREAM_FMT_CBOR, ESP_OK,                NULL },
+    { "value without key",   w_value_without_key,     JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "value without key cbor", w_value_without_key,  JSON_STREAM_FMT_CBOR, ESP_ERR_INVALID_STATE, NULL },
+    { "value after member",  w_value_after_member,    JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "container without key", w_container_without_key, JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "key in array",        w_key_in_array,          JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "key after key",       w_key_after_key,         JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "key without value",   w_key_without_value,     JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "mismatched close",    w_mismatched_close,      JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "unclosed",            w_unclosed,              JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_STATE, NULL },
+    { "overflow",            w_overflow,              JSON_STREAM_FMT_JSON, ESP_ERR_INVALID_SIZE,  NULL },
+};
+
+static int run_checks(void)
+{
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        const writer_case_t *c = &s_cases[i];
+        char buf[128];
+        json_stream_t js;
+        json_stream_init(&js, buf, sizeof(buf));
+        json_stream_set_format(&js, c->format);
+        c->fn(&js);
+        esp_err_t err = json_stream_finish(&js);
+        bool ok = err == c->expect && (!c->output || strcmp(buf, c->output) == 0);
+        if (!ok) {
+            printf("json_stream: case '%s' gave %s", c->name, esp_err_to_name(err));
+            if (err == ESP_OK && c->format == JSON_STREAM_FMT_JSON) printf(" '%s'", buf);
+            printf(", expected %s\n", esp_err_to_name(c->expect));
+            failures++;
+        }
+    }
+    printf("json_stream checks: %u cases, %d failed\n", (unsigned)(sizeof(s_cases) / sizeof(s_cases[0])), failures);
+    return failures;
+}
+
+// --- Accept negotiation ---
+
+typedef struct {
+    const char *accept;
+    json_stream_format_t expect;
+} accept_case_t;
+
+static const accept_case_t s_accept_cases[] = {
+    { NULL,                                             JSON_STREAM_FMT_JSON },
+    { "application/cbor",                               JSON_STREAM_FMT_CBOR },
+    { "APPLICATION/CBOR",                               JSON_STREAM_FMT_CBOR },
+    { "application/json",                               JSON_STREAM_FMT_JSON },
+    { "*/*",                                            JSON_STREAM_FMT_JSON },
+    { "application/cbor;q=0",                           JSON_STREAM_FMT_JSON },
+    { "application/cbor ; q=0.000",                     JSON_STREAM_FMT_JSON },
+    { "application/cbor-seq",                           JSON_STREAM_FMT_JSON },
+    { "application/cbor;q=1.5",                         JSON_STREAM_FMT_JSON },
+    { "application/json, application/cbor;q=0.9",       JSON_STREAM_FMT_JSON },
+    { "application/json;q=0.5, application/cbor",       JSON_STREAM_FMT_CBOR },
+    { "application/cbor, application/json",             JSON_STREAM_FMT_JSON },
+    { "application/*;q=0.2, application/cbor;q=0.8",    JSON_STREAM_FMT_CBOR },
+    { "application/json;q=0, application/cbor;q=0.001", JSON_STREAM_FMT_CBOR },
+    { "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8", JSON_STREAM_FMT_JSON },
+    // Past the 96 bytes the old code looked at
+    { "text/x-a;q=0.1, text/x-b;q=0.1, text/x-c;q=0.1, text/x-d;q=0.1, text/x-e;q=0.1, "
+      "text/x-f;q=0.1, text/x-g;q=0.1, application/cbor",                    JSON_STREAM_FMT_CBOR },
+};
+
+static int run_accept_checks(void)
+{
+    int failures = 0;
+    size_t n = sizeof(s_accept_cases) / sizeof(s_accept_cases[0]);
+    for (size_t i = 0; i < n; i++) {
+        const accept_case_t *c = &s_accept_cases[i];
+        if (json_stream_pick_format(c->accept) != c->expect) {
+            printf("json_stream: Accept '%s' should pick %s\n", c->accept ? c->accept : "(none)",
+                   c->expect == JSON_STREAM_FMT_CBOR ? "CBOR" : "JSON");
+            failures++;
+        }
+    }
+    printf("json_stream accept: %u cases, %d failed\n", (unsigned)n, failures);
+    return failures;
+}
+
+// --- Throughput: the /stats and /data documents, written both ways ---
+
+static uint32_t s_values[JS_DATA_VALUES];
+
+static void write_stats(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_key(js, "cache");
+    json_stream_begin_object(js);
+    json_stream_kv_uint(js, "hits", 18249);
+    json_stream_kv_uint(js, "misses", 1751);
+    json_stream_kv_uint(js, "evictions", 1743);
+    json_stream_kv_uint(js, "invalidations", 3);
+    json_stream_kv_uint(js, "entries", 8);
+    json_stream_kv_uint(js, "bytes_used", 16384);
+    json_stream_kv_uint(js, "bytes_budget", 32768);
+    json_stream_end_object(js);
+    json_stream_key(js, "heap");
+    json_stream_begin_object(js);
+    json_stream_kv_uint(js, "free", 181234);
+    json_stream_kv_uint(js, "min_free", 150002);
+    json_stream_kv_uint(js, "largest_free_block", 110592);
+    json_stream_end_object(js);
+    json_stream_end_object(js);
+}
+
+static char *print_stats_cjson(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *cache = cJSON_AddObjectToObject(root, "cache");
+    cJSON_AddNumberToObject(cache, "hits", 18249);
+    cJSON_AddNumberToObject(cache, "misses", 1751);
+    cJSON_AddNumberToObject(cache, "evictions", 1743);
+    cJSON_AddNumberToObject(cache, "invalidations", 3);
+    cJSON_AddNumberToObject(cache, "entries", 8);
+    cJSON_AddNumberToObject(cache, "bytes_used", 16384);
+    cJSON_AddNumberToObject(cache, "bytes_budget", 32768);
+    cJSON *heap = cJSON_AddObjectToObject(root, "heap");
+    cJSON_AddNumberToObject(heap, "free", 181234);
+    cJSON_AddNumberToObject(heap, "min_free", 150002);
+    cJSON_AddNumberToObject(heap, "largest_free_block", 110592);
+    char *out = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return out;
+}
+
+static void write_data(json_stream_t *js)
+{
+    json_stream_begin_object(js);
+    json_stream_kv_uint(js, "first", 1000);
+    json_stream_kv_uint(js, "cursor", 1000 + JS_DATA_VALUES - 1);
+    json_stream_kv_uint(js, "last", 1000 + JS_DATA_VALUES - 1);
+    json_stream_key(js, "values");
+    json_stream_begin_array(js);
+    for (size_t i = 0; i < JS_DATA_VALUES; i++) json_stream_uint(js, s_values[i]);
+    json_stream_end_array(js);
+    json_stream_end_object(js);
+}
+
+static char *print_data_cjson(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "first", 1000);
+    cJSON_AddNumberToObject(root, "cursor", 1000 + JS_DATA_VALUES - 1);
+    cJSON_AddNumberToObject(root, "last", 1000 + JS_DATA_VALUES - 1);
+    cJSON *values = cJSON_AddArrayToObject(root, "values");
+    for (size_t i = 0; i < JS_DATA_VALUES; i++) cJSON_AddItemToArray(values, cJSON_CreateNumber(s_values[i]));
+    char *out = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return out;
+}
+
+// cJSON allocates through these, so every node, key and print buffer is counted
+static uint32_t s_allocs;
+
+static void *counting_malloc(size_t size)
+{
+    s_allocs++;
+    return malloc(size);
+}
+
+static int run_doc(const char *name, void (*write)(json_stream_t *), char *(*print_cjson)(void))
+{
+    char buf[1024];
+    json_stream_t js;
+    size_t len = 0;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < JS_BENCH_ROUNDS; i++) {
+        json_stream_init(&js, buf, sizeof(buf));
+        write(&js);
+        json_stream_finish(&js);
+        len = json_stream_len(&js);
+    }
+    int64_t t1 = esp_timer_get_time();
+    uint32_t allocs_before = s_allocs;
+    for (int i = 0; i < JS_BENCH_ROUNDS; i++) {
+        char *out = print_cjson();
+        cJSON_free(out);
+    }
+    int64_t t2 = esp_timer_get_time();
+    uint32_t allocs = (s_allocs - allocs_before) / JS_BENCH_ROUNDS;
+
+    // The same calls in CBOR, as sent for Accept: application/cbor
+    size_t cbor_len = 0;
+    for (int i = 0; i < JS_BENCH_ROUNDS; i++) {
+        json_stream_init(&js, buf, sizeof(buf));
+        json_stream_set_format(&js, JSON_STREAM_FMT_CBOR);
+        write(&js);
+        json_stream_finish(&js);
+        cbor_len = json_stream_len(&js);
+    }
+    int64_t t3 = esp_timer_get_time();
+
+    double mb_stream = (double)len * JS_BENCH_ROUNDS / (t1 - t0);     // bytes/us = MB/s
+    double mb_cjson = (double)len * JS_BENCH_ROUNDS / (t2 - t1);
+    printf("json_stream %-5s (%3u bytes)  json_stream %6.1f MB/s  0 allocs   cJSON %6.1f MB/s  %u allocs\n",
+           name, (unsigned)len, mb_stream, mb_cjson, (unsigned)allocs);
+    printf("json_stream %-5s  json %3u bytes %6.0f ns/doc   cbor %3u bytes %6.0f ns/doc\n", name,
+           (unsigned)len, (t1 - t0) * 1000.0 / JS_BENCH_ROUNDS, (unsigned)cbor_len, (t3 - t2) * 1000.0 / JS_BENCH_ROUNDS);
+
+    // Both writers must produce the same document
+    char *ref = print_cjson();
+    json_stream_init(&js, buf, sizeof(buf));
+    write(&js);
+    int failures = 0;
+    if (json_stream_finish(&js) != ESP_OK || !ref || strcmp(ref, buf) != 0) {
+        printf("json_stream: %s differs from cJSON:\n  %s\n  %s\n", name, buf, ref ? ref : "(null)");
+        failures++;
+    }
+    cJSON_free(ref);
+    return failures;
+}
+
+int json_stream_bench_run(void)
+{
+    int failures = run_checks();
+    failures += run_accept_checks();
+
+    cJSON_Hooks hooks = { .malloc_fn = counting_malloc, .free_fn = free };
+    cJSON_InitHooks(&hooks);
+    for (size_t i = 0; i < JS_DATA_VALUES; i++) s_values[i] = (i * 2654435761u) % 4096;  // 12-bit ADC readings
+    failures += run_doc("stats", write_stats, print_stats_cjson);
+    failures += run_doc("data", write_data, print_data_cjson);
+    cJSON_InitHooks(NULL);
+    return failures;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief json_stream writer and Accept negotiation checks, then bytes/s and heap
+ *        allocations per response against cJSON, and JSON vs CBOR size and encode time.
+ *
+ * @return number of failed checks
+ */
+int json_stream_bench_run(void);
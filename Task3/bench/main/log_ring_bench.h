@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @brief Cost per call of LOG_RING_I against ESP_LOGI (console output
+ *        replaced by formatting into a buffer), then concurrent writers
+ *        to check no record slot is claimed twice or lost.
+ *
+ * @return number of failed checks
+ */
+int log_ring_bench_run(void);
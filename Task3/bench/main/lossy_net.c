@@ -0,0 +1,76 @@
+#include <stdbool.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <freertos/FreeRTOS.h>
+#include "lossy_net.h"
+
+ssize_t __real_send(int sock, const void *data, size_t len, int flags);
+ssize_t __real_sendto(int sock, const void *data, size_t len, int flags,
+                      const struct sockaddr *to, socklen_t to_len);
+
+#define LAST_MAX    256
+
+static volatile unsigned s_loss_pct;
+static volatile uint32_t s_dropped;
+static uint32_t s_rng = 0x6d2b79f5;
+static uint8_t s_last[LAST_MAX];
+static size_t s_last_len;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void lossy_net_set_loss(unsigned percent)
+{
+    s_loss_pct = percent;
+}
+
+uint32_t lossy_net_dropped(void)
+{
+    return s_dropped;
+}
+
+size_t lossy_net_last_sent(void *buf, size_t size)
+{
+    portENTER_CRITICAL(&s_mux);
+    size_t n = s_last_len < size ? s_last_len : size;
+    memcpy(buf, s_last, n);
+    portEXIT_CRITICAL(&s_mux);
+    return n;
+}
+
+static bool is_datagram(int sock)
+{
+    int type = 0;
+    socklen_t len = sizeof(type);
+    return getsockopt(sock, SOL_SOCKET, SO_TYPE, &type, &len) == 0 && type == SOCK_DGRAM;
+}
+
+// Sender and receiver tasks both get here; the generator is shared under the lock
+static bool drop(void)
+{
+    if (s_loss_pct == 0) return false;
+    portENTER_CRITICAL(&s_mux);
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    bool lost = s_rng % 100 < s_loss_pct;
+    if (lost) s_dropped++;
+    portEXIT_CRITICAL(&s_mux);
+    return lost;
+}
+
+ssize_t __wrap_send(int sock, const void *data, size_t len, int flags)
+{
+    if (!is_datagram(sock)) return __real_send(sock, data, len, flags);
+    portENTER_CRITICAL(&s_mux);
+    s_last_len = len < LAST_MAX ? len : LAST_MAX;
+    memcpy(s_last, data, s_last_len);
+    portEXIT_CRITICAL(&s_mux);
+    // A lost datagram still counts as sent, as on a real link
+    return drop() ? (ssize_t)len : __real_send(sock, data, len, flags);
+}
+
+ssize_t __wrap_sendto(int sock, const void *data, size_t len, int flags,
+                      const struct sockaddr *to, socklen_t to_len)
+{
+    if (!is_datagram(sock)) return __real_sendto(sock, data, len, flags, to, to_len);
+    return drop() ? (ssize_t)len : __real_sendto(sock, data, len, flags, to, to_len);
+}
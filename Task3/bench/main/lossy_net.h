@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * send() and sendto() are linked with -Wl,--wrap (main/CMakeLists.txt), so
+ * every datagram the components send goes through here first. TCP sockets
+ * and, with the loss at 0, datagrams pass straight through.
+ */
+
+/**
+ * @brief Drop @p percent of the datagrams sent from now on, in both directions.
+ */
+void lossy_net_set_loss(unsigned percent);
+
+/**
+ * @brief Datagrams dropped since the start.
+ */
+uint32_t lossy_net_dropped(void);
+
+/**
+ * @brief Copy of the last datagram sent with send() (a connected socket:
+ *        the udp_control sender), so it can be replayed later.
+ *
+ * @return its length, 0 if none was sent yet
+ */
+size_t lossy_net_last_sent(void *buf, size_t size);
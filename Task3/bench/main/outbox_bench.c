@@ -0,0 +1,158 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_http_server.h>
+#include <control_outbox.h>
+#include <control_transport.h>
+#include "outbox_bench.h"
+
+#define OB_HOST             "127.0.0.1"
+#define OB_PORT             8087        // 8088: its httpd control port
+#define OB_ACK_TIMEOUT_MS   200
+#define OB_RETRY_MAX_MS     100
+#define OB_DOWN_MS          600
+#define OB_SILENT_MS        1000
+#define OB_DELIVER_MS       2000
+#define OB_MESSAGE          "Put while the receiver was down"
+
+static struct {
+    uint32_t applied;           // copies the receiver applied
+    control_data_t state;
+} s_rx;
+
+static volatile uint32_t s_delivered;
+
+static esp_err_t ob_recv(const void *payload, size_t len, void *ctx)
+{
+    if (control_msg_decode_binary(payload, len, &s_rx.state) != ESP_OK) return ESP_ERR_INVALID_ARG;
+    s_rx.applied++;
+    return ESP_OK;
+}
+
+static esp_err_t ob_post_handler(httpd_req_t *req)
+{
+    return control_transport_http_serve(req, ob_recv, NULL);
+}
+
+static void on_delivered(const char *key, int64_t put_us, void *ctx)
+{
+    s_delivered++;
+}
+
+static httpd_handle_t start_receiver(void)
+{
+    httpd_handle_t server = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = OB_PORT;
+    config.ctrl_port = OB_PORT + 1;
+    if (httpd_start(&server, &config) != ESP_OK) return NULL;
+    const httpd_uri_t uri = {
+        .uri = "/control",
+        .method = HTTP_POST,
+        .handler = ob_post_handler,
+    };
+    httpd_register_uri_handler(server, &uri);
+    return server;
+}
+
+// Listens with a full accept backlog, so connects hang until they time out
+static int start_silent(int fillers[4])
+{
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(OB_PORT) };
+    addr.sin_addr.s_addr = inet_addr(OB_HOST);
+    if (lfd < 0 || bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(lfd, 0) != 0) {
+        if (lfd >= 0) close(lfd);
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        fillers[i] = socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(fillers[i], F_SETFL, O_NONBLOCK);
+        connect(fillers[i], (struct sockaddr *)&addr, sizeof(addr));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+    return lfd;
+}
+
+int outbox_bench_run(void)
+{
+    control_transport_t *t = NULL;
+    control_outbox_t *ob = NULL;
+    control_outbox_config_t config = CONTROL_OUTBOX_DEFAULT_CONFIG();
+    config.name = "ob_bench";
+    config.min_interval_ms = 0;
+    config.ack_timeout_ms = OB_ACK_TIMEOUT_MS;
+    config.retry_min_ms = OB_RETRY_MAX_MS / 2;
+    config.retry_max_ms = OB_RETRY_MAX_MS;
+    config.on_delivered = on_delivered;
+    if (control_transport_http_open(OB_HOST, OB_PORT, "/control", CONTROL_TRANSPORT_BINARY, &t) != ESP_OK ||
+        control_outbox_create(&config, t, &ob) != ESP_OK) {
+        printf("outbox: setup failed\n");
+        if (t) control_transport_close(t);
+        return 1;
+    }
+    int failures = 0;
+    memset(&s_rx, 0, sizeof(s_rx));
+    esp_log_level_set("control_outbox", ESP_LOG_ERROR);     // every retry below is expected
+    s_delivered = 0;
+
+    // Nothing listens: every retry finds the value still queued in the transport
+    control_data_t data = { .toggle = true };
+    snprintf(data.message, sizeof(data.message), OB_MESSAGE);
+    control_outbox_put(ob, "control", &data);
+    vTaskDelay(pdMS_TO_TICKS(OB_DOWN_MS));
+    control_outbox_stats_t down;
+    control_outbox_get_stats(ob, &down);
+    printf("outbox http, receiver down %d ms: %u sent, %u retries\n", OB_DOWN_MS, (unsigned)down.sent,
+           (unsigned)down.retries);
+    if (down.sent != 1 || down.retries < 2) failures++;
+
+    // Connects hang: each retry still ends within ack_timeout_ms
+    int fillers[4];
+    int lfd = start_silent(fillers);
+    if (lfd < 0) {
+        printf("outbox: cannot listen on %d\n", OB_PORT);
+        failures++;
+    } else {
+        vTaskDelay(pdMS_TO_TICKS(OB_SILENT_MS));
+        control_outbox_stats_t silent;
+        control_outbox_get_stats(ob, &silent);
+        uint32_t failed = silent.failed - down.failed;
+        printf("outbox http, receiver silent %d ms: %u unconfirmed sends (ack_timeout %d ms)\n", OB_SILENT_MS,
+               (unsigned)failed, OB_ACK_TIMEOUT_MS);
+        if (failed < OB_SILENT_MS / (OB_ACK_TIMEOUT_MS + OB_RETRY_MAX_MS) - 1) failures++;
+        for (int i = 0; i < 4; i++) close(fillers[i]);
+        close(lfd);
+    }
+
+    // Receiver back: the one queued copy is delivered, once
+    httpd_handle_t server = start_receiver();
+    int64_t deadline = esp_timer_get_time() + OB_DELIVER_MS * 1000LL;
+    while (server && s_delivered == 0 && esp_timer_get_time() < deadline) vTaskDelay(pdMS_TO_TICKS(10));
+    control_outbox_stats_t up;
+    control_outbox_get_stats(ob, &up);
+    printf("outbox http, receiver back: delivered %u, applied %u cop%s, %u sent, %u retries\n",
+           (unsigned)s_delivered, (unsigned)s_rx.applied, s_rx.applied == 1 ? "y" : "ies", (unsigned)up.sent,
+           (unsigned)up.retries);
+    if (!server || s_delivered != 1 || s_rx.applied != 1 || up.sent != 1 ||
+        strcmp(s_rx.state.message, OB_MESSAGE) != 0) {
+        failures++;
+    }
+
+    control_outbox_delete(ob);
+    vTaskDelay(pdMS_TO_TICKS(OB_ACK_TIMEOUT_MS + 50));      // the task finishes its send and closes
+    if (server) httpd_stop(server);
+    esp_log_level_set("control_outbox", ESP_LOG_INFO);
+    return failures;
+}
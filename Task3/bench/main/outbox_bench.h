@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief control_outbox over the real HTTP transport while the receiver is
+ *        down, then silent, then back: retries must not queue more copies
+ *        of the value, each retry must end within ack_timeout_ms, and the
+ *        receiver must apply the value exactly once.
+ *
+ * @return number of failed checks
+ */
+int outbox_bench_run(void);
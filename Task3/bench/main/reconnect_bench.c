@@ -0,0 +1,257 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wifi_reconnect.h>
+#include "reconnect_bench.h"
+
+// Virtual time, so thousands of outages simulate in milliseconds
+#define SIM_OUTAGES         2000
+#define SIM_ASSOC_MS        300     // association + DHCP when the AP is up: 300..800 ms
+#define SIM_SCAN_MS         1000    // a failed attempt reports after 1000..2000 ms (scan, no AP)
+#define SIM_OLD_DELAY_MS    5000    // the previous handler: vTaskDelay(5000) then connect
+#define MS                  1000LL
+
+#define SIM_SEED            0x2545f491
+
+// Outages draw from their own generator, so both policies see the same ones
+static uint32_t s_rng = SIM_SEED;
+static uint32_t s_outage_rng = SIM_SEED;
+
+static uint32_t xorshift(uint32_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static uint32_t next_rand(void)
+{
+    return xorshift(&s_rng);
+}
+
+static uint32_t between(uint32_t *x, uint32_t lo, uint32_t hi)
+{
+    return lo + xorshift(x) % (hi - lo + 1);
+}
+
+static uint32_t rand_between(uint32_t lo, uint32_t hi)
+{
+    return between(&s_rng, lo, hi);
+}
+
+// --- Scenario checks: hand-fed events, exact expectations ---
+
+static int s_failed_checks = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("reconnect check failed: %s\n", what);
+        s_failed_checks++;
+    }
+}
+
+static void run_checks(void)
+{
+    wifi_reconnect_config_t config = WIFI_RECONNECT_DEFAULT_CONFIG();
+    config.jitter_pct = 0;
+    wifi_reconnect_t rc;
+    wifi_reconnect_init(&rc, &config);
+
+    wifi_reconnect_action_t a = wifi_reconnect_start(&rc, 0);
+    check(a.connect && a.timer_us == config.connect_timeout_ms * MS, "start connects with a timeout");
+    a = wifi_reconnect_got_ip(&rc, 400 * MS);
+    check(a.stop_timer && !a.connect && rc.stats.first_connect_us == 400 * MS, "first address");
+
+    // Drop, two failed attempts, then back: 250, 500 ms waits
+    a = wifi_reconnect_disconnected(&rc, 1000 * MS, 0);
+    check(!a.connect && a.timer_us == 250 * MS, "first retry after backoff_min_ms");
+    uint32_t seq = a.timer_seq;
+    a = wifi_reconnect_disconnected(&rc, 1001 * MS, 0);
+    check(!a.connect && !a.timer_us, "repeated disconnect while waiting is ignored");
+    a = wifi_reconnect_timer(&rc, seq, 1250 * MS, 0);
+    check(a.connect, "timer connects");
+    a = wifi_reconnect_disconnected(&rc, 2250 * MS, 0);
+    check(a.timer_us == 500 * MS && rc.stats.failures == 1, "failed attempt doubles the wait");
+    a = wifi_reconnect_timer(&rc, a.timer_seq - 1, 2300 * MS, 0);
+    check(!a.connect, "stale timer is ignored");
+    a = wifi_reconnect_timer(&rc, rc.timer_seq, 2750 * MS, 0);
+    a = wifi_reconnect_got_ip(&rc, 3250 * MS);
+    check(rc.stats.reconnects == 1 && rc.stats.reconnect_last_us == 2250 * MS, "reconnect time from the disconnect");
+
+    // Associated but no address: the timeout disconnects and backs off
+    a = wifi_reconnect_disconnected(&rc, 10000 * MS, 0);
+    a = wifi_reconnect_timer(&rc, a.timer_seq, 10250 * MS, 0);
+    uint32_t timeout_seq = a.timer_seq;
+    a = wifi_reconnect_timer(&rc, timeout_seq, (10250 + config.connect_timeout_ms) * MS, 0);
+    check(a.disconnect && !a.connect && a.timer_us == 500 * MS && rc.stats.timeouts == 1,
+          "connect timeout disconnects and backs off");
+    a = wifi_reconnect_disconnected(&rc, (10260 + config.connect_timeout_ms) * MS, 0);
+    check(!a.timer_us, "disconnect caused by the timeout is ignored");
+
+    // Backoff growth, cap and jitter bounds
+    config.jitter_pct = 25;
+    bool ok = true;
+    for (uint32_t n = 1; n <= 20; n++) {
+        uint64_t base = 250;
+        for (uint32_t i = 1; i < n && base < config.backoff_max_ms; i++) base *= 2;
+        if (base > config.backoff_max_ms) base = config.backoff_max_ms;
+        for (int k = 0; k < 200; k++) {
+            uint32_t ms = wifi_reconnect_backoff_ms(&config, n, next_rand());
+            ok &= ms >= base - base / 4 && ms <= base + base / 4;
+        }
+    }
+    check(ok, "backoff doubles, caps at backoff_max_ms, jitter within 25%");
+}
+
+// --- Random outages ---
+
+typedef enum { EV_TIMER, EV_GOT_IP, EV_DISCONNECTED } sim_event_t;
+
+typedef struct {
+    int64_t down_us, up_us;     // the AP is gone in [down, up)
+    int64_t loop_blocked_us;    // time the event loop spent inside handlers
+    uint32_t *samples;
+    size_t count;
+} sim_t;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Outage lengths: mostly short drops, some AP restarts, a few long absences
+static uint32_t outage_ms(void)
+{
+    uint32_t r = xorshift(&s_outage_rng) % 100;
+    if (r < 70) return between(&s_outage_rng, 200, 2000);
+    if (r < 95) return between(&s_outage_rng, 2000, 20000);
+    return between(&s_outage_rng, 20000, 120000);
+}
+
+static int64_t next_outage(int64_t now)
+{
+    return now + between(&s_outage_rng, 1000, 60000) * MS;
+}
+
+// Outcome of a connect issued at now: the event and when it arrives
+static int64_t attempt(const sim_t *sim, int64_t now, sim_event_t *ev)
+{
+    bool ap_up = now >= sim->up_us;
+    *ev = ap_up ? EV_GOT_IP : EV_DISCONNECTED;
+    return now + (ap_up ? rand_between(SIM_ASSOC_MS, SIM_ASSOC_MS + 500) : rand_between(SIM_SCAN_MS, 2 * SIM_SCAN_MS)) * MS;
+}
+
+static void run_new(sim_t *sim, wifi_reconnect_stats_t *stats)
+{
+    wifi_reconnect_config_t config = WIFI_RECONNECT_DEFAULT_CONFIG();
+    wifi_reconnect_t rc;
+    wifi_reconnect_init(&rc, &config);
+    int64_t now = 0;
+    int64_t timer_at = -1, wifi_at = -1;
+    uint32_t timer_seq = 0;
+    sim_event_t wifi_ev = EV_GOT_IP;
+
+    wifi_reconnect_action_t a = wifi_reconnect_start(&rc, now);
+    for (size_t o = 0; o < SIM_OUTAGES; o++) {
+        // Connected and idle until the next outage
+        bool settled = false;
+        while (!settled) {
+            if (a.stop_timer) timer_at = -1;
+            if (a.timer_us) {
+                timer_at = now + a.timer_us;
+                timer_seq = a.timer_seq;
+            }
+            if (a.connect) wifi_at = attempt(sim, now, &wifi_ev);
+            if (a.disconnect) wifi_at = -1;
+            a = (wifi_reconnect_action_t) { 0 };
+
+            if (rc.state == WIFI_RECONNECT_CONNECTED && wifi_at < 0) {
+                settled = true;
+            } else if (wifi_at >= 0 && (timer_at < 0 || wifi_at <= timer_at)) {
+                now = wifi_at;
+                wifi_at = -1;
+                a = wifi_ev == EV_GOT_IP ? wifi_reconnect_got_ip(&rc, now)
+                                         : wifi_reconnect_disconnected(&rc, now, next_rand());
+            } else {
+                now = timer_at;
+                timer_at = -1;
+                a = wifi_reconnect_timer(&rc, timer_seq, now, next_rand());
+            }
+        }
+        if (o > 0) sim->samples[sim->count++] = rc.stats.reconnect_last_us;
+
+        // Next outage starts after a while connected; the station notices at once
+        sim->down_us = next_outage(now);
+        sim->up_us = sim->down_us + outage_ms() * MS;
+        now = sim->down_us;
+        a = wifi_reconnect_disconnected(&rc, now, next_rand());
+    }
+    *stats = rc.stats;
+}
+
+// The previous handler: every disconnect event blocks the loop 5 s, then connects
+static void run_old(sim_t *sim)
+{
+    int64_t now = 0;
+    for (size_t o = 0; o < SIM_OUTAGES; o++) {
+        sim->down_us = next_outage(now);
+        sim->up_us = sim->down_us + outage_ms() * MS;
+        now = sim->down_us;
+        for (;;) {
+            now += SIM_OLD_DELAY_MS * MS;
+            sim->loop_blocked_us += SIM_OLD_DELAY_MS * MS;
+            sim_event_t ev;
+            now = attempt(sim, now, &ev);
+            if (ev == EV_GOT_IP) break;
+        }
+        sim->samples[sim->count++] = (uint32_t)(now - sim->down_us);
+    }
+}
+
+static void print_distribution(const char *name, sim_t *sim)
+{
+    qsort(sim->samples, sim->count, sizeof(uint32_t), cmp_u32);
+    size_t n = sim->count;
+    printf("reconnect %-6s p50 %6.2f s  p90 %6.2f s  p99 %6.2f s  max %6.2f s  loop blocked %7.1f s\n", name,
+           sim->samples[n / 2] / 1e6, sim->samples[n * 9 / 10] / 1e6, sim->samples[n * 99 / 100] / 1e6,
+           sim->samples[n - 1] / 1e6, sim->loop_blocked_us / 1e6);
+}
+
+int reconnect_bench_run(void)
+{
+    s_failed_checks = 0;
+    run_checks();
+    printf("reconnect checks: %d failed\n", s_failed_checks);
+
+    s_outage_rng = SIM_SEED;
+    sim_t sim = { .samples = calloc(SIM_OUTAGES, sizeof(uint32_t)) };
+    if (!sim.samples) {
+        printf("reconnect: no memory for %d samples\n", SIM_OUTAGES);
+        return s_failed_checks + 1;
+    }
+
+    wifi_reconnect_stats_t st;
+    run_new(&sim, &st);
+    print_distribution("backoff", &sim);
+    static const uint32_t bounds_ms[WIFI_RECONNECT_NUM_BUCKETS] = WIFI_RECONNECT_BUCKETS_MS;
+    printf("reconnect backoff buckets:");
+    for (size_t b = 0; b < WIFI_RECONNECT_NUM_BUCKETS; b++) {
+        printf(" <=%ums:%u", (unsigned)bounds_ms[b], (unsigned)st.buckets[b]);
+    }
+    printf(" more:%u  attempts %u  failures %u\n", (unsigned)st.buckets[WIFI_RECONNECT_NUM_BUCKETS],
+           (unsigned)st.attempts, (unsigned)st.failures);
+
+    memset(sim.samples, 0, SIM_OUTAGES * sizeof(uint32_t));
+    sim.count = 0;
+    sim.loop_blocked_us = 0;
+    s_rng = s_outage_rng = SIM_SEED;
+    run_old(&sim);
+    print_distribution("fixed5", &sim);
+    free(sim.samples);
+    return s_failed_checks;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief Drive wifi_reconnect with simulated Wi-Fi events: scenario checks, then the
+ *        time-to-reconnect distribution over random AP outages against the old fixed 5 s retry.
+ *
+ * @return number of failed scenario checks
+ */
+int reconnect_bench_run(void);
@@ -0,0 +1,134 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <state_store.h>
+#include "state_store_bench.h"
+
+#define SS_WRITERS          2
+#define SS_READERS          4
+#define SS_RUN_MS           1000
+
+// Shaped like the receiver's control state. Every field follows from stamp,
+// so a reader can tell a mix of two writes from a whole one.
+typedef struct {
+    bool led;
+    char message[100];
+    uint32_t stamp;
+} ss_value_t;
+
+static ss_value_t s_storage;
+static state_store_t s_store;
+
+static struct {
+    bool plain;                 // readers memcpy the storage instead of state_store_read()
+    atomic_bool stop;
+    _Atomic uint32_t done;
+    _Atomic uint32_t writes;
+    _Atomic uint32_t reads;
+    _Atomic uint32_t torn;
+    _Atomic uint32_t backwards;
+} s_run;
+
+static void make_value(uint32_t stamp, ss_value_t *v)
+{
+    size_t n = stamp % 98 + 1;
+    v->led = stamp & 1;
+    memset(v->message, 'a' + stamp % 26, n);
+    v->message[n] = '\0';
+    v->stamp = stamp;
+}
+
+static bool is_whole(const ss_value_t *v)
+{
+    if (v->stamp == 0) return strcmp(v->message, "Initial message") == 0 && !v->led;
+    size_t n = v->stamp % 98 + 1;
+    if (v->led != (v->stamp & 1) || strnlen(v->message, sizeof(v->message)) != n) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (v->message[i] != 'a' + v->stamp % 26) return false;
+    }
+    return true;
+}
+
+static void writer_task(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    ss_value_t v;
+    // Writers use disjoint stamps: even and odd
+    for (uint32_t i = 1; !atomic_load(&s_run.stop); i++) {
+        make_value(i * SS_WRITERS + id, &v);
+        state_store_write(&s_store, &v);
+        atomic_fetch_add(&s_run.writes, 1);
+    }
+    atomic_fetch_add(&s_run.done, 1);
+    vTaskDelete(NULL);
+}
+
+static void reader_task(void *arg)
+{
+    ss_value_t v;
+    uint32_t last = 0;
+    while (!atomic_load(&s_run.stop)) {
+        if (s_run.plain) {
+            memcpy(&v, &s_storage, sizeof(v));
+        } else {
+            uint32_t version = state_store_read(&s_store, &v);
+            if ((int32_t)(version - last) < 0) atomic_fetch_add(&s_run.backwards, 1);
+            last = version;
+        }
+        if (!is_whole(&v)) atomic_fetch_add(&s_run.torn, 1);
+        atomic_fetch_add(&s_run.reads, 1);
+    }
+    atomic_fetch_add(&s_run.done, 1);
+    vTaskDelete(NULL);
+}
+
+static void run(bool plain)
+{
+    memset(&s_storage, 0, sizeof(s_storage));
+    strcpy(s_storage.message, "Initial message");
+    state_store_init(&s_store, &s_storage, sizeof(s_storage));
+    s_run.plain = plain;
+    atomic_store(&s_run.stop, false);
+    atomic_store(&s_run.done, 0);
+    atomic_store(&s_run.writes, 0);
+    atomic_store(&s_run.reads, 0);
+    atomic_store(&s_run.torn, 0);
+    atomic_store(&s_run.backwards, 0);
+
+    for (int k = 0; k < SS_WRITERS; k++) {
+        char name[16];
+        snprintf(name, sizeof(name), "ss_writer%d", k);
+        xTaskCreate(writer_task, name, 4096, (void *)(uintptr_t)k, 5, NULL);
+    }
+    for (int k = 0; k < SS_READERS; k++) {
+        char name[16];
+        snprintf(name, sizeof(name), "ss_reader%d", k);
+        xTaskCreate(reader_task, name, 4096, NULL, 5, NULL);
+    }
+    vTaskDelay(pdMS_TO_TICKS(SS_RUN_MS));
+    atomic_store(&s_run.stop, true);
+    while (atomic_load(&s_run.done) < SS_WRITERS + SS_READERS) vTaskDelay(1);
+
+    printf("state_store %-7s %d writers %d readers: %u writes, %u reads, %u torn, %u versions backwards\n",
+           plain ? "memcpy" : "seqlock", SS_WRITERS, SS_READERS, (unsigned)atomic_load(&s_run.writes),
+           (unsigned)atomic_load(&s_run.reads), (unsigned)atomic_load(&s_run.torn),
+           (unsigned)atomic_load(&s_run.backwards));
+}
+
+int state_store_bench_run(void)
+{
+    int failures = 0;
+    run(false);
+    if (atomic_load(&s_run.torn) != 0 || atomic_load(&s_run.backwards) != 0) failures++;
+    if (atomic_load(&s_run.writes) == 0 || atomic_load(&s_run.reads) == 0) {
+        printf("state_store: writers or readers never ran\n");
+        failures++;
+    }
+    // Not a check: shows what the readers catch without the seqlock
+    run(true);
+    return failures;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief state_store under writer/reader contention: two writer tasks
+ *        publish self-checking values while reader tasks check every
+ *        snapshot. Any torn read or version going backwards fails the run.
+ *        The same readers doing a plain memcpy are run for comparison.
+ *
+ * @return number of failed checks
+ */
+int state_store_bench_run(void);
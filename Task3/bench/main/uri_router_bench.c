@@ -0,0 +1,197 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <httpd_workers.h>
+#include <uri_router.h>
+#include "uri_router_bench.h"
+
+#define UR_PORT             8083
+#define UR_LOOKUPS          200000
+#define UR_URIS             64          // request URIs cycled through per table
+
+static volatile uint32_t s_handled;
+
+static esp_err_t uri_router_bench_handler(httpd_req_t *req)
+{
+    s_handled++;
+    return httpd_resp_send(req, "ok", HTTPD_RESP_USE_STRLEN);
+}
+
+// Generated from routes_<n>.txt by uri_router_generate() in CMakeLists.txt
+#include "routes_10.inc"
+#include "routes_50.inc"
+#include "routes_200.inc"
+
+typedef struct {
+    const uri_router_table_t *table;
+    char tpl[256][32];          // the same routes as httpd templates ("{id}" -> "*")
+} ur_case_t;
+
+static ur_case_t s_cases[] = {
+    { &routes_10_table },
+    { &routes_50_table },
+    { &routes_200_table },
+};
+
+static uint32_t s_rng = 0x6b43a9b5;
+
+static uint32_t next_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// What httpd_find_uri_handler() does for handlers registered one by one
+static int linear_lookup(const ur_case_t *c, httpd_method_t method, const char *uri)
+{
+    size_t len = strcspn(uri, "?");
+    for (size_t i = 0; i < c->table->num_routes; i++) {
+        if (c->table->routes[i].method == method && httpd_uri_match_wildcard(c->tpl[i], uri, len)) return i;
+    }
+    return -1;
+}
+
+// A request URI matching @p r, its parameter filled in and, with @p query, a query string
+static void request_uri(const uri_router_route_t *r, char *buf, size_t size, bool query)
+{
+    const char *brace = strchr(r->pattern, '{');
+    if (brace) snprintf(buf, size, "%.*s%u", (int)(brace - r->pattern), r->pattern, (unsigned)(next_rand() % 1000));
+    else snprintf(buf, size, "%s", r->pattern);
+    if (query) strncat(buf, "?v=1", size - strlen(buf) - 1);
+}
+
+// Returns the number of failed checks
+static int run_case(ur_case_t *c)
+{
+    const uri_router_table_t *t = c->table;
+    int failures = 0;
+    static char uris[UR_URIS][48];
+    static httpd_method_t methods[UR_URIS];
+    static int expect[UR_URIS];
+
+    for (size_t i = 0; i < t->num_routes; i++) {
+        const char *brace = strchr(t->routes[i].pattern, '{');
+        if (brace) snprintf(c->tpl[i], sizeof(c->tpl[i]), "%.*s*", (int)(brace - t->routes[i].pattern), t->routes[i].pattern);
+        else snprintf(c->tpl[i], sizeof(c->tpl[i]), "%s", t->routes[i].pattern);
+    }
+    // Mostly hits, every eighth a miss
+    for (int k = 0; k < UR_URIS; k++) {
+        if (k % 8 == 7) {
+            snprintf(uris[k], sizeof(uris[k]), "/api/x%d/status", k);
+            methods[k] = HTTP_GET;
+            expect[k] = -1;
+        } else {
+            int i = next_rand() % t->num_routes;
+            request_uri(&t->routes[i], uris[k], sizeof(uris[k]), k % 4 == 1);
+            methods[k] = t->routes[i].method;
+            expect[k] = i;
+        }
+    }
+
+    // Both must agree with the route each URI was made from
+    for (int k = 0; k < UR_URIS; k++) {
+        const uri_router_route_t *r = uri_router_lookup(t, methods[k], uris[k]);
+        int got = r ? (int)(r - t->routes) : -1;
+        if (got != expect[k] || linear_lookup(c, methods[k], uris[k]) != expect[k]) {
+            printf("uri_router: %s matched route %d, expected %d\n", uris[k], got, expect[k]);
+            failures++;
+        }
+    }
+
+    volatile int sink = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (int n = 0; n < UR_LOOKUPS; n++) {
+        int k = n % UR_URIS;
+        sink += uri_router_lookup(t, methods[k], uris[k]) != NULL;
+    }
+    int64_t t1 = esp_timer_get_time();
+    for (int n = 0; n < UR_LOOKUPS; n++) {
+        int k = n % UR_URIS;
+        sink += linear_lookup(c, methods[k], uris[k]) >= 0;
+    }
+    int64_t t2 = esp_timer_get_time();
+    (void)sink;
+    printf("uri_router %3u routes  perfect hash %5.0f ns/lookup   httpd linear match %6.0f ns/lookup\n",
+           (unsigned)t->num_routes, (t1 - t0) * 1000.0 / UR_LOOKUPS, (t2 - t1) * 1000.0 / UR_LOOKUPS);
+    return failures;
+}
+
+// Status code of one request to the local server, 0 on failure
+static int get(const char *uri)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(UR_PORT) };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { .tv_sec = 5 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char buf[512];
+    int status = 0;
+    int n = snprintf(buf, sizeof(buf), "GET %s HTTP/1.1\r\nHost: bench\r\nConnection: close\r\n\r\n", uri);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 && send(fd, buf, n, 0) == n &&
+        recv(fd, buf, sizeof(buf) - 1, 0) > 0) {
+        sscanf(buf, "HTTP/1.%*d %d", &status);
+    }
+    close(fd);
+    return status;
+}
+
+// Routed requests must show up in httpd_workers' per-route stats
+static int check_accounting(void)
+{
+    int failures = 0;
+    httpd_workers_config_t wcfg = HTTPD_WORKERS_DEFAULT_CONFIG();
+    esp_err_t err = httpd_workers_start(&wcfg);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return 1;
+
+    httpd_handle_t server = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = UR_PORT;
+    config.ctrl_port = UR_PORT + 1;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    if (httpd_start(&server, &config) != ESP_OK) return 1;
+    if (uri_router_start(server, &routes_50_table) != ESP_OK) {
+        httpd_stop(server);
+        return 1;
+    }
+
+    uint32_t handled = s_handled;
+    int ok = get("/api/r0/status"), param = get("/api/r9/42?x=1"), missing = get("/api/r0/nope");
+    if (ok != 200 || param != 200 || missing != 404 || s_handled != handled + 2) {
+        printf("uri_router: served %d/%d/%d, expected 200/200/404\n", ok, param, missing);
+        failures++;
+    }
+
+    static httpd_workers_route_stats_t stats[256];
+    size_t n = httpd_workers_get_route_stats(stats, sizeof(stats) / sizeof(stats[0]));
+    uint32_t counted = 0;
+    bool listed = false;
+    for (size_t i = 0; i < n && i < sizeof(stats) / sizeof(stats[0]); i++) {
+        if (strcmp(stats[i].uri, "/api/r0/status") == 0 || strcmp(stats[i].uri, "/api/r9/{id}") == 0) {
+            counted += stats[i].count;
+            listed = true;
+        }
+    }
+    if (!listed || counted != 2) {
+        printf("uri_router: routed requests not in httpd_workers stats (%u counted)\n", (unsigned)counted);
+        failures++;
+    }
+    httpd_stop(server);
+    return failures;
+}
+
+int uri_router_bench_run(void)
+{
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) failures += run_case(&s_cases[i]);
+    failures += check_accounting();
+    return failures;
+}
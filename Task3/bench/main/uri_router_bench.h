@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief uri_router lookups for 10, 50 and 200 routes against httpd's own
+ *        linear match over the same routes registered one by one, then a
+ *        request through a real server checking that routed requests are
+ *        accounted by httpd_workers like registered ones.
+ *
+ * @return number of failed checks
+ */
+int uri_router_bench_run(void);
@@ -1,5 +1,6 @@
 #include <esp_wifi.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <esp_event.h>
 #include <esp_log.h>
 #include <esp_system.h>
@@ -10,7 +11,19 @@
 #include <string.h>
 #include <driver/gpio.h>
 #include <esp_spiffs.h>
-#include <cJSON.h> // Using cJSON for JSON handling
+#include <json_reader.h>
+#include <control_msg.h>
+#include <httpd_workers.h>
+#include <metrics.h>
+#include <log_ring.h>
+#include <resp_writer.h>
+#include <control_transport.h>
+#include <actuator.h>
+#include <state_store.h>
+#include <esp_timer.h>
+#include <udp_control.h>
+#include <esp_random.h>
+#include <wifi_reconnect.h>
 
 static const char *TAG = "receiver";
 
@@ -18,81 +31,135 @@ static const char *TAG = "receiver";
 #define WIFI_PASSWORD  "password123"
 #define LED_GPIO       GPIO_NUM_2 // LED GPIO
 
-// Volatile global values updated by the sender
-volatile bool global_led_state = false; // false for off, true for on
-volatile char global_message[100] = "Initial message"; // Example size
+// Exported on /metrics
+static metrics_counter_t s_control_ok = METRICS_COUNTER_INIT("control_messages_total", "Control messages applied");
+static metrics_counter_t s_control_rejected = METRICS_COUNTER_INIT("control_rejected_total", "Control messages rejected as malformed");
 
-// Struct definition (should match the sender)
-typedef struct {
-    bool toggle;
-    char message[100];
-} control_data_t;
+// Outputs driven by control messages; "led" follows the toggle field
+static int s_led_actuator = -1;
 
-static esp_err_t http_server_control_handler(httpd_req_t *req)
+// Current state as set by the sender; written by the control paths, read by /message.
+// Readers copy a consistent snapshot and never block the writer.
+static control_data_t s_state_storage = { .toggle = false, .message = "Initial message" };
+static state_store_t s_state;
+
+// Receipt time of a control message: passed as ctx, else the callback time (UDP)
+static int64_t received_at(void *ctx)
 {
-    char content[150]; // Buffer to hold the incoming JSON data
-    // int received = 0; // Unused variable removed
-
-    // Read the data sent by the client
-    int ret = httpd_req_recv(req, content, sizeof(content) -1); // Ensure space for null terminator
-    if (ret <= 0) {  // 0 for finished request, < 0 for error
-        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
-            ESP_LOGW(TAG, "httpd_req_recv timeout");
-            httpd_resp_send_408(req); // Request timed out
-        } else {
-            ESP_LOGE(TAG, "httpd_req_recv error: %d", ret);
-        }
-        return ESP_FAIL;
-    }
+    return ctx ? *(const int64_t *)ctx : esp_timer_get_time();
+}
 
-    // Null-terminate the received data
-    content[ret] = '\0';
-    ESP_LOGI(TAG, "Received data: %s", content);
+// Publish a validated message: new state, LED, counters
+static void apply_control(const control_data_t *next, int64_t received_us)
+{
+    state_store_write(&s_state, next);
+    actuator_set(s_led_actuator, next->toggle, received_us);
+    metrics_counter_inc(&s_control_ok);
+    // Deferred log: the message is a local copy, so only its length is recorded
+    LOG_RING_I(TAG, "Updated: toggle=%d, message_len=%d", next->toggle, (int)strlen(next->message));
+}
 
-    // Parse JSON
-    cJSON *root = cJSON_Parse(content);
-    if (root == NULL) {
-        const char *error_ptr = cJSON_GetErrorPtr();
-        if (error_ptr != NULL) {
-            ESP_LOGE(TAG, "Failed to parse JSON: %s", error_ptr);
-        } else {
-            ESP_LOGE(TAG, "Failed to parse JSON: Unknown error");
-        }
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to parse JSON");
-        return ESP_FAIL;
+// JSON control messages (POST /control): the control_msg fields[, "actuators": {"name": value}]
+
+// Actuator commands are held until the whole message has parsed, then applied
+typedef struct {
+    struct {
+        char name[ACTUATOR_NAME_MAX];
+        int32_t value;
+    } cmd[ACTUATOR_MAX];
+    size_t count;
+} actuator_commands_t;
+
+static esp_err_t collect_actuator_command(const json_reader_value_t *v, void *ctx)
+{
+    actuator_commands_t *commands = ctx;
+    if (v->depth != 2 || strcmp(v->parent, "actuators") != 0) return ESP_OK;
+    if (v->event != JSON_READER_BOOL && v->event != JSON_READER_NUMBER) return ESP_OK;
+    if (commands->count == ACTUATOR_MAX) return ESP_ERR_INVALID_SIZE;
+    // Whole numbers in int32 range only: the cast of anything else (1e300, 0.5) is undefined or lossy
+    if (v->event == JSON_READER_NUMBER &&
+        (v->number < INT32_MIN || v->number > INT32_MAX || v->number != (double)(int32_t)v->number)) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON *toggle_json = cJSON_GetObjectItemCaseSensitive(root, "toggle");
-    cJSON *message_json = cJSON_GetObjectItemCaseSensitive(root, "message");
+    snprintf(commands->cmd[commands->count].name, ACTUATOR_NAME_MAX, "%s", v->key);
+    commands->cmd[commands->count].value = v->event == JSON_READER_BOOL ? v->boolean : (int32_t)v->number;
+    commands->count++;
+    return ESP_OK;
+}
+
+// One /control request, parsed as it arrives
+typedef struct {
+    int64_t received_us;
+    size_t len;
+    control_data_t next;
+    actuator_commands_t commands;
+    json_reader_bind_t bind;
+    json_reader_t reader;
+} control_request_t;
+
+static esp_err_t control_json_chunk(const void *chunk, size_t len, void *ctx)
+{
+    control_request_t *r = ctx;
+    r->len += len;
+    return json_reader_feed(&r->reader, chunk, len);
+}
+
+static esp_err_t control_json_end(esp_err_t err, void *ctx)
+{
+    control_request_t *r = ctx;
+    LOG_RING_D(TAG, "Received %d bytes", (int)r->len);
+    if (err == ESP_OK) err = json_reader_finish(&r->reader);
+    if (err == ESP_OK && !json_reader_bind_has_all(&r->bind)) err = ESP_ERR_INVALID_ARG;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid JSON format or missing fields (%s)", esp_err_to_name(err));
+        metrics_counter_inc(&s_control_rejected);
+        return err;
+    }
 
-    if (cJSON_IsBool(toggle_json) && message_json != NULL && cJSON_IsString(message_json) && (message_json->valuestring != NULL)) {
-        // Update global variables
-        global_led_state = cJSON_IsTrue(toggle_json);
-        strncpy((char*)global_message, message_json->valuestring, sizeof(global_message) - 1);
-        global_message[sizeof(global_message) - 1] = '\0'; // Ensure null termination
+    apply_control(&r->next, r->received_us);
+    for (size_t i = 0; i < r->commands.count; i++) {
+        if (actuator_command(r->commands.cmd[i].name, r->commands.cmd[i].value, r->received_us) != ESP_OK) {
+            ESP_LOGW(TAG, "Unknown actuator '%s'", r->commands.cmd[i].name);
+        }
+    }
+    return ESP_OK;
+}
 
-        ESP_LOGI(TAG, "Updated: toggle=%d, message='%s'", global_led_state, global_message);
+// Parse the body as it arrives: no body buffer, no heap, any content_len.
+// Status and responses are shared with every other HTTP control endpoint.
+static esp_err_t http_server_control_handler(httpd_req_t *req)
+{
+    control_request_t r = { .received_us = esp_timer_get_time() };
+    control_msg_json_bind(&r.bind, &r.next, collect_actuator_command, &r.commands);
+    json_reader_init(&r.reader, json_reader_bind_cb, &r.bind);
+    return control_transport_http_serve_stream(req, control_json_chunk, control_json_end, &r);
+}
 
-        httpd_resp_sendstr(req, "Data received and processed");
-    } else {
-        ESP_LOGE(TAG, "Invalid JSON format or missing fields");
-        if (!cJSON_IsBool(toggle_json)) ESP_LOGE(TAG, "'toggle' field is missing or not a boolean");
-        if (message_json == NULL || !cJSON_IsString(message_json) || message_json->valuestring == NULL) ESP_LOGE(TAG, "'message' field is missing, not a string, or null");
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON format");
+// Binary control messages (UDP), laid out as in control_msg.h
+static esp_err_t apply_control_binary(const void *payload, size_t len, void *ctx)
+{
+    int64_t received_us = received_at(ctx);
+    control_data_t next;
+    if (control_msg_decode_binary(payload, len, &next) != ESP_OK) {
+        metrics_counter_inc(&s_control_rejected);
+        return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON_Delete(root);
+    apply_control(&next, received_us);
     return ESP_OK;
 }
 
 static esp_err_t http_server_message_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Message requested");
+    LOG_RING_D(TAG, "Message requested");
 
-    // Send the current global message
+    // Send the current message, from a snapshot that no concurrent update can tear
+    control_data_t state;
+    state_store_read(&s_state, &state);
     // Set content type to plain text
     httpd_resp_set_type(req, "text/plain");
-    httpd_resp_sendstr(req, (const char*)global_message);
+    httpd_resp_sendstr(req, state.message);
 
     return ESP_OK;
 }
@@ -112,6 +179,20 @@ static const httpd_uri_t message_uri = {
     .user_ctx  = NULL
 };
 
+static const httpd_uri_t metrics_uri = {
+    .uri       = "/metrics",
+    .method    = HTTP_GET,
+    .handler   = metrics_prometheus_handler,
+    .user_ctx  = NULL
+};
+
+static const httpd_uri_t logs_uri = {
+    .uri       = "/logs",
+    .method    = HTTP_GET,
+    .handler   = log_ring_http_handler,
+    .user_ctx  = NULL
+};
+
 
 static httpd_handle_t start_webserver(void)
 {
@@ -125,14 +206,23 @@ static httpd_handle_t start_webserver(void)
     if (httpd_start(&server, &config) == ESP_OK) {
         // Register URI handlers
         ESP_LOGI(TAG, "Registering URI handlers");
-        esp_err_t ret_control = httpd_register_uri_handler(server, &control_uri);
+        // Registered through httpd_workers (inline) so each route gets a latency histogram
+        esp_err_t ret_control = httpd_workers_register_uri(server, &control_uri, HTTPD_WORKERS_INLINE);
         if (ret_control != ESP_OK) {
             ESP_LOGE(TAG, "Failed to register /control handler: %s", esp_err_to_name(ret_control));
         }
-        esp_err_t ret_message = httpd_register_uri_handler(server, &message_uri);
+        esp_err_t ret_message = httpd_workers_register_uri(server, &message_uri, HTTPD_WORKERS_INLINE);
          if (ret_message != ESP_OK) {
             ESP_LOGE(TAG, "Failed to register /message handler: %s", esp_err_to_name(ret_message));
         }
+        esp_err_t ret_metrics = httpd_workers_register_uri(server, &metrics_uri, HTTPD_WORKERS_INLINE);
+        if (ret_metrics != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register /metrics handler: %s", esp_err_to_name(ret_metrics));
+        }
+        esp_err_t ret_logs = httpd_workers_register_uri(server, &logs_uri, HTTPD_WORKERS_INLINE);
+        if (ret_logs != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register /logs handler: %s", esp_err_to_name(ret_logs));
+        }
         return server;
     }
 
@@ -140,41 +230,113 @@ static httpd_handle_t start_webserver(void)
     return NULL;
 }
 
-static void led_toggle_task(void *pvParameter)
+// Station reconnects: a wifi_reconnect state machine run in the default event loop.
+// Its retry timer (esp_timer) posts back into the loop, so no handler ever waits.
+ESP_EVENT_DEFINE_BASE(RECEIVER_WIFI_EVENT);
+enum { RECEIVER_WIFI_RETRY_TIMER };
+
+static wifi_reconnect_t s_reconnect;
+static portMUX_TYPE s_reconnect_mux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_reconnect_timer = NULL;
+static _Atomic uint32_t s_reconnect_seq = 0;        // of the armed timer, posted with its expiry
+static httpd_handle_t s_server = NULL;
+
+// Disconnect to new address, in microseconds
+static const uint32_t s_reconnect_bounds[] = { 250000, 500000, 1000000, 2500000, 5000000,
+                                               10000000, 30000000, 60000000 };
+static metrics_histogram_t s_reconnect_time;
+
+static void reconnect_timer_cb(void *arg)
 {
-    // Configure the GPIO
-    gpio_reset_pin(LED_GPIO); // Reset to default state before configuration
-    gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
+    uint32_t seq = atomic_load(&s_reconnect_seq);
+    if (esp_event_post(RECEIVER_WIFI_EVENT, RECEIVER_WIFI_RETRY_TIMER, &seq, sizeof(seq), 0) != ESP_OK) {
+        esp_timer_start_once(s_reconnect_timer, 100 * 1000);   // event queue full: try again shortly
+    }
+}
 
-    while (1) {
-        if (global_led_state) {
-            gpio_set_level(LED_GPIO, 1); // Turn LED on
-        } else {
-            gpio_set_level(LED_GPIO, 0); // Turn LED off
-        }
-        vTaskDelay(pdMS_TO_TICKS(100)); // Check state and update LED (reduced delay for responsiveness)
+static void do_reconnect_action(const wifi_reconnect_action_t *a)
+{
+    if (a->disconnect) esp_wifi_disconnect();
+    if (a->connect) {
+        // On failure no event follows; the connect timeout armed below retries
+        esp_err_t err = esp_wifi_connect();
+        if (err != ESP_OK) ESP_LOGW(TAG, "esp_wifi_connect: %s", esp_err_to_name(err));
+    }
+    if (a->stop_timer) esp_timer_stop(s_reconnect_timer);  // not running is fine
+    if (a->timer_us) {
+        atomic_store(&s_reconnect_seq, a->timer_seq);
+        esp_timer_start_once(s_reconnect_timer, a->timer_us);
     }
 }
 
+static void log_reconnect_stats(void)
+{
+    wifi_reconnect_stats_t st;
+    portENTER_CRITICAL(&s_reconnect_mux);
+    st = s_reconnect.stats;
+    portEXIT_CRITICAL(&s_reconnect_mux);
+    LOG_RING_I(TAG, "wifi: %d disconnects, %d reconnects, %d failed attempts, %d timeouts",
+               (int)st.disconnects, (int)st.reconnects, (int)st.failures, (int)st.timeouts);
+    LOG_RING_I(TAG, "wifi: reconnect avg %d ms, max %d ms, last %d ms",
+               st.reconnects ? (int)(st.reconnect_total_us / st.reconnects / 1000) : 0,
+               (int)(st.reconnect_max_us / 1000), (int)(st.reconnect_last_us / 1000));
+}
+
+static esp_err_t led_apply(int32_t value, void *ctx)
+{
+    return gpio_set_level(LED_GPIO, value != 0);
+}
+
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
+    int64_t now = esp_timer_get_time();
+    uint32_t random = esp_random();
+    wifi_reconnect_action_t action = { 0 };
+    uint32_t reconnects_before, reconnects_after, reconnect_us;
+
+    portENTER_CRITICAL(&s_reconnect_mux);
+    reconnects_before = s_reconnect.stats.reconnects;
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        action = wifi_reconnect_start(&s_reconnect, now);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        action = wifi_reconnect_disconnected(&s_reconnect, now, random);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        action = wifi_reconnect_got_ip(&s_reconnect, now);
+    } else if (event_base == RECEIVER_WIFI_EVENT && event_id == RECEIVER_WIFI_RETRY_TIMER) {
+        action = wifi_reconnect_timer(&s_reconnect, *(const uint32_t *)event_data, now, random);
+    }
+    reconnects_after = s_reconnect.stats.reconnects;
+    reconnect_us = s_reconnect.stats.reconnect_last_us;
+    portEXIT_CRITICAL(&s_reconnect_mux);
+
+    // Wi-Fi calls outside the lock; none of them waits for the connection
+    do_reconnect_action(&action);
+
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         ESP_LOGI(TAG, "WIFI_EVENT_STA_START: attempting to connect...");
-        esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "Wi-Fi disconnected, trying to reconnect...");
-        // Add a small delay before attempting to reconnect to avoid spamming connection requests
-        vTaskDelay(pdMS_TO_TICKS(5000)); 
-        esp_wifi_connect();
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
+        if (action.timer_us) {
+            ESP_LOGI(TAG, "Wi-Fi disconnected (reason %d), retrying in %d ms",
+                     event->reason, (int)(action.timer_us / 1000));
+        }
+    } else if (event_base == RECEIVER_WIFI_EVENT && action.disconnect) {
+        ESP_LOGW(TAG, "No IP address in time, retrying in %d ms", (int)(action.timer_us / 1000));
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got IP address:" IPSTR, IP2STR(&event->ip_info.ip));
+        if (reconnects_after != reconnects_before) {
+            metrics_histogram_observe(&s_reconnect_time, reconnect_us);
+            log_reconnect_stats();
+        }
 
-        // Start the HTTP server after getting IP
-        // Check if server is already running, if needed, though start_webserver should handle it.
-        if (start_webserver() == NULL) {
-            ESP_LOGE(TAG, "Failed to start webserver after getting IP.");
+        // Start the HTTP server after the first address; it keeps listening across reconnects
+        if (s_server == NULL) {
+            s_server = start_webserver();
+            if (s_server == NULL) {
+                ESP_LOGE(TAG, "Failed to start webserver after getting IP.");
+            }
         }
     }
 }
@@ -186,9 +348,21 @@ void wifi_init_sta(void)
     esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
     assert(sta_netif); // Ensure netif was created
 
+    wifi_reconnect_config_t reconnect_config = WIFI_RECONNECT_DEFAULT_CONFIG();
+    wifi_reconnect_init(&s_reconnect, &reconnect_config);
+    const esp_timer_create_args_t timer_args = {
+        .callback = reconnect_timer_cb,
+        .name = "wifi_retry",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_reconnect_timer));
+    ESP_ERROR_CHECK(metrics_histogram_init(&s_reconnect_time, "wifi_reconnect_seconds",
+                                           "Wi-Fi disconnect to new IP address", NULL, s_reconnect_bounds,
+                                           sizeof(s_reconnect_bounds) / sizeof(s_reconnect_bounds[0])));
+
     // Register event handlers
     esp_event_handler_instance_t instance_any_id;
     esp_event_handler_instance_t instance_got_ip;
+    esp_event_handler_instance_t instance_retry;
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
                                                         &event_handler,
@@ -199,6 +373,11 @@ void wifi_init_sta(void)
                                                         &event_handler,
                                                         NULL,
                                                         &instance_got_ip));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(RECEIVER_WIFI_EVENT,
+                                                        RECEIVER_WIFI_RETRY_TIMER,
+                                                        &event_handler,
+                                                        NULL,
+                                                        &instance_retry));
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -298,13 +477,30 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+    state_store_init(&s_state, &s_state_storage, sizeof(s_state_storage));
+    metrics_register_system();
+    resp_writer_register_metrics();
+    metrics_register(&s_control_ok.base);
+    metrics_register(&s_control_rejected.base);
+
+    // Hot-path logs go to the RAM ring; printed from a low-priority task, also on /logs
+    log_ring_start_console(1, 200);
+
+    // The LED changes as soon as a control message arrives; the actuator task sleeps otherwise
+    gpio_reset_pin(LED_GPIO); // Reset to default state before configuration
+    gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
+    ESP_ERROR_CHECK(actuator_register("led", led_apply, NULL, &s_led_actuator));
+    ESP_ERROR_CHECK(actuator_start(10));
+
     ESP_LOGI(TAG, "ESP_WIFI_MODE_STA");
     wifi_init_sta(); // Initializes Wi-Fi and starts connection attempts
 
-    spiffs_init();
+    // Binary control frames over UDP (socket needs the TCP/IP stack up), alongside POST /control
+    if (control_transport_udp_listen(UDP_CONTROL_DEFAULT_PORT, apply_control_binary, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start UDP control receiver");
+    }
 
-    // Start the LED toggling task
-    xTaskCreate(&led_toggle_task, "led_toggle_task", 2048, NULL, 10, NULL);
+    spiffs_init();
 
     // The HTTP server will start once Wi-Fi connects and gets an IP (handled in event_handler)
     ESP_LOGI(TAG, "Receiver initialization complete. Waiting for Wi-Fi connection and IP.");
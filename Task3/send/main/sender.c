@@ -1,12 +1,18 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <esp_wifi.h>
 #include <esp_event.h>
+#include <esp_netif.h>
 #include <esp_log.h>
-#include <esp_http_client.h>
+#include <control_transport.h>
+#include <udp_control.h>
 #include <nvs_flash.h>
 #include <sys/param.h>
 #include <esp_spiffs.h>
-#include <cJSON.h> 
+#include <control_fanout.h>
+#include <log_ring.h>
 #include <string.h> 
+#include <stdlib.h>
 #include <errno.h>
 
 static const char *TAG = "sender";
@@ -15,128 +21,92 @@ static const char *TAG = "sender";
 #define EXAMPLE_ESP_WIFI_PASS      "password123"
 #define EXAMPLE_MAX_STA_CONN       4
 
-// Receiver's IP address (default for ESP32 AP) and the endpoint for data
-#define RECEIVER_CONTROL_URL   "http://192.168.4.2/control" 
+// Receivers are the stations on the AP, found from their join and DHCP events
+#define RECEIVER_PORT           80
+#define RECEIVER_CONTROL_PATH   "/control"
+#define RECEIVER_UDP_PORT       UDP_CONTROL_DEFAULT_PORT
 
-// Struct to send to the receiver
-typedef struct {
-    bool toggle;
-    char message[100];
-} control_data_t;
+// Transport for control messages: JSON over HTTP, or binary frames over UDP (udp_control)
+#define CONTROL_TRANSPORT_HTTP  0
+#define CONTROL_TRANSPORT_UDP   1
+#define CONTROL_TRANSPORT       CONTROL_TRANSPORT_HTTP
+// The demo state changes this often; each change goes to every receiver as it happens
+#define CONTROL_PERIOD_MS       5000
+#define CONTROL_KEY             "control"
 
+// State sent to the receivers; the fields are defined in control_msg.h
 control_data_t current_control_data = {
     .toggle = false,
     .message = "Hello from sender!"
 };
 
-static esp_err_t http_client_event_handler(esp_http_client_event_t *evt)
+// Log fan-out counters every this many updates
+#define CONTROL_STATS_EVERY     12
+
+static void log_fanout_stats(void)
 {
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP_EVENT_ERROR: %s", esp_err_to_name(esp_http_client_get_errno(evt->client)));
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (evt->data_len > 0 && evt->data != NULL) {
-                 ESP_LOGI(TAG, "Received data: %.*s", evt->data_len, (char*)evt->data);
-            }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-            break;
-        case HTTP_EVENT_REDIRECT:
-            ESP_LOGI(TAG, "HTTP_EVENT_REDIRECT");
-            break;
+    control_fanout_stats_t st;
+    control_fanout_get_stats(&st);
+    LOG_RING_I(TAG, "control: %d peers, %d updates, %d reached every peer",
+               (int)st.peers, (int)st.updates, (int)st.complete);
+    LOG_RING_I(TAG, "control: all-peers latency avg %d us, max %d us, last %d us",
+               st.complete ? (int)(st.latency_total_us / st.complete) : 0, (int)st.latency_max_us,
+               (int)st.latency_last_us);
+
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) {
+        control_fanout_peer_info_t peer;
+        if (control_fanout_get_peer(i, &peer) != ESP_OK || !peer.active) continue;
+        LOG_RING_I(TAG, "peer %d: %d delivered, %d failed, %d queued",
+                   (int)i, (int)peer.outbox.delivered, (int)peer.outbox.failed, (int)peer.outbox.depth);
+        LOG_RING_I(TAG, "peer %d: latency avg %d us, last %d us", (int)i,
+                   peer.outbox.delivered ? (int)(peer.outbox.latency_total_us / peer.outbox.delivered) : 0,
+                   (int)peer.outbox.latency_last_us);
     }
-    return ESP_OK;
 }
 
-void send_control_data_task(void *pvParameter)
+// control_fanout_open_fn_t: one transport per receiver
+static esp_err_t open_control_transport(const char *host, const uint8_t mac[6], void *ctx,
+                                        control_transport_t **out)
 {
-    esp_http_client_config_t config = {
-        .url = RECEIVER_CONTROL_URL,
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_client_event_handler,
-        .transport_type = HTTP_TRANSPORT_OVER_TCP, 
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
-        vTaskDelete(NULL);
-        return; 
-    }
+#if CONTROL_TRANSPORT == CONTROL_TRANSPORT_UDP
+    return control_transport_udp_open(host, RECEIVER_UDP_PORT, out);
+#else
+    // One keep-alive connection to the receiver, reopened when it drops
+    return control_transport_http_open(host, RECEIVER_PORT, RECEIVER_CONTROL_PATH,
+                                       CONTROL_TRANSPORT_JSON, out);
+#endif
+}
 
+// Demo state source: a new message and a flipped toggle every CONTROL_PERIOD_MS
+void send_control_data_task(void *pvParameter)
+{
     bool toggle_state = false;
     int message_counter = 0;
+    TickType_t last = xTaskGetTickCount();
 
     while (1) {
         current_control_data.toggle = toggle_state;
         snprintf(current_control_data.message, sizeof(current_control_data.message), "Message #%d", message_counter++);
 
-        cJSON *root = cJSON_CreateObject();
-        if (root == NULL) {
-            ESP_LOGE(TAG, "Failed to create JSON object");
-            vTaskDelay(pdMS_TO_TICKS(5000));
-            continue;
-        }
-        cJSON_AddBoolToObject(root, "toggle", current_control_data.toggle);
-        cJSON_AddStringToObject(root, "message", current_control_data.message);
-
-        char *post_data = cJSON_PrintUnformatted(root);
-        if (post_data == NULL) {
-            ESP_LOGE(TAG, "Failed to print JSON");
-            cJSON_Delete(root);
-            vTaskDelay(pdMS_TO_TICKS(5000));
-            continue;
-        }
-
-        ESP_LOGI(TAG, "Sending data: %s", post_data);
-
-        esp_err_t set_post_err = esp_http_client_set_post_field(client, post_data, strlen(post_data));
-        if (set_post_err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to set post field: %s", esp_err_to_name(set_post_err));
-            cJSON_Delete(root);
-            cJSON_free(post_data);
-            vTaskDelay(pdMS_TO_TICKS(5000));
-            continue;
-        }
-        
-        esp_err_t set_header_err = esp_http_client_set_header(client, "Content-Type", "application/json");
-         if (set_header_err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to set Content-Type header: %s", esp_err_to_name(set_header_err));
-        }
-
-        esp_err_t err = esp_http_client_perform(client);
-
-        if (err == ESP_OK) {
-            ESP_LOGI(TAG, "HTTP POST Status = %d, content_length = %lld",
-                     (int)esp_http_client_get_status_code(client), 
-                     esp_http_client_get_content_length(client));
+        // Never waits for a receiver: each has its own outbox task for delivery and retries
+        esp_err_t err = control_fanout_put(CONTROL_KEY, &current_control_data);
+        if (err != ESP_OK) {
+            LOG_RING_E(TAG, "Control update failed: %s", esp_err_to_name(err));
         } else {
-            ESP_LOGE(TAG, "HTTP POST request failed: %s", esp_err_to_name(err));
+            LOG_RING_I(TAG, "Queued toggle=%d, message #%d", current_control_data.toggle, message_counter - 1);
         }
-
-        cJSON_Delete(root);
-        cJSON_free(post_data); 
+        if (message_counter % CONTROL_STATS_EVERY == 0) log_fanout_stats();
 
         toggle_state = !toggle_state;
-        vTaskDelay(pdMS_TO_TICKS(5000)); 
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
     }
+}
 
-    esp_http_client_cleanup(client);
-    vTaskDelete(NULL);
+static esp_err_t control_fanout_start(void)
+{
+    control_fanout_config_t config = CONTROL_FANOUT_DEFAULT_CONFIG();
+    config.open = open_control_transport;
+    return control_fanout_init(&config);
 }
 
 
@@ -150,9 +120,24 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
     else if (event_id == WIFI_EVENT_AP_STACONNECTED) {
         wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*) event_data;
         ESP_LOGI(TAG, "Station joined, AID=%d", event->aid);
+        if (control_fanout_station_join(event->mac) != ESP_OK) {
+            ESP_LOGW(TAG, "No peer slot for AID=%d", event->aid);
+        }
     } else if (event_id == WIFI_EVENT_AP_STADISCONNECTED) {
         wifi_event_ap_stadisconnected_t* event = (wifi_event_ap_stadisconnected_t*) event_data;
         ESP_LOGI(TAG, "Station left, AID=%d", event->aid);
+        control_fanout_station_leave(event->mac);
+    }
+}
+
+// DHCP lease handed out: the station becomes a control peer
+static void ip_event_handler(void* arg, esp_event_base_t event_base,
+                             int32_t event_id, void* event_data)
+{
+    if (event_id == IP_EVENT_AP_STAIPASSIGNED) {
+        ip_event_ap_staipassigned_t* event = (ip_event_ap_staipassigned_t*) event_data;
+        ESP_LOGI(TAG, "Station got IP " IPSTR, IP2STR(&event->ip));
+        control_fanout_station_address(event->mac, event->ip.addr);
     }
 }
 
@@ -182,6 +167,11 @@ void wifi_init_softap(void)
                                                         &wifi_event_handler,
                                                         NULL,
                                                         NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                        IP_EVENT_AP_STAIPASSIGNED,
+                                                        &ip_event_handler,
+                                                        NULL,
+                                                        NULL));
 
     // Configure Wi-Fi AP settings
     wifi_config_t wifi_config = {
@@ -271,6 +261,12 @@ void app_main(void)
     ESP_ERROR_CHECK(ret);
     ESP_LOGI(TAG, "NVS initialized.");
 
+    // Per-request logs go to the RAM ring; printed from a low-priority task
+    log_ring_start_console(1, 200);
+
+    // Peers are added by the Wi-Fi and IP events, so this comes first
+    ESP_ERROR_CHECK(control_fanout_start());
+
     ESP_LOGI(TAG, "ESP_WIFI_MODE_AP - Initializing SoftAP");
     wifi_init_softap(); // Initialize Wi-Fi and start AP mode
 
@@ -21,8 +21,15 @@
 #include "esp_partition.h"
 #include "errno.h" // For strerror
 #include "esp_spiffs.h"    
-#include "cJSON.h"         
 #include "esp_https_ota.h" 
+#include "web_static.h"
+#include "file_cache.h"
+#include "buf_pool.h"
+#include "json_stream.h"
+#include "httpd_workers.h"
+#include "metrics.h"
+#include "resp_cache.h"
+#include "uri_router.h"
 #include "sdkconfig.h"     // For Kconfig defines like CONFIG_SPIFFS_OBJ_NAME_LEN
 
 // --- Wi-Fi AP Configuration Macros ---
@@ -49,6 +56,16 @@
 #endif
 
 
+// RAM cache for files served from SPIFFS
+#define FILE_CACHE_BUDGET       (32 * 1024)
+#define FILE_CACHE_MAX_ENTRY    (16 * 1024)
+
+// Preallocated I/O buffers shared by the HTTP handlers
+#define IO_BUF_COUNT            2
+
+// Worker tasks that take large file transfers off the httpd task
+#define HTTP_WORKER_COUNT       2
+
 #ifndef MIN
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #endif
@@ -82,6 +99,27 @@ static esp_err_t init_spiffs(void) {
     return ESP_OK;
 }
 
+// --- /api/status response, rendered only when its inputs change ---
+// Escaped message can grow up to 6x (\uXXXX), size for the worst case
+#define API_STATUS_MAX_LEN (64 + 6 * sizeof(current_custom_message))
+
+// One pre-rendered body per representation; ctx carries the json_stream format
+static resp_cache_t s_api_status_cache;
+static resp_cache_t s_api_status_cbor_cache;
+
+static esp_err_t render_api_status(char *buf, size_t cap, size_t *len, void *ctx) {
+    json_stream_t js;
+    json_stream_init(&js, buf, cap);
+    json_stream_set_format(&js, (json_stream_format_t)(intptr_t)ctx);
+    json_stream_begin_object(&js);
+    json_stream_kv_string(&js, "firmware_version", FIRMWARE_VERSION);
+    json_stream_kv_string(&js, "custom_message", current_custom_message);
+    json_stream_end_object(&js);
+    esp_err_t err = json_stream_finish(&js);
+    *len = json_stream_len(&js);
+    return err;
+}
+
 // --- NVS Functions ---
 esp_err_t save_custom_message_nvs(const char* message) {
     nvs_handle_t nvs_handle;
@@ -98,6 +136,8 @@ esp_err_t save_custom_message_nvs(const char* message) {
         strncpy(current_custom_message, message, sizeof(current_custom_message) - 1);
         current_custom_message[sizeof(current_custom_message) - 1] = '\0';
         ESP_LOGI(TAG, "Custom message saved to NVS: %s", message);
+        resp_cache_refresh(&s_api_status_cache);
+        resp_cache_refresh(&s_api_status_cbor_cache);
     }
     return err;
 }
@@ -125,66 +165,16 @@ static esp_err_t root_get_handler(httpd_req_t *req) {
     char filepath[MAX_FILE_PATH_LEN]; 
     snprintf(filepath, sizeof(filepath), "%s/index.html", SPIFFS_MOUNT_POINT);
     ESP_LOGI(TAG, "Serving file: %s", filepath);
-    struct stat st;
-    if (stat(filepath, &st) == -1) {
-        ESP_LOGE(TAG, "File %s not found, error %d (%s)", filepath, errno, strerror(errno));
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
-        return ESP_FAIL;
-    }
-    int fd = open(filepath, O_RDONLY, 0);
-    if (fd == -1) {
-        ESP_LOGE(TAG, "Failed to open file: %s, error %d (%s)", filepath, errno, strerror(errno));
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read file");
-        return ESP_FAIL;
-    }
-    httpd_resp_set_type(req, "text/html");
-    char *chunk = (char *)malloc(OTA_BUF_SIZE);
-    if (!chunk) {
-        ESP_LOGE(TAG, "Failed to allocate memory for file chunk");
-        close(fd);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation error");
-        return ESP_FAIL;
-    }
-    ssize_t read_bytes;
-    do {
-        read_bytes = read(fd, chunk, OTA_BUF_SIZE);
-        if (read_bytes > 0) {
-            if (httpd_resp_send_chunk(req, chunk, read_bytes) != ESP_OK) {
-                ESP_LOGE(TAG, "File sending failed!");
-                close(fd); free(chunk); return ESP_FAIL;
-            }
-        } else if (read_bytes < 0) {
-            ESP_LOGE(TAG, "Error reading file: %s, error %d (%s)", filepath, errno, strerror(errno));
-            close(fd); free(chunk); return ESP_FAIL;
-        }
-    } while (read_bytes > 0);
-    close(fd); free(chunk);
-    if (httpd_resp_send_chunk(req, NULL, 0) != ESP_OK) { 
-        ESP_LOGE(TAG, "Failed to send final chunk."); return ESP_FAIL;
-    }
-    ESP_LOGI(TAG, "File sending complete: %s", filepath);
-    return ESP_OK;
+    // Range / 206 Partial Content handling lives in web_static
+    return web_static_send_file(req, filepath, "text/html");
 }
 
 static esp_err_t api_status_get_handler(httpd_req_t *req) {
     ESP_LOGI(TAG, "/api/status called");
-    httpd_resp_set_type(req, "application/json");
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) { httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON creation failed (root)"); return ESP_FAIL; }
-    if(cJSON_AddStringToObject(root, "firmware_version", FIRMWARE_VERSION) == NULL) {
-        cJSON_Delete(root); httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON creation failed (version)"); return ESP_FAIL;
-    }
-    if(cJSON_AddStringToObject(root, "custom_message", current_custom_message) == NULL) {
-        cJSON_Delete(root); httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON creation failed (message)"); return ESP_FAIL;
-    }
-    char *json_string = cJSON_PrintUnformatted(root);
-    if (json_string == NULL) {
-        ESP_LOGE(TAG, "Failed to print cJSON object");
-        cJSON_Delete(root); httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON stringification failed"); return ESP_FAIL;
-    }
-    httpd_resp_send(req, json_string, strlen(json_string));
-    free(json_string); cJSON_Delete(root);
-    return ESP_OK;
+    // Pre-rendered body + ETag; regenerated by save_custom_message_nvs()
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+    if (json_stream_accepts_cbor(req)) return resp_cache_send(&s_api_status_cbor_cache, req);
+    return resp_cache_send(&s_api_status_cache, req);
 }
 
 static esp_err_t update_message_post_handler(httpd_req_t *req) {
@@ -277,21 +267,25 @@ static esp_err_t ota_post_handler(httpd_req_t *req) {
 }
 
 // --- HTTP Server Setup ---
+// Route table generated from routes.txt (perfect hash, see uri_router.h)
+#include "uri_routes.inc"
+
 static httpd_handle_t start_webserver(void) {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 10; 
+    config.uri_match_fn = httpd_uri_match_wildcard; // one catch-all per method, uri_router dispatches
     config.stack_size = 8192;    
-    httpd_uri_t root_uri = { .uri = "/", .method = HTTP_GET, .handler = root_get_handler, .user_ctx = NULL};
-    httpd_uri_t api_status_uri = { .uri = "/api/status", .method = HTTP_GET, .handler = api_status_get_handler, .user_ctx = NULL};
-    httpd_uri_t update_msg_uri = { .uri = "/update-message", .method = HTTP_POST, .handler = update_message_post_handler, .user_ctx = NULL};
-    httpd_uri_t ota_uri = { .uri = "/ota", .method = HTTP_POST, .handler = ota_post_handler, .user_ctx = NULL};
+    httpd_workers_config_t workers_cfg = HTTPD_WORKERS_DEFAULT_CONFIG();
+    workers_cfg.num_workers = HTTP_WORKER_COUNT;
+    if (httpd_workers_start(&workers_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start HTTP workers!");
+        return NULL;
+    }
     ESP_LOGI(TAG, "Starting HTTP server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) == ESP_OK) {
-        httpd_register_uri_handler(server, &root_uri);
-        httpd_register_uri_handler(server, &api_status_uri);
-        httpd_register_uri_handler(server, &update_msg_uri);
-        httpd_register_uri_handler(server, &ota_uri);
+        if (uri_router_start(server, &uri_router_table) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register routes!");
+        }
         return server;
     }
     ESP_LOGE(TAG, "Error starting HTTP server!");
@@ -365,8 +359,15 @@ void app_main(void) {
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    ESP_ERROR_CHECK(buf_pool_init(OTA_BUF_SIZE, IO_BUF_COUNT));
+    metrics_register_system();
     load_custom_message_nvs();
+    ESP_ERROR_CHECK(resp_cache_init(&s_api_status_cache, "/api/status", "application/json",
+                                    API_STATUS_MAX_LEN, render_api_status, (void *)(intptr_t)JSON_STREAM_FMT_JSON));
+    ESP_ERROR_CHECK(resp_cache_init(&s_api_status_cbor_cache, "/api/status.cbor", "application/cbor",
+                                    API_STATUS_MAX_LEN, render_api_status, (void *)(intptr_t)JSON_STREAM_FMT_CBOR));
     ESP_ERROR_CHECK(init_spiffs()); 
+    ESP_ERROR_CHECK(file_cache_init(FILE_CACHE_BUDGET, FILE_CACHE_MAX_ENTRY));
     const esp_partition_t *running = esp_ota_get_running_partition();
     ESP_LOGI(TAG, "Running partition: %s. Firmware Version: %s", running->label, FIRMWARE_VERSION);
     wifi_init_softap();
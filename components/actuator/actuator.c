@@ -0,0 +1,157 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "metrics.h"
+#include "actuator.h"
+
+static const char *TAG = "actuator";
+
+_Static_assert(ACTUATOR_MAX <= 32, "one notification bit per actuator");
+
+typedef struct {
+    const char *name;
+    actuator_apply_fn_t apply;
+    void *ctx;
+    bool pending;               // set, not applied yet
+    int32_t pending_value;
+    int64_t pending_received_us;
+    actuator_stats_t stats;
+    metrics_histogram_t latency;
+    char labels[16 + ACTUATOR_NAME_MAX];
+} actuator_t;
+
+static const uint32_t s_latency_bounds[] = ACTUATOR_LATENCY_BUCKETS_US;
+
+static actuator_t s_actuators[ACTUATOR_MAX];
+static int s_count = 0;
+static TaskHandle_t s_task = NULL;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static metrics_counter_t s_commands = METRICS_COUNTER_INIT(
+    "actuator_commands_total", "Commands received by actuators");
+static metrics_counter_t s_coalesced = METRICS_COUNTER_INIT(
+    "actuator_coalesced_total", "Commands replaced by a newer one before being applied");
+
+static void apply_one(actuator_t *a)
+{
+    portENTER_CRITICAL(&s_mux);
+    bool pending = a->pending;
+    int32_t value = a->pending_value;
+    int64_t received_us = a->pending_received_us;
+    a->pending = false;
+    portEXIT_CRITICAL(&s_mux);
+    if (!pending) return;
+
+    esp_err_t err = a->apply(value, a->ctx);
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - received_us);
+
+    portENTER_CRITICAL(&s_mux);
+    if (err == ESP_OK) {
+        a->stats.applied++;
+        a->stats.value = value;
+        a->stats.latency_total_us += latency;
+        a->stats.latency_last_us = latency;
+        if (latency > a->stats.latency_max_us) a->stats.latency_max_us = latency;
+    } else {
+        a->stats.failed++;
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    if (err == ESP_OK) {
+        metrics_histogram_observe(&a->latency, latency);
+    } else {
+        ESP_LOGW(TAG, "%s: apply %ld failed: %s", a->name, (long)value, esp_err_to_name(err));
+    }
+}
+
+static void actuator_task(void *arg)
+{
+    for (;;) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        for (int i = 0; bits != 0; i++, bits >>= 1) {
+            if (bits & 1) apply_one(&s_actuators[i]);
+        }
+    }
+}
+
+esp_err_t actuator_register(const char *name, actuator_apply_fn_t apply, void *ctx, int *out_id)
+{
+    if (!name || !apply || !out_id || strlen(name) >= ACTUATOR_NAME_MAX) return ESP_ERR_INVALID_ARG;
+
+    if (s_count == ACTUATOR_MAX) return ESP_ERR_NO_MEM;
+
+    // Filled in before s_count covers it, so actuator_set() never sees a half-made entry
+    int id = s_count;
+    actuator_t *a = &s_actuators[id];
+    a->name = name;
+    a->apply = apply;
+    a->ctx = ctx;
+    snprintf(a->labels, sizeof(a->labels), "actuator=\"%s\"", name);
+    esp_err_t err = metrics_histogram_init(&a->latency, "actuator_latency_seconds",
+                                           "Command receipt to output change", a->labels,
+                                           s_latency_bounds, sizeof(s_latency_bounds) / sizeof(s_latency_bounds[0]));
+    if (err != ESP_OK) return err;
+
+    portENTER_CRITICAL(&s_mux);
+    s_count++;
+    portEXIT_CRITICAL(&s_mux);
+    *out_id = id;
+    return ESP_OK;
+}
+
+esp_err_t actuator_start(UBaseType_t priority)
+{
+    if (s_task) return ESP_ERR_INVALID_STATE;
+    metrics_register(&s_commands.base);
+    metrics_register(&s_coalesced.base);
+    if (xTaskCreate(actuator_task, "actuator", 2560, NULL, priority, &s_task) != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t actuator_set(int id, int32_t value, int64_t received_us)
+{
+    if (id < 0 || id >= s_count) return ESP_ERR_INVALID_ARG;
+    if (!s_task) return ESP_ERR_INVALID_STATE;
+    actuator_t *a = &s_actuators[id];
+
+    portENTER_CRITICAL(&s_mux);
+    bool replaced = a->pending;
+    a->pending = true;
+    a->pending_value = value;
+    a->pending_received_us = received_us;
+    a->stats.commands++;
+    if (replaced) a->stats.coalesced++;
+    portEXIT_CRITICAL(&s_mux);
+
+    metrics_counter_inc(&s_commands);
+    if (replaced) metrics_counter_inc(&s_coalesced);
+    xTaskNotify(s_task, 1u << id, eSetBits);
+    return ESP_OK;
+}
+
+esp_err_t actuator_command(const char *name, int32_t value, int64_t received_us)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (strcmp(s_actuators[i].name, name) == 0) {
+            return actuator_set(i, value, received_us);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t actuator_get_stats(int id, actuator_stats_t *stats)
+{
+    if (id < 0 || id >= s_count) return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    *stats = s_actuators[id].stats;
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
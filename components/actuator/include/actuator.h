@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACTUATOR_MAX            8
+#define ACTUATOR_NAME_MAX       16
+
+// Command receipt to output change, in microseconds
+#define ACTUATOR_LATENCY_BUCKETS_US { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000 }
+
+/**
+ * @brief Drive the output to @p value. Runs in the actuator task.
+ */
+typedef esp_err_t (*actuator_apply_fn_t)(int32_t value, void *ctx);
+
+typedef struct {
+    uint32_t commands;          // actuator_set() calls
+    uint32_t coalesced;         // replaced a value the task had not applied yet
+    uint32_t applied;
+    uint32_t failed;            // apply returned an error
+    int32_t value;              // last applied
+    uint64_t latency_total_us;  // receipt to apply() returning, over applied
+    uint32_t latency_max_us;
+    uint32_t latency_last_us;
+} actuator_stats_t;
+
+/**
+ * @brief Register a named output; @p name must be static.
+ *
+ * Call at startup, from one task; commands may already be flowing for
+ * actuators registered earlier.
+ * Also registers an "actuator_latency_seconds{actuator=name}" histogram.
+ */
+esp_err_t actuator_register(const char *name, actuator_apply_fn_t apply, void *ctx, int *out_id);
+
+/**
+ * @brief Start the task that applies commands. It sleeps until one arrives.
+ */
+esp_err_t actuator_start(UBaseType_t priority);
+
+/**
+ * @brief Command actuator @p id to @p value and wake the task.
+ *
+ * Never blocks; safe from any task. Values set faster than the task
+ * applies them are coalesced, only the newest is applied.
+ *
+ * @param received_us esp_timer_get_time() when the command arrived, for latency
+ */
+esp_err_t actuator_set(int id, int32_t value, int64_t received_us);
+
+/**
+ * @brief actuator_set() by name, for commands that name their target.
+ *
+ * @return ESP_ERR_NOT_FOUND for an unknown name
+ */
+esp_err_t actuator_command(const char *name, int32_t value, int64_t received_us);
+
+esp_err_t actuator_get_stats(int id, actuator_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "asset_fs.h"
+
+static const char *TAG = "asset_fs";
+
+static const uint8_t *s_base = NULL;
+static const asset_fs_entry_t *s_index = NULL;
+static size_t s_count = 0;
+static size_t s_image_size = 0;
+
+uint32_t asset_fs_hash(const char *name)
+{
+    uint32_t h = 2166136261u;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+esp_err_t asset_fs_mount(const char *label)
+{
+    if (s_base) return ESP_ERR_INVALID_STATE;
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        ESP_LOGW(TAG, "No '%s' partition", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Check the header before spending MMU pages on the whole image
+    asset_fs_header_t hdr;
+    esp_err_t err = esp_partition_read(part, 0, &hdr, sizeof(hdr));
+    if (err != ESP_OK) return err;
+    size_t tables = sizeof(hdr) + (size_t)hdr.count * sizeof(asset_fs_entry_t) + hdr.names_size;
+    if (hdr.magic != ASSET_FS_MAGIC || hdr.version != ASSET_FS_VERSION ||
+        hdr.image_size > part->size || tables > hdr.image_size) {
+        ESP_LOGW(TAG, "'%s' holds no valid asset bundle", label);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    const void *map;
+    esp_partition_mmap_handle_t handle;
+    err = esp_partition_mmap(part, 0, hdr.image_size, ESP_PARTITION_MMAP_DATA, &map, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_index = (const asset_fs_entry_t *)((const uint8_t *)map + sizeof(hdr));
+    s_count = hdr.count;
+    s_image_size = hdr.image_size;
+    s_base = map;
+    ESP_LOGI(TAG, "Mapped '%s': %u files, %u bytes", label, (unsigned)s_count, (unsigned)hdr.image_size);
+    return ESP_OK;
+}
+
+// Bounds are checked per lookup instead of walking the whole index at mount
+static bool span_ok(uint32_t offset, uint32_t size)
+{
+    return offset <= s_image_size && size <= s_image_size - offset;
+}
+
+static bool name_matches(const asset_fs_entry_t *e, const char *name)
+{
+    size_t len = strlen(name);
+    return span_ok(e->name_offset, len + 1) &&
+           memcmp(s_base + e->name_offset, name, len + 1) == 0;
+}
+
+bool asset_fs_find(const char *name, asset_fs_file_t *file)
+{
+    uint32_t hash = asset_fs_hash(name);
+
+    // Lower bound of hash in the sorted index
+    size_t lo = 0, hi = s_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (s_index[mid].name_hash < hash) lo = mid + 1; else hi = mid;
+    }
+
+    for (; lo < s_count && s_index[lo].name_hash == hash; lo++) {
+        const asset_fs_entry_t *e = &s_index[lo];
+        if (!name_matches(e, name)) continue;
+        if (!span_ok(e->offset, e->size) || (e->gz_offset && !span_ok(e->gz_offset, e->gz_size))) {
+            ESP_LOGE(TAG, "Corrupt index entry for %s", name);
+            return false;
+        }
+
+        file->data = s_base + e->offset;
+        file->size = e->size;
+        file->gz_data = e->gz_offset ? s_base + e->gz_offset : NULL;
+        file->gz_size = e->gz_offset ? e->gz_size : 0;
+        // Hex by hand: this runs on every lookup
+        static const char hex[] = "0123456789abcdef";
+        char *p = file->etag;
+        *p++ = '"';
+        for (size_t i = 0; i < ASSET_FS_DIGEST_LEN; i++) {
+            *p++ = hex[e->digest[i] >> 4];
+            *p++ = hex[e->digest[i] & 0xf];
+        }
+        *p++ = '"';
+        *p = '\0';
+        return true;
+    }
+    return false;
+}
+
+size_t asset_fs_count(void)
+{
+    return s_count;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Read-only asset bundle, built by components/asset_fs/mkassets.py:
+ *
+ *   asset_fs_header_t
+ *   asset_fs_entry_t[count]     sorted by name_hash
+ *   name table                  NUL-terminated paths
+ *   payloads                    each starting on an ASSET_FS_ALIGN boundary
+ *
+ * All integers are little-endian; offsets are from the image start.
+ * Lookups binary-search the index by hash, so nothing is parsed at boot.
+ */
+#define ASSET_FS_MAGIC      0x41505345u     // "ESPA"
+#define ASSET_FS_VERSION    2
+#define ASSET_FS_ALIGN      16
+#define ASSET_FS_DIGEST_LEN 8               // leading bytes of the SHA-256
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t image_size;                    // whole bundle, header included
+    uint32_t names_size;                    // bytes in the name table
+} asset_fs_header_t;
+
+typedef struct {
+    uint32_t name_hash;                     // asset_fs_hash() of the name
+    uint32_t name_offset;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t gz_offset;                     // gzip variant, 0 if not worth storing
+    uint32_t gz_size;
+    uint8_t digest[ASSET_FS_DIGEST_LEN];    // of the plain content
+} asset_fs_entry_t;
+
+/**
+ * @brief A file in the bundle. Pointers reference mapped flash.
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const uint8_t *gz_data;                 // NULL when there is no gzip variant
+    size_t gz_size;
+    char etag[2 * ASSET_FS_DIGEST_LEN + 3]; // quoted hex digest
+} asset_fs_file_t;
+
+/**
+ * @brief Map the bundle in partition @p label into the data address space.
+ *
+ * Only the header is checked; the mapping stays for the lifetime of the
+ * application, so pointers from asset_fs_find() never go stale.
+ */
+esp_err_t asset_fs_mount(const char *label);
+
+/**
+ * @brief Look up @p name (e.g. "/index.html") in O(log n).
+ *
+ * @return false if nothing is mounted or the file is not in the bundle
+ */
+bool asset_fs_find(const char *name, asset_fs_file_t *file);
+
+/**
+ * @brief Number of files in the mounted bundle, 0 if none.
+ */
+size_t asset_fs_count(void);
+
+/**
+ * @brief 32-bit FNV-1a, the index key (mkassets.py uses the same function).
+ */
+uint32_t asset_fs_hash(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Pack a directory into an asset_fs bundle (see asset_fs.h).
+
+    python mkassets.py <base_dir> <output.bin> [--max-size BYTES]
+
+Files that shrink by at least --min-gain under gzip also get a gzip
+variant. The output is byte-for-byte reproducible for the same input.
+"""
+import argparse
+import gzip
+import hashlib
+import os
+import struct
+import sys
+
+MAGIC = 0x41505345          # "ESPA"
+VERSION = 2
+ALIGN = 16
+DIGEST_LEN = 8
+
+HEADER = struct.Struct('<IHHII')
+ENTRY = struct.Struct('<IIIIII%ds' % DIGEST_LEN)
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def align(n):
+    return (n + ALIGN - 1) & ~(ALIGN - 1)
+
+
+def collect(base_dir):
+    files = []
+    for root, _, names in os.walk(base_dir):
+        for name in names:
+            path = os.path.join(root, name)
+            rel = '/' + os.path.relpath(path, base_dir).replace(os.sep, '/')
+            with open(path, 'rb') as f:
+                files.append((rel.encode(), f.read()))
+    return files
+
+
+def build(files, min_gain):
+    files.sort(key=lambda f: (fnv1a(f[0]), f[0]))
+
+    names = b''
+    name_offsets = []
+    tables = HEADER.size + ENTRY.size * len(files)
+    for name, _ in files:
+        name_offsets.append(tables + len(names))
+        names += name + b'\0'
+
+    payload = bytearray()
+    base = align(tables + len(names))
+
+    def place(data):
+        offset = base + len(payload)
+        payload.extend(data)
+        payload.extend(b'\0' * (align(len(payload)) - len(payload)))
+        return offset
+
+    index = b''
+    for (name, data), name_offset in zip(files, name_offsets):
+        offset = place(data)
+        gz_offset = gz_size = 0
+        packed = gzip.compress(data, compresslevel=9, mtime=0)
+        if len(packed) <= len(data) * (1 - min_gain):
+            gz_offset, gz_size = place(packed), len(packed)
+        digest = hashlib.sha256(data).digest()[:DIGEST_LEN]
+        index += ENTRY.pack(fnv1a(name), name_offset, offset, len(data), gz_offset, gz_size, digest)
+
+    pad = b'\0' * (base - tables - len(names))
+    image_size = base + len(payload)
+    return HEADER.pack(MAGIC, VERSION, len(files), image_size, len(names)) + index + names + pad + bytes(payload)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('base_dir')
+    parser.add_argument('output')
+    parser.add_argument('--max-size', type=lambda s: int(s, 0), default=0)
+    parser.add_argument('--min-gain', type=float, default=0.1,
+                        help='minimum relative size reduction to keep a gzip variant')
+    args = parser.parse_args()
+
+    files = collect(args.base_dir)
+    if len(files) > 0xffff:
+        sys.exit('Too many files')
+    image = build(files, args.min_gain)
+    if args.max_size and len(image) > args.max_size:
+        sys.exit('Image is %d bytes, partition holds %d' % (len(image), args.max_size))
+    with open(args.output, 'wb') as f:
+        f.write(image)
+    print('%s: %d files, %d bytes' % (args.output, len(files), len(image)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,30 @@
+# asset_fs_create_partition_image
+#
+# Pack base_dir into an asset_fs image for the given partition, like
+# spiffs_create_partition_image. With FLASH_IN_PROJECT the image is
+# written by `idf.py flash`.
+set(ASSET_FS_MKASSETS ${CMAKE_CURRENT_LIST_DIR}/mkassets.py CACHE INTERNAL "")
+
+function(asset_fs_create_partition_image partition base_dir)
+    set(options FLASH_IN_PROJECT)
+    cmake_parse_arguments(arg "${options}" "" "" "${ARGN}")
+
+    idf_build_get_property(python PYTHON)
+    get_filename_component(base_dir_full "${base_dir}" ABSOLUTE)
+    partition_table_get_partition_info(size "--partition-name ${partition}" "size")
+
+    set(image_file ${CMAKE_BINARY_DIR}/${partition}.bin)
+    file(GLOB_RECURSE asset_files "${base_dir_full}/*")
+
+    add_custom_command(OUTPUT ${image_file}
+        COMMAND ${python} ${ASSET_FS_MKASSETS} ${base_dir_full} ${image_file} --max-size ${size}
+        DEPENDS ${asset_files} ${ASSET_FS_MKASSETS}
+        COMMENT "Packing ${base_dir} into ${partition}.bin"
+        VERBATIM)
+    add_custom_target(asset_fs_${partition}_bin ALL DEPENDS ${image_file})
+
+    if(arg_FLASH_IN_PROJECT)
+        esptool_py_flash_to_partition(flash "${partition}" "${image_file}")
+        add_dependencies(flash asset_fs_${partition}_bin)
+    endif()
+endfunction()
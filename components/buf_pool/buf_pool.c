@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "buf_pool.h"
+
+static const char *TAG = "buf_pool";
+
+static uint8_t *s_block = NULL;         // count * buf_size bytes
+static uint16_t *s_free = NULL;         // stack of free buffer indices
+static size_t s_free_top = 0;
+static SemaphoreHandle_t s_avail = NULL;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static buf_pool_stats_t s_stats = { .buf_size = BUF_POOL_DEFAULT_BUF_SIZE };
+
+esp_err_t buf_pool_init(size_t buf_size, size_t count)
+{
+    if (s_block) return ESP_ERR_INVALID_STATE;
+    if (buf_size == 0 || count == 0 || count > UINT16_MAX) return ESP_ERR_INVALID_ARG;
+
+    s_block = heap_caps_malloc(buf_size * count, MALLOC_CAP_8BIT);
+    s_free = malloc(count * sizeof(*s_free));
+    s_avail = xSemaphoreCreateCounting(count, count);
+    if (!s_block || !s_free || !s_avail) {
+        ESP_LOGE(TAG, "Failed to allocate %u x %u byte pool", (unsigned)count, (unsigned)buf_size);
+        free(s_block); free(s_free);
+        if (s_avail) vSemaphoreDelete(s_avail);
+        s_block = NULL; s_free = NULL; s_avail = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < count; i++) s_free[i] = (uint16_t)i;
+    s_free_top = count;
+    s_stats.count = count;
+    s_stats.buf_size = buf_size;
+    ESP_LOGI(TAG, "Buffer pool: %u x %u bytes", (unsigned)count, (unsigned)buf_size);
+    return ESP_OK;
+}
+
+// A pool buffer, or NULL if none frees up within @p wait
+static void *take(TickType_t wait)
+{
+    if (!s_avail) return NULL;
+    bool got = xSemaphoreTake(s_avail, 0) == pdTRUE;
+    if (!got && wait > 0) {
+        portENTER_CRITICAL(&s_mux);
+        s_stats.waited++;
+        portEXIT_CRITICAL(&s_mux);
+        got = xSemaphoreTake(s_avail, wait) == pdTRUE;
+    }
+    if (!got) return NULL;
+    portENTER_CRITICAL(&s_mux);
+    uint16_t idx = s_free[--s_free_top];
+    s_stats.acquired++;
+    if (++s_stats.in_use > s_stats.in_use_max) s_stats.in_use_max = s_stats.in_use;
+    portEXIT_CRITICAL(&s_mux);
+    return s_block + (size_t)idx * s_stats.buf_size;
+}
+
+void *buf_pool_try_get(TickType_t wait)
+{
+    void *buf = take(wait);
+    if (!buf) {
+        portENTER_CRITICAL(&s_mux);
+        s_stats.try_failed++;
+        portEXIT_CRITICAL(&s_mux);
+    }
+    return buf;
+}
+
+void *buf_pool_get(TickType_t wait)
+{
+    void *buf = take(wait);
+    if (buf) return buf;
+
+    // Pool missing or exhausted: serve the request from the heap instead of failing it
+    buf = malloc(s_stats.buf_size);
+    portENTER_CRITICAL(&s_mux);
+    if (s_avail) s_stats.exhausted++;
+    if (!buf) s_stats.fallback_failed++;
+    portEXIT_CRITICAL(&s_mux);
+    if (!buf) ESP_LOGW(TAG, "Pool exhausted and heap fallback failed");
+    return buf;
+}
+
+void buf_pool_put(void *buf)
+{
+    if (!buf) return;
+    uint8_t *p = buf;
+    if (s_block && p >= s_block && p < s_block + s_stats.count * s_stats.buf_size) {
+        portENTER_CRITICAL(&s_mux);
+        s_free[s_free_top++] = (uint16_t)((p - s_block) / s_stats.buf_size);
+        s_stats.in_use--;
+        portEXIT_CRITICAL(&s_mux);
+        xSemaphoreGive(s_avail);
+    } else {
+        free(buf);
+    }
+}
+
+size_t buf_pool_buf_size(void)
+{
+    return s_stats.buf_size;
+}
+
+void buf_pool_get_stats(buf_pool_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_mux);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_mux);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Buffer size reported before buf_pool_init() (fallback allocations only)
+#define BUF_POOL_DEFAULT_BUF_SIZE   4096
+
+/**
+ * @brief Pool counters, as returned by buf_pool_get_stats().
+ */
+typedef struct {
+    uint32_t acquired;          // buffers handed out from the pool
+    uint32_t waited;            // acquisitions that had to block for a free buffer
+    uint32_t exhausted;         // wait timed out, fell back to the heap
+    uint32_t fallback_failed;   // heap fallback failed too (caller got NULL)
+    uint32_t try_failed;        // buf_pool_try_get() found no free buffer
+    uint32_t in_use;            // pool buffers currently handed out
+    uint32_t in_use_max;        // high-water mark of in_use
+    uint32_t count;             // pool size
+    size_t buf_size;
+} buf_pool_stats_t;
+
+/**
+ * @brief Preallocate @p count buffers of @p buf_size bytes as one block.
+ *
+ * Call once at boot, before the heap has had a chance to fragment.
+ */
+esp_err_t buf_pool_init(size_t buf_size, size_t count);
+
+/**
+ * @brief Take a buffer of buf_pool_buf_size() bytes.
+ *
+ * Blocks up to @p wait ticks for a pool buffer, then falls back to malloc().
+ *
+ * @return buffer, or NULL if both the pool and the heap are exhausted.
+ */
+void *buf_pool_get(TickType_t wait);
+
+/**
+ * @brief Like buf_pool_get(), but never falls back to the heap.
+ *
+ * For callers that can do without a buffer (e.g. by sending unbuffered),
+ * so a busy pool does not turn into heap allocations.
+ *
+ * @return pool buffer, or NULL if none freed up within @p wait ticks or
+ *         the pool was never initialised
+ */
+void *buf_pool_try_get(TickType_t wait);
+
+/**
+ * @brief Return a buffer obtained from buf_pool_get(). NULL is ignored.
+ */
+void buf_pool_put(void *buf);
+
+size_t buf_pool_buf_size(void);
+
+void buf_pool_get_stats(buf_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
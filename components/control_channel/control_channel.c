@@ -0,0 +1,411 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "control_channel.h"
+
+static const char *TAG = "control_channel";
+
+#define RX_BUF_SIZE     512
+#define HDR_MAX         192
+
+// Requests pipelined behind a "Connection: close" hit a closed socket; report that as an error, not a signal
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL    0
+#endif
+
+typedef struct {
+    int64_t first_sent_us;
+    bool written_before;        // already went out on an earlier connection
+    size_t len;
+    char body[CONTROL_CHANNEL_MAX_BODY];
+} pending_t;
+
+struct control_channel {
+    control_channel_config_t cfg;
+    int sock;
+    pending_t pending[CONTROL_CHANNEL_MAX_PIPELINE];  // FIFO of requests awaiting a response
+    size_t head;
+    size_t count;
+    size_t written;             // pending entries already on the current connection
+    char rx[RX_BUF_SIZE];
+    size_t rx_len;
+    int64_t deadline_us;        // during control_channel_poll(): connects and waits for a response end by then
+    control_channel_stats_t stats;
+};
+
+static void drop_connection(control_channel_t *ch)
+{
+    if (ch->sock >= 0) {
+        close(ch->sock);
+        ch->sock = -1;
+    }
+    ch->rx_len = 0;
+    ch->written = 0;
+}
+
+static esp_err_t send_all(control_channel_t *ch, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(ch->sock, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ESP_LOGD(TAG, "send: errno %d", errno);
+            return errno == EAGAIN || errno == EWOULDBLOCK ? ESP_ERR_TIMEOUT : ESP_FAIL;
+        }
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+// Header and body in one send() so a request fits one segment
+static esp_err_t write_request(control_channel_t *ch, pending_t *p)
+{
+    char buf[HDR_MAX + CONTROL_CHANNEL_MAX_BODY];
+    int n = snprintf(buf, HDR_MAX,
+                     "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n\r\n",
+                     ch->cfg.path, ch->cfg.host, ch->cfg.content_type, (unsigned)p->len);
+    if (n < 0 || n >= HDR_MAX) return ESP_ERR_INVALID_SIZE;
+    memcpy(buf + n, p->body, p->len);
+
+    esp_err_t err = send_all(ch, buf, n + p->len);
+    if (err == ESP_OK) {
+        ch->stats.sent++;
+        if (p->written_before) ch->stats.resent++;
+        p->written_before = true;
+    }
+    return err;
+}
+
+// Write the queued requests not yet on this connection
+static esp_err_t write_pending(control_channel_t *ch)
+{
+    while (ch->written < ch->count) {
+        esp_err_t err = write_request(ch, &ch->pending[(ch->head + ch->written) % CONTROL_CHANNEL_MAX_PIPELINE]);
+        if (err != ESP_OK) return err;
+        ch->written++;
+    }
+    return ESP_OK;
+}
+
+// connect() bounded by timeout_ms; a receiver that is gone would otherwise
+// hold the caller for the whole TCP SYN retry schedule
+static esp_err_t connect_timeout(int sock, const struct sockaddr *addr, socklen_t addr_len, uint32_t timeout_ms)
+{
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0) return ESP_FAIL;
+
+    esp_err_t err = ESP_OK;
+    if (connect(sock, addr, addr_len) != 0) {
+        if (errno != EINPROGRESS) return ESP_FAIL;
+        fd_set wr;
+        FD_ZERO(&wr);
+        FD_SET(sock, &wr);
+        struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+        int rc = select(sock + 1, NULL, &wr, NULL, &tv);
+        int so_error = 0;
+        socklen_t len = sizeof(so_error);
+        if (rc == 0) {
+            err = ESP_ERR_TIMEOUT;
+        } else if (rc < 0 || getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0 || so_error != 0) {
+            if (so_error) errno = so_error;
+            err = ESP_FAIL;
+        }
+    }
+    if (err == ESP_OK && fcntl(sock, F_SETFL, flags) < 0) err = ESP_FAIL;
+    return err;
+}
+
+// The channel's timeout, or less when a poll deadline is nearer; 0 once it has passed
+static uint32_t time_left_ms(control_channel_t *ch)
+{
+    if (ch->deadline_us == 0) return ch->cfg.timeout_ms;
+    int64_t left_ms = (ch->deadline_us - esp_timer_get_time()) / 1000;
+    if (left_ms <= 0) return 0;
+    return left_ms < ch->cfg.timeout_ms ? (uint32_t)left_ms : ch->cfg.timeout_ms;
+}
+
+static esp_err_t connect_channel(control_channel_t *ch)
+{
+    uint32_t timeout_ms = time_left_ms(ch);
+    if (timeout_ms == 0) return ESP_ERR_TIMEOUT;
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u", ch->cfg.port);
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(ch->cfg.host, port, &hints, &res) != 0 || res == NULL) {
+        ch->stats.connect_failures++;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sock < 0) {
+        freeaddrinfo(res);
+        ch->stats.connect_failures++;
+        return ESP_ERR_NO_MEM;
+    }
+    struct timeval tv = { .tv_sec = ch->cfg.timeout_ms / 1000, .tv_usec = (ch->cfg.timeout_ms % 1000) * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));     // pipelined requests go out at once
+
+    esp_err_t err = connect_timeout(sock, res->ai_addr, res->ai_addrlen, timeout_ms);
+    freeaddrinfo(res);
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "connect %s:%u: %s, errno %d", ch->cfg.host, ch->cfg.port, esp_err_to_name(err), errno);
+        close(sock);
+        ch->stats.connect_failures++;
+        return err;
+    }
+    ch->sock = sock;
+    ch->stats.connects++;
+    ESP_LOGD(TAG, "connected to %s:%u, %u queued", ch->cfg.host, ch->cfg.port, (unsigned)ch->count);
+
+    // Anything still queued was lost with the previous connection
+    return write_pending(ch);
+}
+
+// Drop the connection and start over on a new one
+static esp_err_t reconnect(control_channel_t *ch)
+{
+    drop_connection(ch);
+    esp_err_t err = connect_channel(ch);
+    if (err != ESP_OK) drop_connection(ch);
+    return err;
+}
+
+static esp_err_t fill(control_channel_t *ch)
+{
+    for (;;) {
+        ssize_t n = recv(ch->sock, ch->rx + ch->rx_len, sizeof(ch->rx) - ch->rx_len, 0);
+        if (n > 0) {
+            ch->rx_len += n;
+            return ESP_OK;
+        }
+        if (n == 0) return ESP_ERR_INVALID_STATE;     // receiver closed the connection
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    }
+}
+
+static void consume(control_channel_t *ch, size_t n)
+{
+    memmove(ch->rx, ch->rx + n, ch->rx_len - n);
+    ch->rx_len -= n;
+}
+
+// Length of the header block including the blank line, 0 if incomplete
+static size_t header_end(const char *buf, size_t len)
+{
+    const char *end = memmem(buf, len, "\r\n\r\n", 4);
+    return end ? (size_t)(end - buf) + 4 : 0;
+}
+
+// Digits only, at most 9 of them; -1 otherwise
+static long parse_length(const char *p, const char *end)
+{
+    if (p == end || end - p > 9) return -1;
+    long n = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') return -1;
+        n = n * 10 + (*p - '0');
+    }
+    return n;
+}
+
+// Read one response off the connection; its body is discarded
+static esp_err_t read_response(control_channel_t *ch, int *status, bool *will_close)
+{
+    size_t hdr_len;
+    while ((hdr_len = header_end(ch->rx, ch->rx_len)) == 0) {
+        if (ch->rx_len == sizeof(ch->rx)) return ESP_ERR_INVALID_RESPONSE;
+        esp_err_t err = fill(ch);
+        if (err != ESP_OK) return err;
+    }
+
+    // The rx buffer is not NUL-terminated: every search stays within the header
+    // block, whose last two bytes are the blank line
+    const char *end = ch->rx + hdr_len - 2;
+    const char *eol = memmem(ch->rx, end - ch->rx, "\r\n", 2);
+    const char *s = ch->rx;
+    size_t line_len = eol - s;
+    if (line_len < 12 || memchr(s, '\n', line_len) || strncmp(s, "HTTP/1.", 7) != 0 ||
+        (s[7] != '0' && s[7] != '1') || s[8] != ' ' || (line_len > 12 && s[12] != ' ')) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    long code = parse_length(s + 9, s + 12);
+    if (code < 100) return ESP_ERR_INVALID_RESPONSE;
+    *status = (int)code;
+    *will_close = s[7] == '0';
+
+    long content_len = -1;
+    for (const char *line = eol + 2; line < end; line = eol + 2) {
+        eol = memmem(line, end - line, "\r\n", 2);
+        line_len = eol - line;
+        const char *colon = memchr(line, ':', line_len);
+        if (!colon || colon == line || memchr(line, '\n', line_len)) return ESP_ERR_INVALID_RESPONSE;
+
+        const char *v = colon + 1;
+        while (v < eol && (*v == ' ' || *v == '\t')) v++;
+        const char *v_end = eol;
+        while (v_end > v && (v_end[-1] == ' ' || v_end[-1] == '\t')) v_end--;
+
+        size_t name_len = colon - line;
+        if (name_len == 14 && strncasecmp(line, "Content-Length", 14) == 0) {
+            long n = parse_length(v, v_end);
+            if (n < 0 || (content_len >= 0 && n != content_len)) return ESP_ERR_INVALID_RESPONSE;
+            content_len = n;
+        } else if (name_len == 10 && strncasecmp(line, "Connection", 10) == 0) {
+            *will_close = v_end - v == 5 && strncasecmp(v, "close", 5) == 0;
+        }
+    }
+    if (content_len < 0) return ESP_ERR_NOT_SUPPORTED;  // chunked or close-delimited body
+    consume(ch, hdr_len);
+
+    while (content_len > 0) {
+        if (ch->rx_len == 0) {
+            esp_err_t err = fill(ch);
+            if (err != ESP_OK) return err;
+        }
+        size_t k = (size_t)content_len < ch->rx_len ? (size_t)content_len : ch->rx_len;
+        consume(ch, k);
+        content_len -= k;
+    }
+    return ESP_OK;
+}
+
+// During a poll, wait for the first byte of a response no longer than the
+// deadline; once it arrives the response is read to the end
+static esp_err_t wait_response(control_channel_t *ch)
+{
+    if (ch->deadline_us == 0 || ch->rx_len > 0) return ESP_OK;
+    int64_t left_us = ch->deadline_us - esp_timer_get_time();
+    if (left_us <= 0) return ESP_ERR_TIMEOUT;
+    fd_set rd;
+    FD_ZERO(&rd);
+    FD_SET(ch->sock, &rd);
+    struct timeval tv = { .tv_sec = left_us / 1000000, .tv_usec = left_us % 1000000 };
+    return select(ch->sock + 1, &rd, NULL, NULL, &tv) == 0 ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+
+// Wait for the response to the oldest request, reconnecting once on failure
+static esp_err_t complete_oldest(control_channel_t *ch)
+{
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (ch->sock < 0 || ch->written == 0) {
+            err = ch->sock < 0 ? connect_channel(ch) : write_pending(ch);
+            if (err != ESP_OK) {
+                drop_connection(ch);
+                continue;
+            }
+        }
+
+        // Nothing read yet: the connection stays, the response may still come
+        err = wait_response(ch);
+        if (err == ESP_ERR_TIMEOUT) return err;
+
+        int status = 0;
+        bool will_close = false;
+        err = read_response(ch, &status, &will_close);
+        if (err != ESP_OK) {
+            ESP_LOGD(TAG, "response: %s", esp_err_to_name(err));
+            drop_connection(ch);
+            continue;
+        }
+
+        pending_t *p = &ch->pending[ch->head];
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - p->first_sent_us);
+        ch->stats.latency_total_us += latency;
+        ch->stats.latency_last_us = latency;
+        if (latency > ch->stats.latency_max_us) ch->stats.latency_max_us = latency;
+        if (status >= 200 && status < 300) ch->stats.completed++; else ch->stats.rejected++;
+
+        ch->head = (ch->head + 1) % CONTROL_CHANNEL_MAX_PIPELINE;
+        ch->count--;
+        ch->written--;
+        if (will_close) drop_connection(ch);    // the rest goes out on the next connection
+        return ESP_OK;
+    }
+    return err;
+}
+
+esp_err_t control_channel_open(const control_channel_config_t *config, control_channel_t **out)
+{
+    if (!config || !config->host || !config->path || !config->content_type || !out ||
+        config->pipeline_depth == 0 || config->pipeline_depth > CONTROL_CHANNEL_MAX_PIPELINE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    control_channel_t *ch = calloc(1, sizeof(*ch));
+    if (!ch) return ESP_ERR_NO_MEM;
+    ch->cfg = *config;
+    ch->sock = -1;
+    *out = ch;
+    return ESP_OK;
+}
+
+esp_err_t control_channel_send(control_channel_t *ch, const void *body, size_t len)
+{
+    if (len > CONTROL_CHANNEL_MAX_BODY) return ESP_ERR_INVALID_SIZE;
+
+    if (ch->count == ch->cfg.pipeline_depth) {
+        esp_err_t err = complete_oldest(ch);
+        if (err != ESP_OK) return err;
+    }
+
+    pending_t *p = &ch->pending[(ch->head + ch->count) % CONTROL_CHANNEL_MAX_PIPELINE];
+    p->first_sent_us = esp_timer_get_time();
+    p->written_before = false;
+    p->len = len;
+    memcpy(p->body, body, len);
+    ch->count++;
+
+    esp_err_t err = ch->sock < 0 ? reconnect(ch) : write_pending(ch);
+    if (err != ESP_OK && ch->sock >= 0) err = reconnect(ch);
+    return err;
+}
+
+esp_err_t control_channel_flush(control_channel_t *ch)
+{
+    while (ch->count > 0) {
+        esp_err_t err = complete_oldest(ch);
+        if (err != ESP_OK) return err;
+    }
+    return ESP_OK;
+}
+
+esp_err_t control_channel_poll(control_channel_t *ch, uint32_t timeout_ms)
+{
+    ch->deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    esp_err_t err = ESP_OK;
+    while (ch->count > 0 && err == ESP_OK) err = complete_oldest(ch);
+    ch->deadline_us = 0;
+    return err;
+}
+
+void control_channel_get_stats(control_channel_t *ch, control_channel_stats_t *stats)
+{
+    *stats = ch->stats;
+    stats->in_flight = ch->count;
+}
+
+void control_channel_close(control_channel_t *ch)
+{
+    if (!ch) return;
+    drop_connection(ch);
+    free(ch);
+}
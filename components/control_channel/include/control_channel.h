@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONTROL_CHANNEL_MAX_PIPELINE    8
+#define CONTROL_CHANNEL_MAX_BODY        640     // fits CONTROL_MSG_JSON_MAX, a fully escaped JSON message
+
+/**
+ * @brief Channel configuration. The strings must outlive the channel.
+ */
+typedef struct {
+    const char *host;           // receiver address or name
+    uint16_t port;
+    const char *path;           // e.g. "/control"
+    const char *content_type;
+    size_t pipeline_depth;      // requests on the wire before send() waits for a response
+    uint32_t timeout_ms;        // connect, send and per-response timeout
+} control_channel_config_t;
+
+#define CONTROL_CHANNEL_DEFAULT_CONFIG() {          \
+    .host = "192.168.4.2",                          \
+    .port = 80,                                     \
+    .path = "/control",                             \
+    .content_type = "application/json",             \
+    .pipeline_depth = 4,                            \
+    .timeout_ms = 3000,                             \
+}
+
+/**
+ * @brief Channel counters, as returned by control_channel_get_stats().
+ *
+ * Connection reuse is (sent - resent) / connects requests per connection.
+ */
+typedef struct {
+    uint32_t sent;              // requests written, resends included
+    uint32_t resent;            // written again on a new connection after a failure
+    uint32_t completed;         // 2xx responses
+    uint32_t rejected;          // other responses
+    uint32_t connects;
+    uint32_t connect_failures;
+    uint32_t in_flight;         // queued, response not seen yet (written or waiting for a connection)
+    uint64_t latency_total_us;  // first write to response, over completed + rejected
+    uint32_t latency_max_us;
+    uint32_t latency_last_us;
+} control_channel_stats_t;
+
+typedef struct control_channel control_channel_t;
+
+/**
+ * @brief Persistent HTTP/1.1 POST channel to one receiver.
+ *
+ * Keeps one keep-alive connection open and writes up to pipeline_depth
+ * requests back to back before reading responses (HTTP pipelining).
+ * When the connection fails or the receiver closes it, the channel
+ * reconnects and writes the unanswered requests again, so requests
+ * must be idempotent (control messages carry the full state).
+ * Responses must carry Content-Length; a malformed header block drops the
+ * connection. Not thread-safe: one task per channel.
+ */
+esp_err_t control_channel_open(const control_channel_config_t *config, control_channel_t **out);
+
+/**
+ * @brief Queue and write one request body (<= CONTROL_CHANNEL_MAX_BODY bytes).
+ *
+ * Blocks only when pipeline_depth requests are already in flight, until
+ * the oldest one is answered. A request that cannot be written now stays
+ * queued and goes out with the next successful connect.
+ */
+esp_err_t control_channel_send(control_channel_t *ch, const void *body, size_t len);
+
+/**
+ * @brief Wait for the responses of every request in flight.
+ */
+esp_err_t control_channel_flush(control_channel_t *ch);
+
+/**
+ * @brief Like control_channel_flush(), but stop waiting after @p timeout_ms.
+ *
+ * Reconnecting counts against the deadline too: a connect gets at most the
+ * time left. A response that has started to arrive is still read to the
+ * end, bounded by the channel's timeout_ms.
+ *
+ * @return ESP_OK once nothing is in flight, ESP_ERR_TIMEOUT if requests are
+ *         still unanswered, or the error that dropped the connection
+ */
+esp_err_t control_channel_poll(control_channel_t *ch, uint32_t timeout_ms);
+
+void control_channel_get_stats(control_channel_t *ch, control_channel_stats_t *stats);
+
+/**
+ * @brief Close the connection and free the channel; unanswered requests are dropped.
+ */
+void control_channel_close(control_channel_t *ch);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,311 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "metrics.h"
+#include "control_fanout.h"
+
+static const char *TAG = "control_fanout";
+
+typedef struct {
+    bool used;
+    uint8_t mac[6];
+    char host[16];
+    control_outbox_t *outbox;   // NULL until the station has an address
+    uint32_t id;                // ctx of the outbox's on_delivered; a closing outbox never matches a reused slot
+    int64_t confirmed_us;       // put time of the newest update of s_update_key this peer confirmed
+} peer_t;
+
+typedef struct {
+    char key[CONTROL_OUTBOX_KEY_MAX];   // "" for a free slot
+    control_data_t value;
+    uint8_t encoded[CONTROL_MSG_BINARY_MAX];    // to spot unchanged values
+    size_t len;
+} state_t;
+
+static control_fanout_config_t s_config;
+static SemaphoreHandle_t s_lock = NULL;     // peers and state; held while calling into outboxes
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;  // what the outbox tasks touch: ids, confirmations, stats
+static peer_t s_peers[CONTROL_FANOUT_MAX_PEERS];
+static state_t s_state[CONTROL_OUTBOX_KEYS];
+static uint32_t s_next_id = 1;
+static control_fanout_stats_t s_stats;
+
+// The newest update, open until every peer has confirmed it
+static char s_update_key[CONTROL_OUTBOX_KEY_MAX];
+static int64_t s_update_us;
+static bool s_update_open = false;
+
+static const uint32_t s_latency_bounds[] = CONTROL_FANOUT_LATENCY_BUCKETS_US;
+static metrics_histogram_t s_latency;
+static metrics_gauge_t s_peers_gauge = METRICS_GAUGE_INIT(
+    "control_fanout_peers", "Receivers control updates are sent to", NULL);
+
+// Under s_mux. Latency of the open update if every active peer has it now, else 0.
+static uint32_t complete_update(int64_t now)
+{
+    if (!s_update_open) return 0;
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) {
+        if (s_peers[i].outbox && s_peers[i].confirmed_us < s_update_us) return 0;
+    }
+    uint32_t latency = (uint32_t)(now - s_update_us);
+    if (latency == 0) latency = 1;
+    s_update_open = false;
+    s_stats.complete++;
+    s_stats.latency_total_us += latency;
+    s_stats.latency_last_us = latency;
+    if (latency > s_stats.latency_max_us) s_stats.latency_max_us = latency;
+    return latency;
+}
+
+static void on_delivered(const char *key, int64_t put_us, void *ctx)
+{
+    uint32_t id = (uint32_t)(uintptr_t)ctx;
+    int64_t now = esp_timer_get_time();
+    uint32_t latency = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) {
+        peer_t *p = &s_peers[i];
+        if (p->used && p->id == id && strcmp(key, s_update_key) == 0 && put_us > p->confirmed_us) {
+            p->confirmed_us = put_us;
+            latency = complete_update(now);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (latency) metrics_histogram_observe(&s_latency, latency);
+}
+
+static void update_counts(void)
+{
+    uint32_t stations = 0, peers = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) {
+        stations += s_peers[i].used;
+        peers += s_peers[i].outbox != NULL;
+    }
+    s_stats.stations = stations;
+    s_stats.peers = peers;
+    portEXIT_CRITICAL(&s_mux);
+    metrics_gauge_set(&s_peers_gauge, peers);
+}
+
+// Under s_lock
+static peer_t *find_peer(const uint8_t mac[6], bool add)
+{
+    peer_t *free_slot = NULL;
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) {
+        if (s_peers[i].used && memcmp(s_peers[i].mac, mac, 6) == 0) return &s_peers[i];
+        if (!s_peers[i].used && !free_slot) free_slot = &s_peers[i];
+    }
+    if (!add || !free_slot) return NULL;
+
+    portENTER_CRITICAL(&s_mux);
+    *free_slot = (peer_t) { .used = true, .id = s_next_id++ };
+    memcpy(free_slot->mac, mac, 6);
+    s_stats.joins++;
+    portEXIT_CRITICAL(&s_mux);
+    return free_slot;
+}
+
+// Under s_lock. The outbox finishes its current send, then closes the transport.
+static void close_peer(peer_t *p)
+{
+    if (!p->outbox) return;
+    control_outbox_t *ob = p->outbox;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    p->outbox = NULL;
+    p->id = s_next_id++;
+    // The peers still here may already have the open update
+    uint32_t latency = complete_update(now);
+    portEXIT_CRITICAL(&s_mux);
+    control_outbox_delete(ob);
+    if (latency) metrics_histogram_observe(&s_latency, latency);
+}
+
+// Under s_lock
+static esp_err_t open_peer(peer_t *p)
+{
+    control_transport_t *transport = NULL;
+    esp_err_t err = s_config.open(p->host, p->mac, s_config.open_ctx, &transport);
+    if (err != ESP_OK) return err;
+
+    // Named after the id, not the slot: the outbox of the peer that had the
+    // slot before may still be finishing its last send
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), "peer%u", (unsigned)p->id);
+    control_outbox_config_t config = s_config.outbox;
+    config.name = name;
+    config.on_delivered = on_delivered;
+    config.ctx = (void *)(uintptr_t)p->id;
+    control_outbox_t *ob = NULL;
+    err = control_outbox_create(&config, transport, &ob);
+    if (err != ESP_OK) {
+        control_transport_close(transport);
+        return err;
+    }
+
+    portENTER_CRITICAL(&s_mux);
+    p->outbox = ob;
+    p->confirmed_us = 0;
+    portEXIT_CRITICAL(&s_mux);
+
+    // Catch up with the current state
+    for (size_t i = 0; i < CONTROL_OUTBOX_KEYS; i++) {
+        if (s_state[i].key[0] != '\0') control_outbox_put(ob, s_state[i].key, &s_state[i].value);
+    }
+    return ESP_OK;
+}
+
+esp_err_t control_fanout_init(const control_fanout_config_t *config)
+{
+    if (!config || !config->open) return ESP_ERR_INVALID_ARG;
+    if (s_lock) return ESP_ERR_INVALID_STATE;
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) return ESP_ERR_NO_MEM;
+    s_config = *config;
+
+    metrics_register(&s_peers_gauge.base);
+    return metrics_histogram_init(&s_latency, "control_fanout_latency_seconds",
+                                  "Control update to confirmed by every receiver", NULL,
+                                  s_latency_bounds, sizeof(s_latency_bounds) / sizeof(s_latency_bounds[0]));
+}
+
+esp_err_t control_fanout_station_join(const uint8_t mac[6])
+{
+    if (!mac) return ESP_ERR_INVALID_ARG;
+    if (!s_lock) return ESP_ERR_INVALID_STATE;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    peer_t *p = find_peer(mac, true);
+    xSemaphoreGive(s_lock);
+    update_counts();
+    return p ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t control_fanout_station_address(const uint8_t mac[6], uint32_t ip)
+{
+    if (!mac) return ESP_ERR_INVALID_ARG;
+    if (!s_lock) return ESP_ERR_INVALID_STATE;
+    // esp_ip4_addr_t keeps the address in network order: first octet in the low byte
+    char host[sizeof(((peer_t *)0)->host)];
+    snprintf(host, sizeof(host), "%u.%u.%u.%u", (unsigned)(ip & 0xff), (unsigned)((ip >> 8) & 0xff),
+             (unsigned)((ip >> 16) & 0xff), (unsigned)(ip >> 24));
+
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    peer_t *p = find_peer(mac, true);
+    if (!p) {
+        err = ESP_ERR_NO_MEM;
+    } else if (!p->outbox || strcmp(p->host, host) != 0) {
+        close_peer(p);
+        memcpy(p->host, host, sizeof(host));
+        err = open_peer(p);
+    }
+    xSemaphoreGive(s_lock);
+    update_counts();
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "peer %s: %s", host, esp_err_to_name(err));
+    } else {
+        ESP_LOGI(TAG, "peer %s added", host);
+    }
+    return err;
+}
+
+esp_err_t control_fanout_station_leave(const uint8_t mac[6])
+{
+    if (!mac) return ESP_ERR_INVALID_ARG;
+    if (!s_lock) return ESP_ERR_INVALID_STATE;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    peer_t *p = find_peer(mac, false);
+    if (p) {
+        if (p->outbox) ESP_LOGI(TAG, "peer %s removed", p->host);
+        close_peer(p);
+        portENTER_CRITICAL(&s_mux);
+        p->used = false;
+        s_stats.leaves++;
+        portEXIT_CRITICAL(&s_mux);
+    }
+    xSemaphoreGive(s_lock);
+    update_counts();
+    return p ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t control_fanout_put(const char *key, const control_data_t *value)
+{
+    if (!key || !value || strlen(key) >= CONTROL_OUTBOX_KEY_MAX) return ESP_ERR_INVALID_ARG;
+    if (!s_lock) return ESP_ERR_INVALID_STATE;
+    uint8_t encoded[CONTROL_MSG_BINARY_MAX];
+    size_t len = control_msg_encode_binary(value, encoded, sizeof(encoded));
+    if (len == 0) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    state_t *st = NULL, *free_slot = NULL;
+    for (size_t i = 0; i < CONTROL_OUTBOX_KEYS && !st; i++) {
+        if (strcmp(s_state[i].key, key) == 0) st = &s_state[i];
+        else if (!free_slot && s_state[i].key[0] == '\0') free_slot = &s_state[i];
+    }
+    if (!st && free_slot) {
+        st = free_slot;
+        memcpy(st->key, key, strlen(key) + 1);
+        st->len = 0;
+    }
+    if (!st || (st->len == len && memcmp(st->encoded, encoded, len) == 0)) {
+        xSemaphoreGive(s_lock);
+        return st ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    st->value = *value;
+    memcpy(st->encoded, encoded, len);
+    st->len = len;
+
+    // Stamped before any outbox sees it, so every peer's put time is at or after it
+    int64_t now = esp_timer_get_time();
+    bool any = false;
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) any |= s_peers[i].outbox != NULL;
+    portENTER_CRITICAL(&s_mux);
+    s_stats.updates++;
+    memcpy(s_update_key, key, strlen(key) + 1);
+    s_update_us = now;
+    s_update_open = any;
+    portEXIT_CRITICAL(&s_mux);
+
+    for (size_t i = 0; i < CONTROL_FANOUT_MAX_PEERS; i++) {
+        if (!s_peers[i].outbox) continue;
+        esp_err_t err = control_outbox_put(s_peers[i].outbox, key, value);
+        if (err != ESP_OK) ESP_LOGW(TAG, "peer %s: %s", s_peers[i].host, esp_err_to_name(err));
+    }
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+void control_fanout_get_stats(control_fanout_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_mux);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+esp_err_t control_fanout_get_peer(size_t index, control_fanout_peer_info_t *info)
+{
+    if (index >= CONTROL_FANOUT_MAX_PEERS || !info) return ESP_ERR_INVALID_ARG;
+    if (!s_lock) return ESP_ERR_INVALID_STATE;
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    peer_t *p = &s_peers[index];
+    if (!p->used) {
+        err = ESP_ERR_NOT_FOUND;
+    } else {
+        memset(info, 0, sizeof(*info));
+        memcpy(info->mac, p->mac, 6);
+        memcpy(info->host, p->host, sizeof(info->host));
+        info->active = p->outbox != NULL;
+        if (p->outbox) control_outbox_get_stats(p->outbox, &info->outbox);
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
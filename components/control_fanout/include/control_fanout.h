@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "control_msg.h"
+#include "control_outbox.h"
+#include "control_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One per station the AP admits
+#define CONTROL_FANOUT_MAX_PEERS    4
+
+// Update to confirmed by every peer, in microseconds
+#define CONTROL_FANOUT_LATENCY_BUCKETS_US { 1000, 2500, 5000, 10000, 25000, 50000, 100000, \
+                                            250000, 1000000, 5000000 }
+
+/*
+ * Control state sent to every receiver on the AP.
+ *
+ * Peers come from the AP's events: a station joins (WIFI_EVENT_AP_STACONNECTED),
+ * gets an address (IP_EVENT_AP_STAIPASSIGNED), leaves (WIFI_EVENT_AP_STADISCONNECTED).
+ * Once a peer has an address it gets its own transport and control_outbox,
+ * and with them its own task, queue, retries and backoff. A slow or dead
+ * receiver only delays itself. A new peer is sent the current state at once.
+ */
+
+/**
+ * @brief Open the transport to one peer; called with the peer's dotted address.
+ */
+typedef esp_err_t (*control_fanout_open_fn_t)(const char *host, const uint8_t mac[6], void *ctx,
+                                              control_transport_t **out);
+
+typedef struct {
+    control_fanout_open_fn_t open;
+    void *open_ctx;
+    control_outbox_config_t outbox;     // per peer; name, on_delivered and ctx are set by the fan-out
+} control_fanout_config_t;
+
+#define CONTROL_FANOUT_DEFAULT_CONFIG() {           \
+    .open = NULL,                                   \
+    .open_ctx = NULL,                               \
+    .outbox = CONTROL_OUTBOX_DEFAULT_CONFIG(),      \
+}
+
+typedef struct {
+    uint32_t stations;          // associated now
+    uint32_t peers;             // with an address and an outbox now
+    uint32_t joins;
+    uint32_t leaves;
+    uint32_t updates;           // control_fanout_put() calls that changed the state
+    uint32_t complete;          // updates confirmed by every peer; superseded ones are not counted
+    uint64_t latency_total_us;  // update to confirmed by every peer, over complete
+    uint32_t latency_max_us;
+    uint32_t latency_last_us;
+} control_fanout_stats_t;
+
+typedef struct {
+    uint8_t mac[6];
+    char host[16];              // "" until the station has an address
+    bool active;                // has an outbox
+    control_outbox_stats_t outbox;
+} control_fanout_peer_info_t;
+
+/**
+ * @brief Set up the fan-out. Call once, before the Wi-Fi events start.
+ *        Registers the control_fanout_* metrics.
+ */
+esp_err_t control_fanout_init(const control_fanout_config_t *config);
+
+/**
+ * @brief A station associated. It becomes a peer once it has an address.
+ *
+ * @return ESP_ERR_NO_MEM when CONTROL_FANOUT_MAX_PEERS stations are known
+ */
+esp_err_t control_fanout_station_join(const uint8_t mac[6]);
+
+/**
+ * @brief The station got @p ip (as in esp_ip4_addr_t.addr); opens its transport
+ *        and outbox and sends it the current state. A station not seen joining
+ *        is added.
+ */
+esp_err_t control_fanout_station_address(const uint8_t mac[6], uint32_t ip);
+
+/**
+ * @brief The station left; its outbox and transport are closed.
+ */
+esp_err_t control_fanout_station_leave(const uint8_t mac[6]);
+
+/**
+ * @brief Make @p value the state of @p key and queue it to every peer.
+ *
+ * Only waits for the peer table lock, never for a peer. A value equal to
+ * the current one sends nothing.
+ */
+esp_err_t control_fanout_put(const char *key, const control_data_t *value);
+
+void control_fanout_get_stats(control_fanout_stats_t *stats);
+
+/**
+ * @brief Peer @p index (0 .. CONTROL_FANOUT_MAX_PEERS - 1).
+ *
+ * @return ESP_ERR_NOT_FOUND for an unused slot
+ */
+esp_err_t control_fanout_get_peer(size_t index, control_fanout_peer_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,167 @@
+#include <string.h>
+#include "json_stream.h"
+#include "control_msg.h"
+
+// Binary string lengths are one byte
+#define CHECK_SIZE_BOOL(size)   1
+#define CHECK_SIZE_INT32(size)  1
+#define CHECK_SIZE_STRING(size) ((size) >= 1 && (size) <= 256)
+#define CHECK_SIZE(type, name, size) \
+    _Static_assert(CHECK_SIZE_##type(size), "control_msg: " #name " must hold 0..255 bytes");
+CONTROL_MSG_FIELDS(CHECK_SIZE)
+
+// --- Binary ---
+
+#define BIN_ENCODE(type, name, size)    if (!bin_put_##type(&w, &msg->name, size)) return 0;
+#define BIN_DECODE(type, name, size)    if (!bin_get_##type(&r, &msg.name, size)) return ESP_ERR_INVALID_ARG;
+
+typedef struct {
+    uint8_t *p;
+    size_t left;
+} bin_writer_t;
+
+typedef struct {
+    const uint8_t *p;
+    size_t left;
+} bin_reader_t;
+
+static inline bool bin_put_BOOL(bin_writer_t *w, const void *p, size_t size)
+{
+    const bool *v = p;
+    if (w->left < 1) return false;
+    *w->p++ = *v ? 1 : 0;
+    w->left--;
+    return true;
+}
+
+static inline bool bin_put_INT32(bin_writer_t *w, const void *p, size_t size)
+{
+    const int32_t *v = p;
+    if (w->left < 4) return false;
+    uint32_t u = (uint32_t)*v;
+    for (int i = 0; i < 4; i++) *w->p++ = u >> (8 * i);
+    w->left -= 4;
+    return true;
+}
+
+static inline bool bin_put_STRING(bin_writer_t *w, const void *p, size_t size)
+{
+    const char *v = p;
+    size_t len = strnlen(v, size - 1);
+    if (w->left < 1 + len) return false;
+    *w->p++ = len;
+    memcpy(w->p, v, len);
+    w->p += len;
+    w->left -= 1 + len;
+    return true;
+}
+
+static inline bool bin_get_BOOL(bin_reader_t *r, void *p, size_t size)
+{
+    bool *v = p;
+    if (r->left < 1 || *r->p > 1) return false;
+    *v = *r->p++;
+    r->left--;
+    return true;
+}
+
+static inline bool bin_get_INT32(bin_reader_t *r, void *p, size_t size)
+{
+    int32_t *v = p;
+    if (r->left < 4) return false;
+    uint32_t u = 0;
+    for (int i = 0; i < 4; i++) u |= (uint32_t)*r->p++ << (8 * i);
+    *v = (int32_t)u;
+    r->left -= 4;
+    return true;
+}
+
+static inline bool bin_get_STRING(bin_reader_t *r, void *p, size_t size)
+{
+    char *v = p;
+    if (r->left < 1) return false;
+    size_t len = *r->p;
+    if (len >= size || r->left < 1 + len) return false;
+    memcpy(v, r->p + 1, len);
+    v[len] = '\0';
+    r->p += 1 + len;
+    r->left -= 1 + len;
+    return true;
+}
+
+size_t control_msg_encode_binary(const control_data_t *msg, uint8_t *buf, size_t cap)
+{
+    bin_writer_t w = { buf, cap };
+    CONTROL_MSG_FIELDS(BIN_ENCODE)
+    return cap - w.left;
+}
+
+esp_err_t control_msg_decode_binary(const uint8_t *buf, size_t len, control_data_t *out)
+{
+    // Decoded into a local so a bad message never leaves *out half written
+    control_data_t msg;
+    bin_reader_t r = { buf, len };
+    CONTROL_MSG_FIELDS(BIN_DECODE)
+    if (r.left != 0) return ESP_ERR_INVALID_ARG;
+    *out = msg;
+    return ESP_OK;
+}
+
+// --- JSON ---
+
+#define JSON_ENCODE(type, name, size)   json_put_##type(&js, #name, &msg->name);
+#define JSON_FIELD(type, name, size)    JSON_READER_FIELD(JSON_READER_FIELD_##type, control_data_t, name),
+
+static inline void json_put_BOOL(json_stream_t *js, const char *key, const void *v)
+{
+    json_stream_kv_bool(js, key, *(const bool *)v);
+}
+
+static inline void json_put_INT32(json_stream_t *js, const char *key, const void *v)
+{
+    json_stream_kv_int(js, key, *(const int32_t *)v);
+}
+
+static inline void json_put_STRING(json_stream_t *js, const char *key, const void *v)
+{
+    json_stream_kv_string(js, key, v);
+}
+
+static const json_reader_field_t s_json_fields[] = {
+    CONTROL_MSG_FIELDS(JSON_FIELD)
+};
+
+size_t control_msg_encode_json(const control_data_t *msg, char *buf, size_t cap)
+{
+    json_stream_t js;
+    json_stream_init(&js, buf, cap);
+    json_stream_begin_object(&js);
+    CONTROL_MSG_FIELDS(JSON_ENCODE)
+    json_stream_end_object(&js);
+    return json_stream_finish(&js) == ESP_OK ? json_stream_len(&js) : 0;
+}
+
+void control_msg_json_bind(json_reader_bind_t *bind, control_data_t *out, json_reader_cb_t other, void *other_ctx)
+{
+    *bind = (json_reader_bind_t) {
+        .fields = s_json_fields,
+        .num_fields = sizeof(s_json_fields) / sizeof(s_json_fields[0]),
+        .out = out,
+        .other = other,
+        .other_ctx = other_ctx,
+    };
+}
+
+esp_err_t control_msg_decode_json(const char *json, size_t len, control_data_t *out)
+{
+    control_data_t msg = { 0 };
+    json_reader_bind_t bind;
+    control_msg_json_bind(&bind, &msg, NULL, NULL);
+    json_reader_t reader;
+    json_reader_init(&reader, json_reader_bind_cb, &bind);
+    json_reader_feed(&reader, json, len);
+    esp_err_t err = json_reader_finish(&reader);
+    if (err == ESP_OK && !json_reader_bind_has_all(&bind)) err = ESP_ERR_INVALID_ARG;
+    if (err == ESP_OK) *out = msg;
+    return err;
+}
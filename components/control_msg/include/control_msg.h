@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "json_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The control message, defined once. Each X(TYPE, name, size) entry becomes
+ * a struct member, a binary field and a JSON member of the same name:
+ *
+ *   TYPE     member              binary                    JSON
+ *   BOOL     bool name           u8 0/1                    true / false
+ *   INT32    int32_t name        i32 little-endian         number
+ *   STRING   char name[size]     u8 length, bytes          string (cut to size - 1 on decode)
+ *
+ * Fields are encoded in this order; append new ones at the end.
+ */
+#define CONTROL_MSG_FIELDS(X)           \
+    X(BOOL,   toggle,  1)               \
+    X(STRING, message, 100)
+
+#define CONTROL_MSG_CTYPE_BOOL(name, size)      bool name;
+#define CONTROL_MSG_CTYPE_INT32(name, size)     int32_t name;
+#define CONTROL_MSG_CTYPE_STRING(name, size)    char name[size];
+#define CONTROL_MSG_MEMBER(type, name, size)    CONTROL_MSG_CTYPE_##type(name, size)
+
+typedef struct {
+    CONTROL_MSG_FIELDS(CONTROL_MSG_MEMBER)
+} control_data_t;
+
+// Encoded size bounds, for buffers
+#define CONTROL_MSG_BIN_SIZE_BOOL(size)         1
+#define CONTROL_MSG_BIN_SIZE_INT32(size)        4
+#define CONTROL_MSG_BIN_SIZE_STRING(size)       (1 + (size) - 1)
+#define CONTROL_MSG_JSON_SIZE_BOOL(size)        5
+#define CONTROL_MSG_JSON_SIZE_INT32(size)       11
+#define CONTROL_MSG_JSON_SIZE_STRING(size)      (2 + 6 * ((size) - 1))   // every byte escaped as \uXXXX
+#define CONTROL_MSG_BIN_SIZE(type, name, size)  + CONTROL_MSG_BIN_SIZE_##type(size)
+#define CONTROL_MSG_JSON_SIZE(type, name, size) + sizeof(#name) + 3 + CONTROL_MSG_JSON_SIZE_##type(size)
+
+#define CONTROL_MSG_BINARY_MAX  (0 CONTROL_MSG_FIELDS(CONTROL_MSG_BIN_SIZE))
+#define CONTROL_MSG_JSON_MAX    (3 CONTROL_MSG_FIELDS(CONTROL_MSG_JSON_SIZE))   // braces and terminator
+
+/**
+ * @brief Binary encoding; returns its length, 0 if @p cap is too small.
+ */
+size_t control_msg_encode_binary(const control_data_t *msg, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Decode a whole binary message. Strict: a bad bool, an over-long
+ *        string or a length mismatch gives ESP_ERR_INVALID_ARG.
+ */
+esp_err_t control_msg_decode_binary(const uint8_t *buf, size_t len, control_data_t *out);
+
+/**
+ * @brief JSON encoding, NUL terminated; returns its length, 0 if @p cap is too small.
+ */
+size_t control_msg_encode_json(const control_data_t *msg, char *buf, size_t cap);
+
+/**
+ * @brief Decode a whole JSON message. Every field must be present; unknown
+ *        members are ignored.
+ */
+esp_err_t control_msg_decode_json(const char *json, size_t len, control_data_t *out);
+
+/**
+ * @brief Set up @p bind to decode a message streamed through a json_reader_t
+ *        (with json_reader_bind_cb); @p other gets every other event, may be NULL.
+ *
+ * Complete when json_reader_finish() is ESP_OK and json_reader_bind_has_all().
+ */
+void control_msg_json_bind(json_reader_bind_t *bind, control_data_t *out, json_reader_cb_t other, void *other_ctx);
+
+#ifdef __cplusplus
+}
+#endif
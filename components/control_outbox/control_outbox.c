@@ -0,0 +1,296 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "metrics.h"
+#include "control_outbox.h"
+
+static const char *TAG = "control_outbox";
+
+typedef struct {
+    char key[CONTROL_OUTBOX_KEY_MAX];   // "" for a free slot
+    uint8_t value[CONTROL_MSG_BINARY_MAX];  // newest value, binary encoded
+    size_t len;
+    bool pending;               // value not sent yet, or its send failed
+    bool retry;                 // pending because its send failed
+    int64_t put_us;             // when value was put
+    int64_t due_us;             // earliest next send: min interval or backoff
+    uint32_t backoff_ms;        // 0 after a delivered send
+    uint32_t queued_seq;        // position of the last send in the transport's queue, 0 if none; task only
+} outbox_slot_t;
+
+struct control_outbox {
+    control_outbox_config_t config;
+    char name[configMAX_TASK_NAME_LEN];     // config.name points here
+    control_transport_t *transport;
+    TaskHandle_t task;
+    _Atomic bool stopping;
+    portMUX_TYPE mux;
+    outbox_slot_t slots[CONTROL_OUTBOX_KEYS];
+    size_t next;                // slot to look at first, so one busy key cannot starve the others
+    control_outbox_stats_t stats;
+};
+
+static const uint32_t s_latency_bounds[] = CONTROL_OUTBOX_LATENCY_BUCKETS_US;
+
+// Shared by every outbox
+static metrics_counter_t s_puts = METRICS_COUNTER_INIT(
+    "control_outbox_updates_total", "State updates put into an outbox");
+static metrics_counter_t s_coalesced = METRICS_COUNTER_INIT(
+    "control_outbox_coalesced_total", "Updates replaced by a newer one before being sent");
+static metrics_counter_t s_retries = METRICS_COUNTER_INIT(
+    "control_outbox_retries_total", "Sends repeated after an unconfirmed one");
+static metrics_counter_t s_failed = METRICS_COUNTER_INIT(
+    "control_outbox_failed_total", "Sends not confirmed in time");
+static metrics_gauge_t s_depth_gauge = METRICS_GAUGE_INIT(
+    "control_outbox_depth", "Keys waiting to be sent, over all outboxes", NULL);
+static metrics_histogram_t s_latency;
+static _Atomic int32_t s_depth = 0;
+static bool s_metrics_registered = false;
+static portMUX_TYPE s_metrics_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void register_metrics(void)
+{
+    portENTER_CRITICAL(&s_metrics_mux);
+    bool first = !s_metrics_registered;
+    s_metrics_registered = true;
+    portEXIT_CRITICAL(&s_metrics_mux);
+    if (!first) return;
+
+    metrics_register(&s_puts.base);
+    metrics_register(&s_coalesced.base);
+    metrics_register(&s_retries.base);
+    metrics_register(&s_failed.base);
+    metrics_register(&s_depth_gauge.base);
+    metrics_histogram_init(&s_latency, "control_outbox_latency_seconds", "State update to confirmed delivery",
+                           NULL, s_latency_bounds, sizeof(s_latency_bounds) / sizeof(s_latency_bounds[0]));
+}
+
+static void depth_add(int32_t n)
+{
+    metrics_gauge_set(&s_depth_gauge, atomic_fetch_add(&s_depth, n) + n);
+}
+
+// Next slot to send, or NULL with *wake_us set to when one becomes due (INT64_MAX: none pending)
+static outbox_slot_t *next_due(control_outbox_t *ob, int64_t now, int64_t *wake_us)
+{
+    *wake_us = INT64_MAX;
+    outbox_slot_t *due = NULL;
+    portENTER_CRITICAL(&ob->mux);
+    for (size_t n = 0; n < CONTROL_OUTBOX_KEYS; n++) {
+        size_t i = (ob->next + n) % CONTROL_OUTBOX_KEYS;
+        outbox_slot_t *s = &ob->slots[i];
+        if (!s->pending) continue;
+        if (s->due_us <= now) {
+            due = s;
+            ob->next = (i + 1) % CONTROL_OUTBOX_KEYS;
+            break;
+        }
+        if (s->due_us < *wake_us) *wake_us = s->due_us;
+    }
+    portEXIT_CRITICAL(&ob->mux);
+    return due;
+}
+
+// Payloads the transport has confirmed or given up on; it does so in the order they were sent
+static uint32_t resolved(const control_transport_stats_t *st)
+{
+    return st->delivered + st->failed;
+}
+
+static void send_slot(control_outbox_t *ob, outbox_slot_t *s)
+{
+    uint8_t value[CONTROL_MSG_BINARY_MAX];
+    portENTER_CRITICAL(&ob->mux);
+    size_t len = s->len;
+    memcpy(value, s->value, len);
+    int64_t put_us = s->put_us;
+    bool retry = s->retry;
+    s->pending = false;
+    s->retry = false;
+    portEXIT_CRITICAL(&ob->mux);
+    depth_add(-1);
+
+    // Stored binary; JSON transports get it re-encoded
+    char json[CONTROL_MSG_JSON_MAX];
+    const void *payload = value;
+    if (ob->transport->format == CONTROL_TRANSPORT_JSON) {
+        control_data_t data;
+        control_msg_decode_binary(value, len, &data);
+        len = control_msg_encode_json(&data, json, sizeof(json));
+        payload = json;
+    }
+
+    control_transport_stats_t before, after;
+    control_transport_get_stats(ob->transport, &before);
+    int64_t started = esp_timer_get_time();
+    // A retry of the same value the transport still holds (e.g. HTTP waiting to
+    // reconnect) only waits for it again, so a dead link does not pile up copies.
+    // It is held until as many payloads as were queued up to it are resolved.
+    esp_err_t err = ESP_OK;
+    bool resend = !(retry && s->queued_seq != 0 && (int32_t)(s->queued_seq - resolved(&before)) > 0);
+    if (resend) {
+        err = control_transport_send(ob->transport, payload, len);
+        control_transport_stats_t queued;
+        control_transport_get_stats(ob->transport, &queued);
+        uint32_t seq = resolved(&queued) + queued.in_flight;
+        s->queued_seq = seq != resolved(&before) + before.in_flight ? seq : 0;
+    }
+    if (err == ESP_OK) err = control_transport_poll(ob->transport, ob->config.ack_timeout_ms);
+    control_transport_get_stats(ob->transport, &after);
+    int64_t now = esp_timer_get_time();
+    bool delivered = err == ESP_OK && after.delivered != before.delivered && after.in_flight == 0;
+    uint32_t latency = (uint32_t)(now - put_us);
+
+    bool requeued = false;
+    portENTER_CRITICAL(&ob->mux);
+    if (resend) ob->stats.sent++;
+    if (retry) ob->stats.retries++;
+    if (delivered) {
+        ob->stats.delivered++;
+        ob->stats.latency_total_us += latency;
+        ob->stats.latency_last_us = latency;
+        if (latency > ob->stats.latency_max_us) ob->stats.latency_max_us = latency;
+        s->backoff_ms = 0;
+        s->due_us = started + (int64_t)ob->config.min_interval_ms * 1000;
+    } else {
+        ob->stats.failed++;
+        s->backoff_ms = s->backoff_ms ? s->backoff_ms * 2 : ob->config.retry_min_ms;
+        if (s->backoff_ms > ob->config.retry_max_ms) s->backoff_ms = ob->config.retry_max_ms;
+        s->due_us = now + (int64_t)s->backoff_ms * 1000;
+        // Unless a newer value arrived meanwhile, the same one goes again
+        if (!s->pending) {
+            s->pending = true;
+            s->retry = true;
+            requeued = true;
+        }
+    }
+    portEXIT_CRITICAL(&ob->mux);
+
+    if (retry) metrics_counter_inc(&s_retries);
+    if (delivered) {
+        metrics_histogram_observe(&s_latency, latency);
+        if (ob->config.on_delivered) ob->config.on_delivered(s->key, put_us, ob->config.ctx);
+    } else {
+        metrics_counter_inc(&s_failed);
+        if (requeued) depth_add(1);
+        ESP_LOGW(TAG, "%s: '%s' not confirmed (%s), retry in %u ms", ob->config.name, s->key,
+                 esp_err_to_name(err), (unsigned)s->backoff_ms);
+    }
+}
+
+static void outbox_task(void *arg)
+{
+    control_outbox_t *ob = arg;
+    while (!atomic_load(&ob->stopping)) {
+        int64_t wake_us;
+        outbox_slot_t *s = next_due(ob, esp_timer_get_time(), &wake_us);
+        if (s) {
+            send_slot(ob, s);
+            continue;
+        }
+
+        TickType_t wait = portMAX_DELAY;
+        if (wake_us != INT64_MAX) {
+            int64_t ms = (wake_us - esp_timer_get_time() + 999) / 1000;
+            wait = ms > 0 ? pdMS_TO_TICKS(ms) + 1 : 0;
+        }
+        xTaskNotifyWait(0, UINT32_MAX, NULL, wait);
+    }
+
+    int32_t dropped = 0;
+    for (size_t i = 0; i < CONTROL_OUTBOX_KEYS; i++) dropped += ob->slots[i].pending;
+    if (dropped) depth_add(-dropped);
+    control_transport_close(ob->transport);
+    free(ob);
+    vTaskDelete(NULL);
+}
+
+esp_err_t control_outbox_create(const control_outbox_config_t *config, control_transport_t *transport,
+                                control_outbox_t **out)
+{
+    if (!config || !transport || !out) return ESP_ERR_INVALID_ARG;
+    control_outbox_t *ob = calloc(1, sizeof(*ob));
+    if (!ob) return ESP_ERR_NO_MEM;
+    ob->config = *config;
+    snprintf(ob->name, sizeof(ob->name), "%s", config->name);
+    ob->config.name = ob->name;
+    ob->transport = transport;
+    ob->mux = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    register_metrics();
+
+    if (xTaskCreate(outbox_task, ob->name, config->stack_size, ob, config->priority, &ob->task) != pdPASS) {
+        free(ob);
+        return ESP_ERR_NO_MEM;
+    }
+    *out = ob;
+    return ESP_OK;
+}
+
+esp_err_t control_outbox_put(control_outbox_t *ob, const char *key, const control_data_t *value)
+{
+    if (!ob || !key || !value || strlen(key) >= CONTROL_OUTBOX_KEY_MAX) return ESP_ERR_INVALID_ARG;
+    uint8_t enc[CONTROL_MSG_BINARY_MAX];
+    size_t len = control_msg_encode_binary(value, enc, sizeof(enc));
+    if (len == 0) return ESP_ERR_INVALID_ARG;
+    int64_t now = esp_timer_get_time();
+
+    esp_err_t err = ESP_OK;
+    bool unchanged = false, coalesced = false, queued = false;
+    portENTER_CRITICAL(&ob->mux);
+    outbox_slot_t *s = NULL, *free_slot = NULL;
+    for (size_t i = 0; i < CONTROL_OUTBOX_KEYS && !s; i++) {
+        if (strcmp(ob->slots[i].key, key) == 0) s = &ob->slots[i];
+        else if (!free_slot && ob->slots[i].key[0] == '\0') free_slot = &ob->slots[i];
+    }
+    if (!s && free_slot) {
+        s = free_slot;
+        memcpy(s->key, key, strlen(key) + 1);
+        s->len = 0;
+    }
+    if (!s) {
+        err = ESP_ERR_NO_MEM;
+    } else if (s->len == len && memcmp(s->value, enc, len) == 0) {
+        unchanged = true;       // pending already, or sent and confirmed / being retried
+    } else {
+        coalesced = s->pending && !s->retry;
+        queued = !s->pending;
+        memcpy(s->value, enc, len);
+        s->len = len;
+        s->put_us = now;
+        s->pending = true;
+        s->retry = false;
+    }
+    if (s) ob->stats.puts++;
+    if (unchanged) ob->stats.unchanged++;
+    if (coalesced) ob->stats.coalesced++;
+    portEXIT_CRITICAL(&ob->mux);
+
+    if (err != ESP_OK) return err;
+    metrics_counter_inc(&s_puts);
+    if (coalesced) metrics_counter_inc(&s_coalesced);
+    if (queued) depth_add(1);
+    if (!unchanged) xTaskNotify(ob->task, 0, eSetBits);
+    return ESP_OK;
+}
+
+void control_outbox_get_stats(control_outbox_t *ob, control_outbox_stats_t *stats)
+{
+    portENTER_CRITICAL(&ob->mux);
+    *stats = ob->stats;
+    stats->depth = 0;
+    for (size_t i = 0; i < CONTROL_OUTBOX_KEYS; i++) stats->depth += ob->slots[i].pending;
+    portEXIT_CRITICAL(&ob->mux);
+}
+
+void control_outbox_delete(control_outbox_t *ob)
+{
+    if (!ob) return;
+    atomic_store(&ob->stopping, true);
+    xTaskNotify(ob->task, 0, eSetBits);
+}
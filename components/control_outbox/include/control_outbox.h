@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "control_msg.h"
+#include "control_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONTROL_OUTBOX_KEYS         4
+#define CONTROL_OUTBOX_KEY_MAX      16
+
+// Update to confirmed delivery, in microseconds
+#define CONTROL_OUTBOX_LATENCY_BUCKETS_US { 1000, 2500, 5000, 10000, 25000, 50000, 100000, \
+                                            250000, 1000000, 5000000 }
+
+/*
+ * Latest-state outbox in front of a control transport.
+ *
+ * Each key holds one control_data_t. control_outbox_put() replaces the
+ * key's value and wakes the outbox task, which sends it right away unless
+ * the key was sent less than min_interval_ms ago. Values put while an
+ * older one waits are coalesced: only the newest is sent. A put equal to
+ * the key's current value sends nothing, so an unchanged state costs no
+ * traffic. A send not confirmed within ack_timeout_ms is retried, with
+ * the key's newest value, after a delay doubling from retry_min_ms to
+ * retry_max_ms. While the transport still queues the unconfirmed value
+ * (HTTP waiting to reconnect), the retry waits for it again instead of
+ * queueing another copy.
+ */
+
+typedef struct {
+    const char *name;           // task name, copied; up to configMAX_TASK_NAME_LEN - 1 characters
+    uint32_t min_interval_ms;   // between two sends of one key
+    uint32_t ack_timeout_ms;    // transport poll per send; for HTTP it bounds reconnecting too
+    uint32_t retry_min_ms;      // backoff after a failed send; doubles per failure
+    uint32_t retry_max_ms;
+    UBaseType_t priority;
+    uint32_t stack_size;
+    // Called from the outbox task after each confirmed send, with the time
+    // the delivered value was put; may be NULL
+    void (*on_delivered)(const char *key, int64_t put_us, void *ctx);
+    void *ctx;
+} control_outbox_config_t;
+
+#define CONTROL_OUTBOX_DEFAULT_CONFIG() {           \
+    .name = "outbox",                               \
+    .min_interval_ms = 50,                          \
+    .ack_timeout_ms = 1000,                         \
+    .retry_min_ms = 250,                            \
+    .retry_max_ms = 8000,                           \
+    .priority = 5,                                  \
+    .stack_size = 4096,                             \
+}
+
+typedef struct {
+    uint32_t puts;              // control_outbox_put() calls
+    uint32_t unchanged;         // equal to the key's value, dropped
+    uint32_t coalesced;         // replaced a value not sent yet
+    uint32_t sent;              // handed to the transport, retries included
+    uint32_t retries;
+    uint32_t delivered;
+    uint32_t failed;            // not confirmed within ack_timeout_ms
+    uint32_t depth;             // keys waiting to be sent
+    uint64_t latency_total_us;  // put to confirmation, over delivered
+    uint32_t latency_max_us;
+    uint32_t latency_last_us;
+} control_outbox_stats_t;
+
+typedef struct control_outbox control_outbox_t;
+
+/**
+ * @brief Start an outbox task sending over @p transport.
+ *
+ * The outbox takes over the transport: only its task uses it from now on,
+ * and control_outbox_delete() closes it.
+ * Also registers the control_outbox_* metrics on first use.
+ */
+esp_err_t control_outbox_create(const control_outbox_config_t *config, control_transport_t *transport,
+                                control_outbox_t **out);
+
+/**
+ * @brief Make @p value the newest state of @p key and wake the task.
+ *
+ * Never blocks; safe from any task.
+ *
+ * @return ESP_ERR_NO_MEM when CONTROL_OUTBOX_KEYS other keys are in use
+ */
+esp_err_t control_outbox_put(control_outbox_t *ob, const char *key, const control_data_t *value);
+
+void control_outbox_get_stats(control_outbox_t *ob, control_outbox_stats_t *stats);
+
+/**
+ * @brief Stop the task once its current send completes, close the transport
+ *        and free the outbox. Unsent values are dropped.
+ */
+void control_outbox_delete(control_outbox_t *ob);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "control_transport.h"
+
+static const char *TAG = "control_transport";
+
+esp_err_t control_transport_send(control_transport_t *t, const void *payload, size_t len)
+{
+    return t->ops->send(t, payload, len);
+}
+
+esp_err_t control_transport_poll(control_transport_t *t, uint32_t timeout_ms)
+{
+    return t->ops->poll(t, timeout_ms);
+}
+
+void control_transport_get_stats(control_transport_t *t, control_transport_stats_t *stats)
+{
+    t->ops->get_stats(t, stats);
+}
+
+void control_transport_close(control_transport_t *t)
+{
+    if (t) t->ops->close(t);
+}
+
+// --- Loopback ---
+
+typedef struct {
+    control_transport_t base;
+    control_transport_recv_cb_t recv;
+    void *ctx;
+    control_transport_stats_t stats;
+} loopback_t;
+
+static esp_err_t loopback_send(control_transport_t *t, const void *payload, size_t len)
+{
+    loopback_t *lb = (loopback_t *)t;
+    lb->stats.sent++;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = lb->recv(payload, len, lb->ctx);
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - start);
+
+    if (err != ESP_OK) {
+        lb->stats.failed++;
+        ESP_LOGD(TAG, "loopback: rejected (%s)", esp_err_to_name(err));
+        return ESP_OK;      // like a 400 response: the transport itself worked
+    }
+    lb->stats.delivered++;
+    lb->stats.latency_total_us += latency;
+    lb->stats.latency_last_us = latency;
+    if (latency > lb->stats.latency_max_us) lb->stats.latency_max_us = latency;
+    return ESP_OK;
+}
+
+static esp_err_t loopback_poll(control_transport_t *t, uint32_t timeout_ms)
+{
+    return ESP_OK;          // delivered synchronously in send()
+}
+
+static void loopback_get_stats(control_transport_t *t, control_transport_stats_t *stats)
+{
+    *stats = ((loopback_t *)t)->stats;
+}
+
+static void loopback_close(control_transport_t *t)
+{
+    free(t);
+}
+
+static const control_transport_ops_t s_loopback_ops = {
+    .send = loopback_send,
+    .poll = loopback_poll,
+    .get_stats = loopback_get_stats,
+    .close = loopback_close,
+};
+
+esp_err_t control_transport_loopback_open(control_transport_format_t format, control_transport_recv_cb_t recv,
+                                          void *ctx, control_transport_t **out)
+{
+    if (!recv || !out) return ESP_ERR_INVALID_ARG;
+    loopback_t *lb = calloc(1, sizeof(*lb));
+    if (!lb) return ESP_ERR_NO_MEM;
+    lb->base.ops = &s_loopback_ops;
+    lb->base.name = "loopback";
+    lb->base.format = format;
+    lb->recv = recv;
+    lb->ctx = ctx;
+    *out = &lb->base;
+    return ESP_OK;
+}
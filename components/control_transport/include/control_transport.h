@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One interface over the ways a control message reaches the receiver.
+ * The sending side hands an encoded payload to send() and calls poll()
+ * until it is delivered; the receiving side gets each payload through a
+ * control_transport_recv_cb_t, whichever transport carried it.
+ *
+ *   http      control_channel POSTs      control_transport_http_serve(), _serve_stream()
+ *   udp       udp_control frames + acks  control_transport_udp_listen()
+ *   loopback  in-process call            (the receive callback given to open)
+ *
+ * Control payloads carry the full state, so every transport may drop or
+ * repeat old ones; the receive callback only ever sees the newest.
+ */
+
+/**
+ * @brief What the far end expects in the payload; the sender encodes to match.
+ */
+typedef enum {
+    CONTROL_TRANSPORT_JSON,
+    CONTROL_TRANSPORT_BINARY,
+} control_transport_format_t;
+
+/**
+ * @brief Receiving side: apply one payload.
+ *
+ * Return ESP_OK once applied, ESP_ERR_INVALID_ARG for a malformed payload
+ * (answered with 400 over HTTP, counted as failed by the loopback).
+ */
+typedef esp_err_t (*control_transport_recv_cb_t)(const void *payload, size_t len, void *ctx);
+
+// Bytes read per control_transport_chunk_cb_t call at most
+#define CONTROL_TRANSPORT_CHUNK     64
+
+/**
+ * @brief Streaming receiving side: one piece of the body, in order.
+ *
+ * Return ESP_OK to go on; any error stops reading the body.
+ */
+typedef esp_err_t (*control_transport_chunk_cb_t)(const void *chunk, size_t len, void *ctx);
+
+/**
+ * @brief Streaming receiving side: the body is over.
+ *
+ * @p err is ESP_OK when every chunk was taken, else the chunk callback's
+ * error. Return ESP_OK once the message is applied.
+ */
+typedef esp_err_t (*control_transport_end_cb_t)(esp_err_t err, void *ctx);
+
+/**
+ * @brief Sending side counters, the same for every transport.
+ */
+typedef struct {
+    uint32_t sent;              // payloads handed to send()
+    uint32_t delivered;         // confirmed applied: 2xx response, ack, or callback ESP_OK
+    uint32_t failed;            // rejected, expired or superseded
+    uint32_t in_flight;         // sent, neither delivered nor failed yet; HTTP counts requests waiting to reconnect
+    uint64_t latency_total_us;  // send() to confirmation, over delivered
+    uint32_t latency_max_us;
+    uint32_t latency_last_us;
+} control_transport_stats_t;
+
+typedef struct control_transport control_transport_t;
+
+typedef struct {
+    esp_err_t (*send)(control_transport_t *t, const void *payload, size_t len);
+    esp_err_t (*poll)(control_transport_t *t, uint32_t timeout_ms);
+    void (*get_stats)(control_transport_t *t, control_transport_stats_t *stats);
+    void (*close)(control_transport_t *t);
+} control_transport_ops_t;
+
+/**
+ * @brief Common head of every transport; implementations embed it first.
+ */
+struct control_transport {
+    const control_transport_ops_t *ops;
+    const char *name;
+    control_transport_format_t format;
+};
+
+/**
+ * @brief HTTP: keep-alive, pipelined POSTs to http://host:port/path (control_channel).
+ *
+ * @p format picks the Content-Type: application/json or application/octet-stream.
+ * @p host is copied; @p path must outlive the transport.
+ */
+esp_err_t control_transport_http_open(const char *host, uint16_t port, const char *path,
+                                      control_transport_format_t format, control_transport_t **out);
+
+/**
+ * @brief UDP: udp_control frames to host:port, retransmitted until acked. Binary payloads.
+ */
+esp_err_t control_transport_udp_open(const char *host, uint16_t port, control_transport_t **out);
+
+/**
+ * @brief Loopback: send() calls @p recv in the caller's context and counts it
+ *        delivered when it returns ESP_OK.
+ */
+esp_err_t control_transport_loopback_open(control_transport_format_t format, control_transport_recv_cb_t recv,
+                                          void *ctx, control_transport_t **out);
+
+/**
+ * @brief Hand one payload to the transport. Blocks at most as long as the
+ *        transport's own send does (HTTP: when the pipeline is full).
+ */
+esp_err_t control_transport_send(control_transport_t *t, const void *payload, size_t len);
+
+/**
+ * @brief Wait for confirmations and retry for up to @p timeout_ms;
+ *        returns early once nothing is in flight.
+ */
+esp_err_t control_transport_poll(control_transport_t *t, uint32_t timeout_ms);
+
+void control_transport_get_stats(control_transport_t *t, control_transport_stats_t *stats);
+
+void control_transport_close(control_transport_t *t);
+
+/**
+ * @brief Receiving side of the HTTP transport, for use inside a POST handler.
+ *
+ * Reads the whole body (up to CONTROL_CHANNEL_MAX_BODY), passes it to @p recv
+ * and answers 200, 400 (invalid payload) or 408.
+ */
+esp_err_t control_transport_http_serve(httpd_req_t *req, control_transport_recv_cb_t recv, void *ctx);
+
+/**
+ * @brief Like control_transport_http_serve(), for a parser that takes the
+ *        body as it arrives: no body buffer, any Content-Length.
+ *
+ * Each read of up to CONTROL_TRANSPORT_CHUNK bytes goes to @p chunk; then
+ * @p end is called once, after the last chunk or the first one rejected.
+ * Its result picks the answer: 200 or 400. A failed read answers 408 on a
+ * timeout and calls neither.
+ */
+esp_err_t control_transport_http_serve_stream(httpd_req_t *req, control_transport_chunk_cb_t chunk,
+                                              control_transport_end_cb_t end, void *ctx);
+
+/**
+ * @brief Receiving side of the UDP transport: starts the udp_control receiver
+ *        on @p port and passes it the newest payloads only.
+ *
+ * One listener per application.
+ */
+esp_err_t control_transport_udp_listen(uint16_t port, control_transport_recv_cb_t recv, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "control_channel.h"
+#include "control_msg.h"
+#include "control_transport.h"
+
+static const char *TAG = "control_transport";
+
+// Either codec's largest message must go out and come in whole
+_Static_assert(CONTROL_CHANNEL_MAX_BODY >= CONTROL_MSG_JSON_MAX && CONTROL_CHANNEL_MAX_BODY >= CONTROL_MSG_BINARY_MAX,
+               "CONTROL_CHANNEL_MAX_BODY is smaller than a control_msg payload");
+
+typedef struct {
+    control_transport_t base;
+    control_channel_t *channel;
+    char host[64];              // copied: the channel reconnects with it
+} http_transport_t;
+
+static esp_err_t http_send(control_transport_t *t, const void *payload, size_t len)
+{
+    return control_channel_send(((http_transport_t *)t)->channel, payload, len);
+}
+
+static esp_err_t http_poll(control_transport_t *t, uint32_t timeout_ms)
+{
+    return control_channel_poll(((http_transport_t *)t)->channel, timeout_ms);
+}
+
+static void http_get_stats(control_transport_t *t, control_transport_stats_t *stats)
+{
+    control_channel_stats_t st;
+    control_channel_get_stats(((http_transport_t *)t)->channel, &st);
+    *stats = (control_transport_stats_t) {
+        .sent = st.sent - st.resent,
+        .delivered = st.completed,
+        .failed = st.rejected,
+        .in_flight = st.in_flight,
+        .latency_total_us = st.latency_total_us,
+        .latency_max_us = st.latency_max_us,
+        .latency_last_us = st.latency_last_us,
+    };
+}
+
+static void http_close(control_transport_t *t)
+{
+    control_channel_close(((http_transport_t *)t)->channel);
+    free(t);
+}
+
+static const control_transport_ops_t s_http_ops = {
+    .send = http_send,
+    .poll = http_poll,
+    .get_stats = http_get_stats,
+    .close = http_close,
+};
+
+esp_err_t control_transport_http_open(const char *host, uint16_t port, const char *path,
+                                      control_transport_format_t format, control_transport_t **out)
+{
+    if (!host || !out || strlen(host) >= sizeof(((http_transport_t *)0)->host)) return ESP_ERR_INVALID_ARG;
+    http_transport_t *ht = calloc(1, sizeof(*ht));
+    if (!ht) return ESP_ERR_NO_MEM;
+
+    control_channel_config_t config = CONTROL_CHANNEL_DEFAULT_CONFIG();
+    snprintf(ht->host, sizeof(ht->host), "%s", host);
+    config.host = ht->host;
+    config.port = port;
+    config.path = path;
+    config.content_type = format == CONTROL_TRANSPORT_JSON ? "application/json" : "application/octet-stream";
+    esp_err_t err = control_channel_open(&config, &ht->channel);
+    if (err != ESP_OK) {
+        free(ht);
+        return err;
+    }
+    ht->base.ops = &s_http_ops;
+    ht->base.name = "http";
+    ht->base.format = format;
+    *out = &ht->base;
+    return ESP_OK;
+}
+
+// httpd_req_recv() gave ret <= 0: 408 on a timeout; either way the connection is dropped
+static esp_err_t recv_failed(httpd_req_t *req, int ret)
+{
+    if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "http: body timeout");
+        httpd_resp_send_408(req);
+    }
+    return ESP_FAIL;
+}
+
+// 200 once applied, 400 otherwise; the rest of a rejected body is discarded by the server
+static esp_err_t respond(httpd_req_t *req, esp_err_t err)
+{
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid control message");
+        return ESP_OK;
+    }
+    return httpd_resp_sendstr(req, "Data received and processed");
+}
+
+esp_err_t control_transport_http_serve(httpd_req_t *req, control_transport_recv_cb_t recv, void *ctx)
+{
+    char body[CONTROL_CHANNEL_MAX_BODY];
+    if (req->content_len > sizeof(body)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Control message too long");
+        return ESP_OK;
+    }
+
+    size_t got = 0;
+    while (got < req->content_len) {
+        int ret = httpd_req_recv(req, body + got, req->content_len - got);
+        if (ret <= 0) return recv_failed(req, ret);
+        got += ret;
+    }
+    return respond(req, recv(body, got, ctx));
+}
+
+esp_err_t control_transport_http_serve_stream(httpd_req_t *req, control_transport_chunk_cb_t chunk,
+                                              control_transport_end_cb_t end, void *ctx)
+{
+    char buf[CONTROL_TRANSPORT_CHUNK];
+    size_t remaining = req->content_len;
+    esp_err_t err = ESP_OK;
+    while (remaining > 0 && err == ESP_OK) {
+        int ret = httpd_req_recv(req, buf, remaining < sizeof(buf) ? remaining : sizeof(buf));
+        if (ret <= 0) return recv_failed(req, ret);
+        remaining -= ret;
+        err = chunk(buf, ret, ctx);
+    }
+    return respond(req, end(err, ctx));
+}
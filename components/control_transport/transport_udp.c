@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include "esp_log.h"
+#include "udp_control.h"
+#include "control_transport.h"
+
+static const char *TAG = "control_transport";
+
+typedef struct {
+    control_transport_t base;
+    udp_control_sender_t *sender;
+} udp_transport_t;
+
+static esp_err_t udp_send(control_transport_t *t, const void *payload, size_t len)
+{
+    return udp_control_send(((udp_transport_t *)t)->sender, payload, len);
+}
+
+static esp_err_t udp_poll(control_transport_t *t, uint32_t timeout_ms)
+{
+    return udp_control_sender_poll(((udp_transport_t *)t)->sender, timeout_ms);
+}
+
+static void udp_get_stats(control_transport_t *t, control_transport_stats_t *stats)
+{
+    udp_control_sender_stats_t st;
+    udp_control_sender_get_stats(((udp_transport_t *)t)->sender, &st);
+    *stats = (control_transport_stats_t) {
+        .sent = st.sent,
+        .delivered = st.acked,
+        .failed = st.expired + st.superseded,
+        .in_flight = st.in_flight,
+        .latency_total_us = st.rtt_total_us,
+        .latency_max_us = st.rtt_max_us,
+        .latency_last_us = st.rtt_last_us,
+    };
+}
+
+static void udp_close(control_transport_t *t)
+{
+    udp_control_sender_close(((udp_transport_t *)t)->sender);
+    free(t);
+}
+
+static const control_transport_ops_t s_udp_ops = {
+    .send = udp_send,
+    .poll = udp_poll,
+    .get_stats = udp_get_stats,
+    .close = udp_close,
+};
+
+esp_err_t control_transport_udp_open(const char *host, uint16_t port, control_transport_t **out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    udp_transport_t *ut = calloc(1, sizeof(*ut));
+    if (!ut) return ESP_ERR_NO_MEM;
+
+    udp_control_sender_config_t config = UDP_CONTROL_SENDER_DEFAULT_CONFIG();
+    config.host = host;
+    config.port = port;
+    esp_err_t err = udp_control_sender_open(&config, &ut->sender);
+    if (err != ESP_OK) {
+        free(ut);
+        return err;
+    }
+    ut->base.ops = &s_udp_ops;
+    ut->base.name = "udp";
+    ut->base.format = CONTROL_TRANSPORT_BINARY;
+    *out = &ut->base;
+    return ESP_OK;
+}
+
+// --- Receiving side ---
+
+static control_transport_recv_cb_t s_recv;
+static void *s_recv_ctx;
+
+static void udp_frame_handler(const uint8_t *payload, size_t len, uint32_t seq, bool latest, void *ctx)
+{
+    if (!latest) return;    // reordered; a newer state is already applied
+    if (s_recv(payload, len, s_recv_ctx) != ESP_OK) {
+        ESP_LOGD(TAG, "udp: frame %u rejected", (unsigned)seq);
+    }
+}
+
+esp_err_t control_transport_udp_listen(uint16_t port, control_transport_recv_cb_t recv, void *ctx)
+{
+    if (!recv) return ESP_ERR_INVALID_ARG;
+    if (s_recv) return ESP_ERR_INVALID_STATE;
+    s_recv = recv;
+    s_recv_ctx = ctx;
+    esp_err_t err = udp_control_receiver_start(port, udp_frame_handler, NULL);
+    if (err != ESP_OK) s_recv = NULL;
+    return err;
+}
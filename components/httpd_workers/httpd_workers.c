@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "httpd_workers.h"
+#include "json_stream.h"
+#include "metrics.h"
+#include "resp_writer.h"
+
+static const char *TAG = "httpd_workers";
+
+typedef struct httpd_workers_route route_t;
+
+struct httpd_workers_route {
+    httpd_uri_t uri;            // copy handed to httpd, handler = trampoline (registered routes only)
+    esp_err_t (*handler)(httpd_req_t *req);
+    httpd_workers_route_stats_t stats;
+    char labels[48];            // route="<uri>" for the exported metrics
+    metrics_histogram_t latency;
+    metrics_counter_t errors;
+    route_t *next;
+};
+
+static const uint32_t s_latency_bounds_us[] = METRICS_HTTP_BUCKETS_US;
+
+typedef struct {
+    httpd_req_t *req;           // async copy, owned by the worker
+    esp_err_t (*handler)(httpd_req_t *req);
+    route_t *route;
+    int64_t arrived_us;
+    bool offloaded;             // from httpd_workers_offload(), counts against offload_limit
+} job_t;
+
+// Append-only, so readers walk it without the lock
+static route_t *s_routes = NULL;
+static route_t **s_routes_tail = &s_routes;
+static QueueHandle_t s_jobs = NULL;
+static TaskHandle_t s_workers[HTTPD_WORKERS_MAX_WORKERS];
+static size_t s_num_workers = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t s_offload_limit = 0;
+static size_t s_offload_active = 0;     // httpd_workers_offload() jobs queued or running
+
+// Queue counters
+static uint32_t s_submitted = 0;
+static uint32_t s_queue_max = 0;
+static metrics_counter_t s_rejected = METRICS_COUNTER_INIT(
+    "http_worker_rejected_total", "Requests answered 503 because the worker pool was busy");
+
+static void record(route_t *route, int64_t arrived_us, int64_t started_us, esp_err_t err)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t total = (uint32_t)(now - arrived_us);
+
+    metrics_histogram_observe(&route->latency, total);
+    if (err != ESP_OK) metrics_counter_inc(&route->errors);
+
+    portENTER_CRITICAL(&s_mux);
+    httpd_workers_route_stats_t *st = &route->stats;
+    st->count++;
+    if (err != ESP_OK) st->errors++;
+    st->total_us += total;
+    if (total > st->max_us) st->max_us = total;
+    st->queue_wait_us += (uint64_t)(started_us - arrived_us);
+    portEXIT_CRITICAL(&s_mux);
+}
+
+static void worker_task(void *arg)
+{
+    job_t job;
+    while (1) {
+        if (xQueueReceive(s_jobs, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        int64_t started = esp_timer_get_time();
+        esp_err_t err = job.handler(job.req);
+        if (job.route) record(job.route, job.arrived_us, started, err);
+        if (httpd_req_async_handler_complete(job.req) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to complete async request");
+        }
+        if (job.offloaded) {
+            portENTER_CRITICAL(&s_mux);
+            s_offload_active--;
+            portEXIT_CRITICAL(&s_mux);
+        }
+    }
+}
+
+bool httpd_workers_on_worker(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < s_num_workers; i++) {
+        if (s_workers[i] == self) return true;
+    }
+    return false;
+}
+
+// Hand @p req to a worker; false when the pool is missing or its queue is full
+static bool submit(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req),
+                   route_t *route, int64_t arrived_us, bool offloaded)
+{
+    if (!s_jobs) return false;
+
+    job_t job = { .handler = handler, .route = route, .arrived_us = arrived_us, .offloaded = offloaded };
+    if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+        return false;
+    }
+    if (xQueueSend(s_jobs, &job, 0) != pdTRUE) {
+        httpd_req_async_handler_complete(job.req);
+        return false;
+    }
+
+    uint32_t depth = uxQueueMessagesWaiting(s_jobs);
+    portENTER_CRITICAL(&s_mux);
+    s_submitted++;
+    if (depth > s_queue_max) s_queue_max = depth;
+    portEXIT_CRITICAL(&s_mux);
+    return true;
+}
+
+esp_err_t httpd_workers_send_busy(httpd_req_t *req)
+{
+    metrics_counter_inc(&s_rejected);
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", "1");
+    return httpd_resp_send(req, "Server busy", HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_workers_run(httpd_workers_route_t *route, httpd_req_t *req)
+{
+    int64_t arrived = esp_timer_get_time();
+    req->user_ctx = route;      // lets httpd_workers_offload() account to the route
+
+    if (route->stats.mode == HTTPD_WORKERS_OFFLOAD) {
+        if (submit(req, route->handler, route, arrived, false)) return ESP_OK;
+        // Running it here would stall every other connection for the whole transfer
+        ESP_LOGW(TAG, "Worker queue full, rejecting %s", route->stats.uri);
+        esp_err_t err = httpd_workers_send_busy(req);
+        record(route, arrived, arrived, ESP_FAIL);
+        return err;
+    }
+
+    esp_err_t err = route->handler(req);
+    record(route, arrived, arrived, err);
+    return err;
+}
+
+static esp_err_t trampoline(httpd_req_t *req)
+{
+    return httpd_workers_run((route_t *)req->user_ctx, req);
+}
+
+static bool is_route(const void *ctx)
+{
+    for (route_t *r = s_routes; r; r = r->next) {
+        if (r == ctx) return true;
+    }
+    return false;
+}
+
+esp_err_t httpd_workers_offload(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req))
+{
+    if (httpd_workers_on_worker()) return ESP_ERR_INVALID_STATE;
+
+    // Routes registered here carry their table entry; others are just not accounted
+    route_t *route = is_route(req->user_ctx) ? (route_t *)req->user_ctx : NULL;
+
+    portENTER_CRITICAL(&s_mux);
+    bool allowed = s_offload_active < s_offload_limit;
+    if (allowed) s_offload_active++;
+    portEXIT_CRITICAL(&s_mux);
+    if (!allowed) return ESP_ERR_NO_MEM;
+
+    if (!submit(req, handler, route, esp_timer_get_time(), true)) {
+        portENTER_CRITICAL(&s_mux);
+        s_offload_active--;
+        portEXIT_CRITICAL(&s_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static int64_t read_queue_depth(void)
+{
+    return s_jobs ? uxQueueMessagesWaiting(s_jobs) : 0;
+}
+
+// Smallest stack headroom of any worker, to size stack_size from the field
+static int64_t read_worker_stack_free(void)
+{
+    int64_t min_free = -1;
+    for (size_t i = 0; i < s_num_workers; i++) {
+        int64_t free_bytes = uxTaskGetStackHighWaterMark(s_workers[i]) * sizeof(StackType_t);
+        if (min_free < 0 || free_bytes < min_free) min_free = free_bytes;
+    }
+    return min_free;
+}
+
+esp_err_t httpd_workers_start(const httpd_workers_config_t *config)
+{
+    if (s_jobs) return ESP_ERR_INVALID_STATE;
+    if (config->num_workers == 0 || config->num_workers > HTTPD_WORKERS_MAX_WORKERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_offload_limit = config->offload_limit;
+
+    s_jobs = xQueueCreate(config->queue_len, sizeof(job_t));
+    if (!s_jobs) return ESP_ERR_NO_MEM;
+
+    for (size_t i = 0; i < config->num_workers; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "httpd_wrk%u", (unsigned)i);
+        if (xTaskCreate(worker_task, name, config->stack_size, NULL,
+                        config->priority, &s_workers[i]) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %u", (unsigned)i);
+            break;
+        }
+        s_num_workers++;
+    }
+    if (s_num_workers == 0) return ESP_ERR_NO_MEM;
+
+    static metrics_gauge_t queue_depth = METRICS_GAUGE_INIT(
+        "http_worker_queue_depth", "Offloaded requests waiting for a worker", read_queue_depth);
+    static metrics_gauge_t stack_free = METRICS_GAUGE_INIT(
+        "http_worker_stack_free_min_bytes", "Lowest stack high-water mark of the HTTP workers", read_worker_stack_free);
+    metrics_register(&queue_depth.base);
+    metrics_register(&stack_free.base);
+    metrics_register(&s_rejected.base);
+
+    ESP_LOGI(TAG, "%u HTTP workers, queue %u", (unsigned)s_num_workers, (unsigned)config->queue_len);
+    return ESP_OK;
+}
+
+static route_t *new_route(const char *uri, esp_err_t (*handler)(httpd_req_t *req),
+                          httpd_workers_mode_t mode)
+{
+    route_t *route = calloc(1, sizeof(*route));
+    if (!route) return NULL;
+    route->handler = handler;
+    route->stats.uri = uri;
+    route->stats.mode = mode;
+    return route;
+}
+
+// Metrics and listing; the route is live from here on
+static void publish(route_t *route)
+{
+    snprintf(route->labels, sizeof(route->labels), "route=\"%s\"", route->stats.uri);
+    metrics_histogram_init(&route->latency, "http_request_duration_seconds",
+                           "Time from request arrival to handler return",
+                           route->labels, s_latency_bounds_us,
+                           sizeof(s_latency_bounds_us) / sizeof(s_latency_bounds_us[0]));
+    route->errors = (metrics_counter_t)METRICS_COUNTER_INIT(
+        "http_request_errors_total", "Requests whose handler returned an error");
+    route->errors.base.labels = route->labels;
+    metrics_register(&route->errors.base);
+
+    portENTER_CRITICAL(&s_mux);
+    *s_routes_tail = route;
+    s_routes_tail = &route->next;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+esp_err_t httpd_workers_add_route(const char *uri, esp_err_t (*handler)(httpd_req_t *req),
+                                  httpd_workers_mode_t mode, httpd_workers_route_t **out)
+{
+    route_t *route = new_route(uri, handler, mode);
+    if (!route) return ESP_ERR_NO_MEM;
+    publish(route);
+    *out = route;
+    return ESP_OK;
+}
+
+esp_err_t httpd_workers_register_uri(httpd_handle_t server, const httpd_uri_t *uri,
+                                     httpd_workers_mode_t mode)
+{
+    route_t *route = new_route(uri->uri, uri->handler, mode);
+    if (!route) return ESP_ERR_NO_MEM;
+    route->uri = *uri;
+    route->uri.handler = trampoline;
+    route->uri.user_ctx = route;
+
+    esp_err_t err = httpd_register_uri_handler(server, &route->uri);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register %s: %s", uri->uri, esp_err_to_name(err));
+        free(route);
+        return err;
+    }
+    publish(route);
+    return ESP_OK;
+}
+
+size_t httpd_workers_get_route_stats(httpd_workers_route_stats_t *out, size_t max)
+{
+    size_t n = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (route_t *r = s_routes; r; r = r->next, n++) {
+        if (n < max) out[n] = r->stats;
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return n;
+}
+
+esp_err_t httpd_workers_stats_handler(httpd_req_t *req)
+{
+    portENTER_CRITICAL(&s_mux);
+    uint32_t submitted = s_submitted, queue_max = s_queue_max, offload_active = s_offload_active;
+    portEXIT_CRITICAL(&s_mux);
+
+    char chunk[256];
+    json_stream_t js;
+    resp_writer_t w;
+    httpd_resp_set_type(req, "application/json");
+    resp_writer_init(&w, req);
+    json_stream_init_flush(&js, chunk, sizeof(chunk), resp_writer_sink, &w);
+    json_stream_begin_object(&js);
+    json_stream_kv_uint(&js, "workers", s_num_workers);
+    json_stream_kv_uint(&js, "queue_depth", s_jobs ? uxQueueMessagesWaiting(s_jobs) : 0);
+    json_stream_kv_uint(&js, "queue_max", queue_max);
+    json_stream_kv_uint(&js, "submitted", submitted);
+    json_stream_kv_uint(&js, "rejected", atomic_load(&s_rejected.value));
+    json_stream_kv_uint(&js, "offload_active", offload_active);
+    json_stream_key(&js, "routes");
+    json_stream_begin_array(&js);
+    // One route copied at a time; however many uri_router adds, nothing big on the stack
+    for (route_t *r = s_routes; r; r = r->next) {
+        portENTER_CRITICAL(&s_mux);
+        httpd_workers_route_stats_t copy = r->stats;
+        portEXIT_CRITICAL(&s_mux);
+        const httpd_workers_route_stats_t *st = &copy;
+        json_stream_begin_object(&js);
+        json_stream_kv_string(&js, "uri", st->uri);
+        json_stream_kv_string(&js, "mode", st->mode == HTTPD_WORKERS_OFFLOAD ? "offload" : "inline");
+        json_stream_kv_uint(&js, "count", st->count);
+        json_stream_kv_uint(&js, "errors", st->errors);
+        json_stream_kv_uint(&js, "avg_us", st->count ? st->total_us / st->count : 0);
+        json_stream_kv_uint(&js, "max_us", st->max_us);
+        json_stream_kv_uint(&js, "avg_queue_wait_us", st->count ? st->queue_wait_us / st->count : 0);
+        json_stream_end_object(&js);
+    }
+    json_stream_end_array(&js);
+    json_stream_end_object(&js);
+    if (json_stream_finish(&js) != ESP_OK) {
+        resp_writer_discard(&w);
+        return ESP_FAIL;
+    }
+    return resp_writer_finish(&w);
+}
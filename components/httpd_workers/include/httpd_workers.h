@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTPD_WORKERS_MAX_WORKERS   4
+
+/**
+ * @brief Where a route's handler runs.
+ */
+typedef enum {
+    HTTPD_WORKERS_INLINE,   // on the httpd server task (short API handlers)
+    HTTPD_WORKERS_OFFLOAD,  // on a worker task via the async request API (long transfers)
+} httpd_workers_mode_t;
+
+/**
+ * @brief Worker pool configuration.
+ */
+typedef struct {
+    size_t num_workers;     // <= HTTPD_WORKERS_MAX_WORKERS
+    size_t queue_len;       // pending offloaded requests before answering 503
+    size_t offload_limit;   // httpd_workers_offload() requests queued or running at once
+    uint32_t stack_size;
+    UBaseType_t priority;
+} httpd_workers_config_t;
+
+// offload_limit < num_workers leaves a worker for offloaded routes however
+// many handlers block in httpd_workers_offload()
+#define HTTPD_WORKERS_DEFAULT_CONFIG() {    \
+    .num_workers = 2,                       \
+    .queue_len = 4,                         \
+    .offload_limit = 1,                     \
+    .stack_size = 4096,                     \
+    .priority = 5,                          \
+}
+
+/**
+ * @brief Latency counters of one route, from request arrival to handler return.
+ */
+typedef struct {
+    const char *uri;
+    httpd_workers_mode_t mode;
+    uint32_t count;
+    uint32_t errors;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t queue_wait_us;     // offloaded routes: time spent waiting for a worker
+} httpd_workers_route_stats_t;
+
+/**
+ * @brief Create the worker tasks and the job queue.
+ */
+esp_err_t httpd_workers_start(const httpd_workers_config_t *config);
+
+/**
+ * @brief Register @p uri so its handler runs inline or on a worker, with latency accounting.
+ *
+ * The component keeps the route in its own table and takes over
+ * httpd_uri_t::user_ctx; handlers must not rely on it.
+ * Offloaded requests are answered 503 (Retry-After: 1) when the queue is
+ * full; they never run on the server task.
+ * Each route gets an http_request_duration_seconds histogram and an
+ * http_request_errors_total counter labelled with its URI (see metrics.h).
+ */
+esp_err_t httpd_workers_register_uri(httpd_handle_t server, const httpd_uri_t *uri,
+                                     httpd_workers_mode_t mode);
+
+/**
+ * @brief A route created by httpd_workers_add_route().
+ */
+typedef struct httpd_workers_route httpd_workers_route_t;
+
+/**
+ * @brief Create a route with the accounting of httpd_workers_register_uri(),
+ *        but register nothing with httpd.
+ *
+ * For dispatchers that match URIs themselves (see uri_router.h): their
+ * httpd handler picks the route and calls httpd_workers_run(). @p uri
+ * labels the route's stats and metrics and must outlive it.
+ */
+esp_err_t httpd_workers_add_route(const char *uri, esp_err_t (*handler)(httpd_req_t *req),
+                                  httpd_workers_mode_t mode, httpd_workers_route_t **out);
+
+/**
+ * @brief Serve @p req with @p route from an httpd handler: inline or on a
+ *        worker as the route's mode says, recorded like a registered route.
+ */
+esp_err_t httpd_workers_run(httpd_workers_route_t *route, httpd_req_t *req);
+
+/**
+ * @brief Move a request to a worker from inside an inline handler.
+ *
+ * For handlers that only sometimes block (e.g. long-poll). The worker
+ * calls @p handler with an async copy of @p req; the inline caller must
+ * return ESP_OK right away without touching @p req again. At most
+ * offload_limit such requests hold the pool at a time, so blocking
+ * handlers cannot starve the offloaded routes.
+ *
+ * @return ESP_OK if queued, ESP_ERR_INVALID_STATE if already on a worker,
+ *         ESP_ERR_NO_MEM if the limit is reached or the queue is full; the
+ *         caller then answers with httpd_workers_send_busy() instead of
+ *         blocking the server task.
+ */
+esp_err_t httpd_workers_offload(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req));
+
+/**
+ * @brief Answer 503 Service Unavailable with Retry-After: 1 and count it as rejected.
+ */
+esp_err_t httpd_workers_send_busy(httpd_req_t *req);
+
+/**
+ * @brief True when called from one of the worker tasks.
+ */
+bool httpd_workers_on_worker(void);
+
+/**
+ * @brief Number of registered routes; fills @p out with up to @p max entries.
+ */
+size_t httpd_workers_get_route_stats(httpd_workers_route_stats_t *out, size_t max);
+
+/**
+ * @brief URI handler reporting queue depth and per-route latency as JSON.
+ */
+esp_err_t httpd_workers_stats_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
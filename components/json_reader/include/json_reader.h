@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum object/array nesting depth
+#define JSON_READER_MAX_DEPTH   4
+// Member names are kept up to this many bytes (including the terminator); longer ones are cut
+#define JSON_READER_KEY_MAX     24
+// String and number values are kept up to this many bytes; longer strings are cut and flagged
+#define JSON_READER_VALUE_MAX   128
+
+typedef enum {
+    JSON_READER_NULL,
+    JSON_READER_BOOL,
+    JSON_READER_NUMBER,
+    JSON_READER_STRING,
+    JSON_READER_OBJECT_START,
+    JSON_READER_OBJECT_END,
+    JSON_READER_ARRAY_START,
+    JSON_READER_ARRAY_END,
+} json_reader_event_t;
+
+/**
+ * @brief One parse event. Pointers are only valid during the callback.
+ */
+typedef struct {
+    json_reader_event_t event;
+    uint8_t depth;              // containers around the value: 1 for members of the top-level object
+    const char *key;            // member name, "" for array elements and the top-level value
+    const char *parent;         // name of the member holding the enclosing container, "" if none
+    bool boolean;
+    double number;
+    const char *str;            // JSON_READER_STRING: unescaped UTF-8, NUL terminated
+    size_t len;
+    bool truncated;             // string longer than JSON_READER_VALUE_MAX - 1
+} json_reader_value_t;
+
+/**
+ * @brief Called for every scalar and container boundary; anything but ESP_OK stops the parse.
+ */
+typedef esp_err_t (*json_reader_cb_t)(const json_reader_value_t *value, void *ctx);
+
+/**
+ * @brief Parser state. Lives on the caller's stack; never allocates.
+ */
+typedef struct {
+    json_reader_cb_t cb;
+    void *ctx;
+    uint8_t state;
+    uint8_t depth;
+    uint8_t is_array;           // bit n: container n (from 1) is an array
+    bool in_key;                // the string being read is a member name
+    bool truncated;
+    const char *literal;        // expected "true" / "false" / "null"
+    uint8_t literal_pos;
+    uint8_t hex_digits;
+    uint16_t hex;
+    uint16_t high_surrogate;    // first half of a \u surrogate pair
+    size_t len;                 // bytes in buf, or in the key being read
+    esp_err_t err;              // first error seen, sticky
+    char keys[JSON_READER_MAX_DEPTH + 1][JSON_READER_KEY_MAX];
+    char buf[JSON_READER_VALUE_MAX];
+} json_reader_t;
+
+void json_reader_init(json_reader_t *r, json_reader_cb_t cb, void *ctx);
+
+/**
+ * @brief Parse the next @p len bytes. Input may be split anywhere,
+ *        including inside strings, escapes and numbers.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG on a syntax error, ESP_ERR_INVALID_SIZE
+ *         past JSON_READER_MAX_DEPTH, or the callback's error. Sticky.
+ */
+esp_err_t json_reader_feed(json_reader_t *r, const char *data, size_t len);
+
+/**
+ * @brief End of input: ESP_OK only if exactly one complete value was read.
+ */
+esp_err_t json_reader_finish(json_reader_t *r);
+
+// --- Binding top-level members to a struct ---
+
+typedef enum {
+    JSON_READER_FIELD_BOOL,
+    JSON_READER_FIELD_INT32,
+    JSON_READER_FIELD_STRING,   // cut to size - 1 bytes, always terminated
+} json_reader_field_type_t;
+
+typedef struct {
+    const char *key;
+    json_reader_field_type_t type;
+    size_t offset;
+    size_t size;
+} json_reader_field_t;
+
+#define JSON_READER_FIELD(type_, struct_, member_) \
+    { #member_, (type_), offsetof(struct_, member_), sizeof(((struct_ *)0)->member_) }
+
+/**
+ * @brief Context for json_reader_bind_cb(): stores members of the top-level
+ *        object named in @p fields into @p out and passes every other event on.
+ */
+typedef struct {
+    const json_reader_field_t *fields;
+    size_t num_fields;          // <= 32
+    void *out;
+    uint32_t seen;              // bit n: fields[n] was set
+    json_reader_cb_t other;     // may be NULL
+    void *other_ctx;
+} json_reader_bind_t;
+
+/**
+ * @brief json_reader_cb_t for a json_reader_bind_t context. A bound member
+ *        of the wrong type fails the parse with ESP_ERR_INVALID_ARG.
+ */
+esp_err_t json_reader_bind_cb(const json_reader_value_t *value, void *ctx);
+
+static inline bool json_reader_bind_has_all(const json_reader_bind_t *b)
+{
+    return b->seen == (b->num_fields >= 32 ? UINT32_MAX : (1u << b->num_fields) - 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,388 @@
+#include <stdlib.h>
+#include <string.h>
+#include "json_reader.h"
+
+typedef enum {
+    ST_VALUE,           // a value must follow: top level, after ':' or after ',' in an array
+    ST_VALUE_OR_END,    // after '['
+    ST_KEY,             // after ',' in an object
+    ST_KEY_OR_END,      // after '{'
+    ST_COLON,
+    ST_AFTER_VALUE,     // ',' or the closing bracket
+    ST_STRING,
+    ST_ESCAPE,
+    ST_UNICODE,
+    ST_NUMBER,
+    ST_LITERAL,
+    ST_DONE,            // top-level value complete, only whitespace may follow
+} state_t;
+
+void json_reader_init(json_reader_t *r, json_reader_cb_t cb, void *ctx)
+{
+    memset(r, 0, sizeof(*r));
+    r->cb = cb;
+    r->ctx = ctx;
+    r->state = ST_VALUE;
+}
+
+static bool is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool in_array(const json_reader_t *r)
+{
+    return r->depth > 0 && (r->is_array & (1u << r->depth));
+}
+
+static esp_err_t fail(json_reader_t *r, esp_err_t err)
+{
+    if (r->err == ESP_OK) r->err = err;
+    return r->err;
+}
+
+static esp_err_t emit(json_reader_t *r, json_reader_value_t *v, uint8_t depth)
+{
+    v->depth = depth;
+    v->key = r->keys[depth];
+    v->parent = depth > 0 ? r->keys[depth - 1] : "";
+    esp_err_t err = r->cb ? r->cb(v, r->ctx) : ESP_OK;
+    return err == ESP_OK ? ESP_OK : fail(r, err);
+}
+
+// A value at the current depth is complete
+static void value_done(json_reader_t *r)
+{
+    r->state = r->depth == 0 ? ST_DONE : ST_AFTER_VALUE;
+}
+
+static esp_err_t open_container(json_reader_t *r, bool array)
+{
+    if (r->depth == JSON_READER_MAX_DEPTH) return fail(r, ESP_ERR_INVALID_SIZE);
+    json_reader_value_t v = { .event = array ? JSON_READER_ARRAY_START : JSON_READER_OBJECT_START };
+    esp_err_t err = emit(r, &v, r->depth);
+    if (err != ESP_OK) return err;
+
+    r->depth++;
+    if (array) r->is_array |= 1u << r->depth; else r->is_array &= ~(1u << r->depth);
+    r->keys[r->depth][0] = '\0';    // array elements have no name
+    r->state = array ? ST_VALUE_OR_END : ST_KEY_OR_END;
+    return ESP_OK;
+}
+
+static esp_err_t close_container(json_reader_t *r, bool array)
+{
+    if (r->depth == 0 || in_array(r) != array) return fail(r, ESP_ERR_INVALID_ARG);
+    r->depth--;
+    json_reader_value_t v = { .event = array ? JSON_READER_ARRAY_END : JSON_READER_OBJECT_END };
+    esp_err_t err = emit(r, &v, r->depth);
+    if (err != ESP_OK) return err;
+    value_done(r);
+    return ESP_OK;
+}
+
+// Append one unescaped byte to the key or value being read
+static void put_byte(json_reader_t *r, char c)
+{
+    size_t cap = r->in_key ? JSON_READER_KEY_MAX : JSON_READER_VALUE_MAX;
+    if (r->len + 1 < cap) {
+        (r->in_key ? r->keys[r->depth] : r->buf)[r->len++] = c;
+    } else {
+        r->truncated = true;
+    }
+}
+
+static void put_utf8(json_reader_t *r, uint32_t cp)
+{
+    if (cp < 0x80) {
+        put_byte(r, cp);
+    } else if (cp < 0x800) {
+        put_byte(r, 0xc0 | cp >> 6);
+        put_byte(r, 0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        put_byte(r, 0xe0 | cp >> 12);
+        put_byte(r, 0x80 | ((cp >> 6) & 0x3f));
+        put_byte(r, 0x80 | (cp & 0x3f));
+    } else {
+        put_byte(r, 0xf0 | cp >> 18);
+        put_byte(r, 0x80 | ((cp >> 12) & 0x3f));
+        put_byte(r, 0x80 | ((cp >> 6) & 0x3f));
+        put_byte(r, 0x80 | (cp & 0x3f));
+    }
+}
+
+static esp_err_t end_string(json_reader_t *r)
+{
+    if (r->in_key) {
+        r->keys[r->depth][r->len] = '\0';
+        r->state = ST_COLON;
+        return ESP_OK;
+    }
+    r->buf[r->len] = '\0';
+    json_reader_value_t v = {
+        .event = JSON_READER_STRING, .str = r->buf, .len = r->len, .truncated = r->truncated,
+    };
+    esp_err_t err = emit(r, &v, r->depth);
+    if (err != ESP_OK) return err;
+    value_done(r);
+    return ESP_OK;
+}
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+// strtod alone also takes "1.", "01", ".5" and "1e"
+static bool is_json_number(const char *p)
+{
+    if (*p == '-') p++;
+    if (*p == '0') {
+        p++;
+    } else if (is_digit(*p)) {
+        while (is_digit(*p)) p++;
+    } else {
+        return false;
+    }
+    if (*p == '.') {
+        if (!is_digit(*++p)) return false;
+        while (is_digit(*p)) p++;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-') p++;
+        if (!is_digit(*p)) return false;
+        while (is_digit(*p)) p++;
+    }
+    return *p == '\0';
+}
+
+static esp_err_t end_number(json_reader_t *r)
+{
+    r->buf[r->len] = '\0';
+    if (r->truncated || !is_json_number(r->buf)) return fail(r, ESP_ERR_INVALID_ARG);
+    json_reader_value_t v = { .event = JSON_READER_NUMBER, .number = strtod(r->buf, NULL) };
+    esp_err_t err = emit(r, &v, r->depth);
+    if (err != ESP_OK) return err;
+    value_done(r);
+    return ESP_OK;
+}
+
+static esp_err_t start_value(json_reader_t *r, char c)
+{
+    r->in_key = false;
+    r->len = 0;
+    r->truncated = false;
+    switch (c) {
+    case '{': return open_container(r, false);
+    case '[': return open_container(r, true);
+    case '"':
+        r->state = ST_STRING;
+        return ESP_OK;
+    case 't': r->literal = "true"; break;
+    case 'f': r->literal = "false"; break;
+    case 'n': r->literal = "null"; break;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            put_byte(r, c);
+            r->state = ST_NUMBER;
+            return ESP_OK;
+        }
+        return fail(r, ESP_ERR_INVALID_ARG);
+    }
+    r->literal_pos = 1;
+    r->state = ST_LITERAL;
+    return ESP_OK;
+}
+
+static esp_err_t end_literal(json_reader_t *r)
+{
+    json_reader_value_t v = { .event = JSON_READER_NULL };
+    if (r->literal[0] != 'n') {
+        v.event = JSON_READER_BOOL;
+        v.boolean = r->literal[0] == 't';
+    }
+    esp_err_t err = emit(r, &v, r->depth);
+    if (err != ESP_OK) return err;
+    value_done(r);
+    return ESP_OK;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static esp_err_t end_unicode(json_reader_t *r)
+{
+    uint16_t u = r->hex;
+    r->state = ST_STRING;
+    if (r->high_surrogate) {
+        if (u < 0xdc00 || u > 0xdfff) return fail(r, ESP_ERR_INVALID_ARG);
+        put_utf8(r, 0x10000 + ((uint32_t)(r->high_surrogate - 0xd800) << 10) + (u - 0xdc00));
+        r->high_surrogate = 0;
+    } else if (u >= 0xd800 && u <= 0xdbff) {
+        r->high_surrogate = u;      // the low half must follow as the next escape
+    } else if (u >= 0xdc00 && u <= 0xdfff) {
+        return fail(r, ESP_ERR_INVALID_ARG);
+    } else {
+        put_utf8(r, u);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t step(json_reader_t *r, char c)
+{
+    switch (r->state) {
+    case ST_STRING:
+        if (r->high_surrogate && c != '\\') return fail(r, ESP_ERR_INVALID_ARG);
+        if (c == '"') return end_string(r);
+        if (c == '\\') {
+            r->state = ST_ESCAPE;
+            return ESP_OK;
+        }
+        if ((unsigned char)c < 0x20) return fail(r, ESP_ERR_INVALID_ARG);
+        put_byte(r, c);
+        return ESP_OK;
+
+    case ST_ESCAPE: {
+        if (r->high_surrogate && c != 'u') return fail(r, ESP_ERR_INVALID_ARG);
+        char out;
+        switch (c) {
+        case '"': case '\\': case '/': out = c; break;
+        case 'b': out = '\b'; break;
+        case 'f': out = '\f'; break;
+        case 'n': out = '\n'; break;
+        case 'r': out = '\r'; break;
+        case 't': out = '\t'; break;
+        case 'u':
+            r->hex = 0;
+            r->hex_digits = 0;
+            r->state = ST_UNICODE;
+            return ESP_OK;
+        default:
+            return fail(r, ESP_ERR_INVALID_ARG);
+        }
+        put_byte(r, out);
+        r->state = ST_STRING;
+        return ESP_OK;
+    }
+
+    case ST_UNICODE: {
+        int h = hex_value(c);
+        if (h < 0) return fail(r, ESP_ERR_INVALID_ARG);
+        r->hex = r->hex << 4 | h;
+        return ++r->hex_digits == 4 ? end_unicode(r) : ESP_OK;
+    }
+
+    case ST_LITERAL:
+        if (c != r->literal[r->literal_pos]) return fail(r, ESP_ERR_INVALID_ARG);
+        return r->literal[++r->literal_pos] == '\0' ? end_literal(r) : ESP_OK;
+
+    default:
+        break;
+    }
+
+    if (is_ws(c)) return ESP_OK;
+
+    switch (r->state) {
+    case ST_VALUE_OR_END:
+        if (c == ']') return close_container(r, true);
+        return start_value(r, c);
+
+    case ST_VALUE:
+        return start_value(r, c);
+
+    case ST_KEY_OR_END:
+        if (c == '}') return close_container(r, false);
+        // fall through
+    case ST_KEY:
+        if (c != '"') return fail(r, ESP_ERR_INVALID_ARG);
+        r->in_key = true;
+        r->len = 0;
+        r->truncated = false;
+        r->state = ST_STRING;
+        return ESP_OK;
+
+    case ST_COLON:
+        if (c != ':') return fail(r, ESP_ERR_INVALID_ARG);
+        r->state = ST_VALUE;
+        return ESP_OK;
+
+    case ST_AFTER_VALUE:
+        if (c == ',') {
+            r->state = in_array(r) ? ST_VALUE : ST_KEY;
+            return ESP_OK;
+        }
+        if (c == ']' || c == '}') return close_container(r, c == ']');
+        return fail(r, ESP_ERR_INVALID_ARG);
+
+    default:    // ST_DONE
+        return fail(r, ESP_ERR_INVALID_ARG);
+    }
+}
+
+esp_err_t json_reader_feed(json_reader_t *r, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && r->err == ESP_OK; i++) {
+        char c = data[i];
+        if (r->state == ST_NUMBER) {
+            if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                put_byte(r, c);
+                continue;
+            }
+            // The delimiter belongs to whatever follows the number
+            if (end_number(r) != ESP_OK) break;
+        }
+        step(r, c);
+    }
+    return r->err;
+}
+
+esp_err_t json_reader_finish(json_reader_t *r)
+{
+    if (r->err == ESP_OK && r->state == ST_NUMBER) end_number(r);   // top-level number
+    if (r->err == ESP_OK && r->state != ST_DONE) fail(r, ESP_ERR_INVALID_ARG);
+    return r->err;
+}
+
+// --- Binding ---
+
+esp_err_t json_reader_bind_cb(const json_reader_value_t *value, void *ctx)
+{
+    json_reader_bind_t *b = ctx;
+    if (value->depth == 1) {
+        for (size_t i = 0; i < b->num_fields; i++) {
+            const json_reader_field_t *f = &b->fields[i];
+            if (strcmp(f->key, value->key) != 0) continue;
+
+            char *dst = (char *)b->out + f->offset;
+            switch (f->type) {
+            case JSON_READER_FIELD_BOOL:
+                if (value->event != JSON_READER_BOOL) return ESP_ERR_INVALID_ARG;
+                *(bool *)dst = value->boolean;
+                break;
+            case JSON_READER_FIELD_INT32:
+                if (value->event != JSON_READER_NUMBER || value->number < INT32_MIN || value->number > INT32_MAX) {
+                    return ESP_ERR_INVALID_ARG;
+                }
+                *(int32_t *)dst = (int32_t)value->number;
+                break;
+            case JSON_READER_FIELD_STRING: {
+                if (value->event != JSON_READER_STRING || f->size == 0) return ESP_ERR_INVALID_ARG;
+                size_t n = value->len < f->size - 1 ? value->len : f->size - 1;
+                memcpy(dst, value->str, n);
+                dst[n] = '\0';
+                break;
+            }
+            }
+            b->seen |= 1u << i;
+            return ESP_OK;
+        }
+    }
+    return b->other ? b->other(value, b->other_ctx) : ESP_OK;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum object/array nesting depth
+#define JSON_STREAM_MAX_DEPTH   16
+
+/**
+ * @brief Output encoding. CBOR (RFC 8949) uses indefinite-length maps and
+ *        arrays so the same call sequence streams without knowing sizes.
+ */
+typedef enum {
+    JSON_STREAM_FMT_JSON = 0,
+    JSON_STREAM_FMT_CBOR,
+} json_stream_format_t;
+
+/**
+ * @brief Sink for a full buffer. Return ESP_OK to keep writing.
+ */
+typedef esp_err_t (*json_stream_flush_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Writer state. Lives on the caller's stack; never allocates.
+ */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;                 // bytes currently in buf
+    size_t total;               // bytes produced so far, including flushed ones
+    json_stream_flush_fn_t flush;
+    void *flush_ctx;
+    uint32_t has_items;         // bit n: container at depth n already has a member
+    uint32_t objects;           // bit n: container at depth n is an object
+    uint8_t depth;
+    bool after_key;
+    json_stream_format_t format;
+    esp_err_t err;              // first error seen, sticky
+} json_stream_t;
+
+/**
+ * @brief Write into a fixed buffer. Output that does not fit makes
+ *        json_stream_finish() return ESP_ERR_INVALID_SIZE.
+ */
+void json_stream_init(json_stream_t *js, char *buf, size_t cap);
+
+/**
+ * @brief Write through @p buf, handing it to @p flush whenever it fills up.
+ */
+void json_stream_init_flush(json_stream_t *js, char *buf, size_t cap,
+                            json_stream_flush_fn_t flush, void *ctx);
+
+/**
+ * @brief Write through @p buf into the chunked response of @p req.
+ *        The caller still terminates the response with a NULL chunk.
+ *
+ * Every flush becomes one chunk; to get segment-sized chunks from a small
+ * @p buf, use json_stream_init_flush() with resp_writer_sink instead.
+ */
+void json_stream_init_httpd(json_stream_t *js, char *buf, size_t cap, httpd_req_t *req);
+
+/**
+ * @brief Switch the encoding. Call right after init, before any value.
+ */
+void json_stream_set_format(json_stream_t *js, json_stream_format_t format);
+
+/**
+ * @brief Pick JSON or CBOR from the request's Accept header, and set the
+ *        matching Content-Type (plus Vary: Accept) on the response.
+ *
+ * @return The format now in use by @p js
+ */
+json_stream_format_t json_stream_negotiate(json_stream_t *js, httpd_req_t *req);
+
+/**
+ * @brief True when the request's Accept header prefers application/cbor.
+ *
+ * See json_stream_pick_format() for how the header is weighed.
+ */
+bool json_stream_accepts_cbor(httpd_req_t *req);
+
+/**
+ * @brief Pick the format for an Accept header value (NULL when absent).
+ *
+ * Each format takes the q-value of its most specific matching media range
+ * (the exact type, then the application wildcard, then the full wildcard);
+ * q=0 refuses it.
+ * CBOR is chosen only when its q-value is above zero and above JSON's.
+ */
+json_stream_format_t json_stream_pick_format(const char *accept);
+
+void json_stream_begin_object(json_stream_t *js);
+void json_stream_end_object(json_stream_t *js);
+void json_stream_begin_array(json_stream_t *js);
+void json_stream_end_array(json_stream_t *js);
+
+/**
+ * @brief Emit an object member name; the next value call supplies its value.
+ *
+ * Inside an object every value must follow a key, and keys are only valid
+ * inside objects; breaking either rule makes json_stream_finish() return
+ * ESP_ERR_INVALID_STATE.
+ */
+void json_stream_key(json_stream_t *js, const char *key);
+
+void json_stream_string(json_stream_t *js, const char *str);
+void json_stream_string_n(json_stream_t *js, const char *str, size_t len);
+void json_stream_int(json_stream_t *js, int64_t value);
+void json_stream_uint(json_stream_t *js, uint64_t value);
+void json_stream_bool(json_stream_t *js, bool value);
+void json_stream_null(json_stream_t *js);
+
+/**
+ * @brief Emit pre-serialized JSON as a value, e.g. a cached sub-document.
+ *        Not available in CBOR mode (ESP_ERR_NOT_SUPPORTED).
+ */
+void json_stream_raw(json_stream_t *js, const char *json, size_t len);
+
+// Object member shorthands
+static inline void json_stream_kv_string(json_stream_t *js, const char *k, const char *v)
+{
+    json_stream_key(js, k);
+    json_stream_string(js, v);
+}
+
+static inline void json_stream_kv_int(json_stream_t *js, const char *k, int64_t v)
+{
+    json_stream_key(js, k);
+    json_stream_int(js, v);
+}
+
+static inline void json_stream_kv_uint(json_stream_t *js, const char *k, uint64_t v)
+{
+    json_stream_key(js, k);
+    json_stream_uint(js, v);
+}
+
+static inline void json_stream_kv_bool(json_stream_t *js, const char *k, bool v)
+{
+    json_stream_key(js, k);
+    json_stream_bool(js, v);
+}
+
+/**
+ * @brief Flush what is left and check for errors.
+ *
+ * In fixed-buffer mode the output is NUL terminated (when it fits) and
+ * its length is json_stream_len(); for CBOR the terminator is not part
+ * of the output.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE on overflow, ESP_ERR_INVALID_STATE
+ *         on unbalanced containers, or the flush callback's error.
+ */
+esp_err_t json_stream_finish(json_stream_t *js);
+
+static inline size_t json_stream_len(const json_stream_t *js)
+{
+    return js->total;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,425 @@
+#include <string.h>
+#include <strings.h>
+#include "sdkconfig.h"
+#include "json_stream.h"
+
+// CBOR major types and simple values used by the writer
+#define CBOR_UINT           0
+#define CBOR_NEGINT         1
+#define CBOR_TEXT           3
+#define CBOR_ARRAY_INDEF    0x9f
+#define CBOR_MAP_INDEF      0xbf
+#define CBOR_BREAK          0xff
+#define CBOR_FALSE          0xf4
+#define CBOR_TRUE           0xf5
+#define CBOR_NULL           0xf6
+
+static esp_err_t httpd_flush(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+void json_stream_init(json_stream_t *js, char *buf, size_t cap)
+{
+    json_stream_init_flush(js, buf, cap, NULL, NULL);
+}
+
+void json_stream_init_flush(json_stream_t *js, char *buf, size_t cap,
+                            json_stream_flush_fn_t flush, void *ctx)
+{
+    memset(js, 0, sizeof(*js));
+    js->buf = buf;
+    js->cap = cap;
+    js->flush = flush;
+    js->flush_ctx = ctx;
+    js->err = (buf == NULL || cap == 0) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+void json_stream_init_httpd(json_stream_t *js, char *buf, size_t cap, httpd_req_t *req)
+{
+    json_stream_init_flush(js, buf, cap, httpd_flush, req);
+}
+
+void json_stream_set_format(json_stream_t *js, json_stream_format_t format)
+{
+    if (js->total != 0 && js->err == ESP_OK) js->err = ESP_ERR_INVALID_STATE;
+    js->format = format;
+}
+
+// Case-insensitive compare of [s, s + len) with NUL-terminated @p lit
+static bool token_eq(const char *s, size_t len, const char *lit)
+{
+    return strlen(lit) == len && strncasecmp(s, lit, len) == 0;
+}
+
+// RFC 9110 qvalue: "0", "0.x" up to 3 digits, "1", "1.0..."; -1 if malformed
+static int parse_qvalue(const char *s, size_t len)
+{
+    if (len == 0 || (s[0] != '0' && s[0] != '1')) return -1;
+    int q = (s[0] - '0') * 1000;
+    if (len == 1) return q;
+    if (s[1] != '.' || len > 5) return -1;
+    int scale = 100;
+    for (size_t i = 2; i < len; i++, scale /= 10) {
+        if (s[i] < '0' || s[i] > '9') return -1;
+        q += (s[i] - '0') * scale;
+    }
+    return q <= 1000 ? q : -1;
+}
+
+static const char *skip_ows(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+json_stream_format_t json_stream_pick_format(const char *accept)
+{
+    if (accept == NULL) return JSON_STREAM_FMT_JSON;
+
+    // Quality of each format from its most specific matching range: exact > type/* > */*
+    int q_json = -1, q_cbor = -1;
+    int spec_json = -1, spec_cbor = -1;
+    const char *p = accept;
+    while (*p != '\0') {
+        const char *end = p + strcspn(p, ",");
+        const char *next = *end ? end + 1 : end;
+
+        // media-range: type "/" subtype, then ";"-separated parameters
+        const char *r = skip_ows(p, end);
+        const char *range_end = r + strcspn(r, ";,");
+        if (range_end > end) range_end = end;
+        while (range_end > r && (range_end[-1] == ' ' || range_end[-1] == '\t')) range_end--;
+        const char *slash = memchr(r, '/', range_end - r);
+
+        int q = 1000;
+        for (const char *param = r + strcspn(r, ";,"); param < end && *param == ';'; ) {
+            const char *name = skip_ows(param + 1, end);
+            const char *param_end = name + strcspn(name, ";,");
+            if (param_end > end) param_end = end;
+            const char *value = skip_ows(name, param_end);
+            if (param_end - value >= 2 && (value[0] == 'q' || value[0] == 'Q') && value[1] == '=') {
+                const char *v = value + 2, *v_end = param_end;
+                while (v_end > v && (v_end[-1] == ' ' || v_end[-1] == '\t')) v_end--;
+                q = parse_qvalue(v, v_end - v);
+            }
+            param = param_end;
+        }
+
+        if (slash && q >= 0) {
+            const char *type = r, *sub = slash + 1;
+            size_t type_len = slash - r, sub_len = range_end - sub;
+            int spec = -1;
+            bool json = false, cbor = false;
+            if (token_eq(type, type_len, "*") && token_eq(sub, sub_len, "*")) {
+                spec = 0;
+                json = cbor = true;
+            } else if (token_eq(type, type_len, "application")) {
+                if (token_eq(sub, sub_len, "*")) {
+                    spec = 1;
+                    json = cbor = true;
+                } else if (token_eq(sub, sub_len, "json")) {
+                    spec = 2;
+                    json = true;
+                } else if (token_eq(sub, sub_len, "cbor")) {
+                    spec = 2;
+                    cbor = true;
+                }
+            }
+            if (json && spec > spec_json) { spec_json = spec; q_json = q; }
+            if (cbor && spec > spec_cbor) { spec_cbor = spec; q_cbor = q; }
+        }
+        p = next;
+    }
+    // JSON unless CBOR is strictly preferred; a client refusing both still gets JSON
+    return q_cbor > 0 && q_cbor > q_json ? JSON_STREAM_FMT_CBOR : JSON_STREAM_FMT_JSON;
+}
+
+bool json_stream_accepts_cbor(httpd_req_t *req)
+{
+    // Request headers as a whole are capped at this size, so the value is never truncated
+    char accept[CONFIG_HTTPD_MAX_REQ_HDR_LEN];
+    if (httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)) != ESP_OK) {
+        return false;
+    }
+    return json_stream_pick_format(accept) == JSON_STREAM_FMT_CBOR;
+}
+
+json_stream_format_t json_stream_negotiate(json_stream_t *js, httpd_req_t *req)
+{
+    json_stream_format_t format = json_stream_accepts_cbor(req) ? JSON_STREAM_FMT_CBOR : JSON_STREAM_FMT_JSON;
+    json_stream_set_format(js, format);
+    httpd_resp_set_type(req, format == JSON_STREAM_FMT_CBOR ? "application/cbor" : "application/json");
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+    return format;
+}
+
+static void drain(json_stream_t *js)
+{
+    if (js->err == ESP_OK && js->len > 0) {
+        js->err = js->flush(js->flush_ctx, js->buf, js->len);
+    }
+    js->len = 0;
+}
+
+static void put(json_stream_t *js, const char *data, size_t n)
+{
+    if (js->err != ESP_OK) return;
+    js->total += n;
+    while (n > 0) {
+        size_t room = js->cap - js->len;
+        if (room == 0) {
+            if (!js->flush) {
+                js->err = ESP_ERR_INVALID_SIZE;
+                return;
+            }
+            drain(js);
+            if (js->err != ESP_OK) return;
+            room = js->cap;
+        }
+        size_t k = n < room ? n : room;
+        memcpy(js->buf + js->len, data, k);
+        js->len += k;
+        data += k;
+        n -= k;
+    }
+}
+
+static inline void put_c(json_stream_t *js, char c)
+{
+    if (js->err == ESP_OK && js->len < js->cap) {
+        js->buf[js->len++] = c;
+        js->total++;
+    } else {
+        put(js, &c, 1);
+    }
+}
+
+static inline void fail(json_stream_t *js, esp_err_t err)
+{
+    if (js->err == ESP_OK) js->err = err;
+}
+
+static inline bool in_object(const json_stream_t *js)
+{
+    return js->depth > 0 && (js->objects & (1u << (js->depth - 1)));
+}
+
+// Separator bookkeeping before an array element or an object key
+static void separate(json_stream_t *js)
+{
+    if (js->depth > 0) {
+        uint32_t bit = 1u << (js->depth - 1);
+        if ((js->has_items & bit) && js->format == JSON_STREAM_FMT_JSON) put_c(js, ',');
+        js->has_items |= bit;
+    }
+}
+
+// Before any value: it either completes a key or is an array element / the top-level value
+static void begin_value(json_stream_t *js)
+{
+    if (js->after_key) {
+        js->after_key = false;
+        return;
+    }
+    if (in_object(js)) {
+        fail(js, ESP_ERR_INVALID_STATE);    // object member without a key
+        return;
+    }
+    separate(js);
+}
+
+// CBOR initial byte(s): major type plus the shortest big-endian argument
+static void put_cbor_head(json_stream_t *js, uint8_t major, uint64_t arg)
+{
+    uint8_t head[9];
+    size_t n;
+    if (arg < 24) {
+        head[0] = (uint8_t)((major << 5) | arg);
+        n = 1;
+    } else {
+        size_t bytes = arg <= 0xff ? 1 : arg <= 0xffff ? 2 : arg <= 0xffffffffu ? 4 : 8;
+        head[0] = (uint8_t)((major << 5) | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27));
+        for (size_t i = 0; i < bytes; i++) {
+            head[bytes - i] = (uint8_t)(arg >> (8 * i));
+        }
+        n = bytes + 1;
+    }
+    put(js, (const char *)head, n);
+}
+
+static void open_container(json_stream_t *js, char c)
+{
+    begin_value(js);
+    if (js->depth >= JSON_STREAM_MAX_DEPTH) {
+        fail(js, ESP_ERR_INVALID_STATE);
+        return;
+    }
+    if (js->format == JSON_STREAM_FMT_CBOR) {
+        c = (char)(c == '{' ? CBOR_MAP_INDEF : CBOR_ARRAY_INDEF);
+    }
+    put_c(js, c);
+    js->depth++;
+    uint32_t bit = 1u << (js->depth - 1);
+    js->has_items &= ~bit;
+    if (c == '{' || c == (char)CBOR_MAP_INDEF) js->objects |= bit;
+    else js->objects &= ~bit;
+}
+
+static void close_container(json_stream_t *js, char c)
+{
+    // Must close what was opened, and not between a key and its value
+    if (js->depth == 0 || js->after_key || in_object(js) != (c == '}')) {
+        fail(js, ESP_ERR_INVALID_STATE);
+        return;
+    }
+    js->depth--;
+    put_c(js, js->format == JSON_STREAM_FMT_CBOR ? (char)CBOR_BREAK : c);
+}
+
+void json_stream_begin_object(json_stream_t *js) { open_container(js, '{'); }
+void json_stream_end_object(json_stream_t *js)   { close_container(js, '}'); }
+void json_stream_begin_array(json_stream_t *js)  { open_container(js, '['); }
+void json_stream_end_array(json_stream_t *js)    { close_container(js, ']'); }
+
+static void put_escaped(json_stream_t *js, const char *s, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run = s;
+
+    // CBOR text strings are length-prefixed and need no escaping
+    if (js->format == JSON_STREAM_FMT_CBOR) {
+        put_cbor_head(js, CBOR_TEXT, len);
+        put(js, s, len);
+        return;
+    }
+
+    put_c(js, '"');
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Copy the clean run in one go, then the escape sequence
+        put(js, run, (s + i) - run);
+        run = s + i + 1;
+        char esc[6] = { '\\', 0 };
+        size_t n = 2;
+        switch (c) {
+            case '"':  esc[1] = '"';  break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b';  break;
+            case '\f': esc[1] = 'f';  break;
+            case '\n': esc[1] = 'n';  break;
+            case '\r': esc[1] = 'r';  break;
+            case '\t': esc[1] = 't';  break;
+            default:
+                esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+                esc[4] = hex[c >> 4]; esc[5] = hex[c & 0xf];
+                n = 6;
+                break;
+        }
+        put(js, esc, n);
+    }
+    put(js, run, (s + len) - run);
+    put_c(js, '"');
+}
+
+void json_stream_key(json_stream_t *js, const char *key)
+{
+    if (!in_object(js) || js->after_key) {
+        fail(js, ESP_ERR_INVALID_STATE);
+        return;
+    }
+    separate(js);
+    put_escaped(js, key, strlen(key));
+    if (js->format == JSON_STREAM_FMT_JSON) put_c(js, ':');
+    js->after_key = true;
+}
+
+void json_stream_string(json_stream_t *js, const char *str)
+{
+    if (str == NULL) {
+        json_stream_null(js);
+        return;
+    }
+    json_stream_string_n(js, str, strlen(str));
+}
+
+void json_stream_string_n(json_stream_t *js, const char *str, size_t len)
+{
+    begin_value(js);
+    put_escaped(js, str, len);
+}
+
+static void put_u64(json_stream_t *js, uint64_t v, bool negative)
+{
+    char tmp[21];
+    size_t i = sizeof(tmp);
+    do {
+        tmp[--i] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (negative) tmp[--i] = '-';
+    put(js, tmp + i, sizeof(tmp) - i);
+}
+
+void json_stream_int(json_stream_t *js, int64_t value)
+{
+    begin_value(js);
+    if (js->format == JSON_STREAM_FMT_CBOR) {
+        // Negative n is encoded as -1 - n
+        if (value < 0) put_cbor_head(js, CBOR_NEGINT, (uint64_t)(-1 - value));
+        else put_cbor_head(js, CBOR_UINT, (uint64_t)value);
+        return;
+    }
+    if (value < 0) {
+        put_u64(js, (uint64_t)0 - (uint64_t)value, true);
+    } else {
+        put_u64(js, (uint64_t)value, false);
+    }
+}
+
+void json_stream_uint(json_stream_t *js, uint64_t value)
+{
+    begin_value(js);
+    if (js->format == JSON_STREAM_FMT_CBOR) put_cbor_head(js, CBOR_UINT, value);
+    else put_u64(js, value, false);
+}
+
+void json_stream_bool(json_stream_t *js, bool value)
+{
+    begin_value(js);
+    if (js->format == JSON_STREAM_FMT_CBOR) put_c(js, (char)(value ? CBOR_TRUE : CBOR_FALSE));
+    else if (value) put(js, "true", 4); else put(js, "false", 5);
+}
+
+void json_stream_null(json_stream_t *js)
+{
+    begin_value(js);
+    if (js->format == JSON_STREAM_FMT_CBOR) put_c(js, (char)CBOR_NULL);
+    else put(js, "null", 4);
+}
+
+void json_stream_raw(json_stream_t *js, const char *json, size_t len)
+{
+    if (js->format == JSON_STREAM_FMT_CBOR) {
+        fail(js, ESP_ERR_NOT_SUPPORTED);
+        return;
+    }
+    begin_value(js);
+    put(js, json, len);
+}
+
+esp_err_t json_stream_finish(json_stream_t *js)
+{
+    if (js->err == ESP_OK && (js->depth != 0 || js->after_key)) {
+        js->err = ESP_ERR_INVALID_STATE;
+    }
+    if (js->flush) {
+        drain(js);
+    } else if (js->err == ESP_OK) {
+        if (js->len < js->cap) js->buf[js->len] = '\0';
+        else js->err = ESP_ERR_INVALID_SIZE;  // no room for the terminator
+    }
+    return js->err;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Records kept in RAM; power of two. 256 * 36 bytes = 9 KiB.
+#ifndef LOG_RING_CAPACITY
+#define LOG_RING_CAPACITY       256
+#endif
+
+#define LOG_RING_MAX_ARGS       4
+
+// Most verbose level compiled in; calls above it generate no code.
+// Set per file (before the #include) or per component with a compile definition.
+#ifndef LOG_RING_LEVEL
+#define LOG_RING_LEVEL          ESP_LOG_INFO
+#endif
+
+/**
+ * @brief Append one record: timestamp, tag and format pointers and up to
+ *        LOG_RING_MAX_ARGS raw 32-bit arguments. Nothing is formatted here.
+ *
+ * Lock-free (one atomic add to claim a slot); when the ring is full the
+ * oldest record is overwritten. Use the LOG_RING_x macros instead.
+ */
+void log_ring_write(esp_log_level_t level, const char *tag, const char *fmt, int nargs, ...);
+
+#define LOG_RING__NARGS(...)    LOG_RING__NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_RING__NARGS_(z, a, b, c, d, e, f, g, h, n, ...) n
+
+#define LOG_RING__WRITE(level, tag, fmt, ...) do {                                          \
+        _Static_assert(LOG_RING__NARGS(__VA_ARGS__) <= LOG_RING_MAX_ARGS, "too many log args"); \
+        if (LOG_RING_LEVEL >= (level)) {                                                     \
+            log_ring_write((level), (tag), (fmt), LOG_RING__NARGS(__VA_ARGS__), ##__VA_ARGS__); \
+        }                                                                                    \
+    } while (0)
+
+/*
+ * Deferred replacements for ESP_LOGx. The format string must be a literal
+ * and every argument must fit in 32 bits (int, unsigned, char, pointer):
+ * no floats, no 64-bit values. %s arguments are read when the record is
+ * formatted, so they must point to strings that never change (literals,
+ * esp_err_to_name()), not to buffers.
+ */
+#define LOG_RING_E(tag, fmt, ...)   LOG_RING__WRITE(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define LOG_RING_W(tag, fmt, ...)   LOG_RING__WRITE(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define LOG_RING_I(tag, fmt, ...)   LOG_RING__WRITE(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define LOG_RING_D(tag, fmt, ...)   LOG_RING__WRITE(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define LOG_RING_V(tag, fmt, ...)   LOG_RING__WRITE(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Register the ring's counters with the metrics registry. Call once
+ *        at startup; log_ring_start_console() does it. Later calls do nothing.
+ *
+ * Writing records never registers anything, so the hot path stays one
+ * atomic add plus the record stores.
+ */
+void log_ring_register_metrics(void);
+
+/**
+ * @brief Start a task that formats new records and writes them to the
+ *        console through esp_log_write() (so esp_log_level_set() still applies).
+ *
+ * Optional: without it records are only available through log_ring_http_handler().
+ */
+esp_err_t log_ring_start_console(UBaseType_t priority, uint32_t interval_ms);
+
+/**
+ * @brief URI handler returning the records still in the ring as text, oldest first.
+ *
+ * "?since=<seq>" returns only records newer than @c seq; the response's
+ * X-Log-Next header holds the value to pass next time.
+ */
+esp_err_t log_ring_http_handler(httpd_req_t *req);
+
+/**
+ * @brief Sequence number the next record will get (records written since boot).
+ */
+uint32_t log_ring_head(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,223 @@
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "metrics.h"
+#include "resp_writer.h"
+#include "log_ring.h"
+
+static const char *TAG = "log_ring";
+
+_Static_assert((LOG_RING_CAPACITY & (LOG_RING_CAPACITY - 1)) == 0, "LOG_RING_CAPACITY must be a power of two");
+
+#define LINE_MAX    160
+
+typedef struct {
+    _Atomic uint32_t seq;       // sequence number + 1 once complete, 0 while being written
+    uint32_t time_ms;
+    const char *tag;
+    const char *fmt;
+    uint16_t level;
+    uint16_t nargs;
+    uint32_t args[LOG_RING_MAX_ARGS];
+} record_t;
+
+static record_t s_ring[LOG_RING_CAPACITY];
+static _Atomic uint32_t s_head = 0;
+
+static metrics_counter_t s_records = METRICS_COUNTER_INIT(
+    "log_records_total", "Records written to the log ring");
+static metrics_counter_t s_console_dropped = METRICS_COUNTER_INIT(
+    "log_console_dropped_total", "Records overwritten before the console task printed them");
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_registered = false;
+
+void log_ring_register_metrics(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    bool first = !s_registered;
+    s_registered = true;
+    portEXIT_CRITICAL(&s_mux);
+    if (first) {
+        metrics_register(&s_records.base);
+        metrics_register(&s_console_dropped.base);
+    }
+}
+
+void log_ring_write(esp_log_level_t level, const char *tag, const char *fmt, int nargs, ...)
+{
+    uint32_t seq = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+    record_t *r = &s_ring[seq & (LOG_RING_CAPACITY - 1)];
+
+    // Seqlock write: readers see 0 (busy) or the final seq, never a torn record
+    atomic_store_explicit(&r->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    r->time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    r->tag = tag;
+    r->fmt = fmt;
+    r->level = level;
+    r->nargs = nargs;
+
+    va_list ap;
+    va_start(ap, nargs);
+    for (int i = 0; i < nargs; i++) r->args[i] = va_arg(ap, uint32_t);
+    va_end(ap);
+
+    atomic_store_explicit(&r->seq, seq + 1, memory_order_release);
+    metrics_counter_inc(&s_records);
+}
+
+uint32_t log_ring_head(void)
+{
+    return atomic_load_explicit(&s_head, memory_order_relaxed);
+}
+
+typedef enum { READ_OK, READ_PENDING, READ_LOST } read_result_t;
+
+// Copy record @p seq out of the ring
+static read_result_t read_record(uint32_t seq, record_t *out)
+{
+    const record_t *r = &s_ring[seq & (LOG_RING_CAPACITY - 1)];
+    uint32_t before = atomic_load_explicit(&r->seq, memory_order_acquire);
+    if (before == 0 || (int32_t)(before - (seq + 1)) < 0) return READ_PENDING;
+    if (before != seq + 1) return READ_LOST;
+
+    out->time_ms = r->time_ms;
+    out->tag = r->tag;
+    out->fmt = r->fmt;
+    out->level = r->level;
+    out->nargs = r->nargs;
+    memcpy(out->args, r->args, sizeof(out->args));
+
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t after = atomic_load_explicit(&r->seq, memory_order_relaxed);
+    return after == before ? READ_OK : READ_LOST;
+}
+
+static char level_letter(esp_log_level_t level)
+{
+    switch (level) {
+    case ESP_LOG_ERROR:   return 'E';
+    case ESP_LOG_WARN:    return 'W';
+    case ESP_LOG_INFO:    return 'I';
+    case ESP_LOG_DEBUG:   return 'D';
+    default:              return 'V';
+    }
+}
+
+// Message part of @p r. Every argument is a 32-bit word, so passing all of
+// them is valid whatever the format consumes.
+static void format_message(const record_t *r, char *buf, size_t len)
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+    snprintf(buf, len, r->fmt, r->args[0], r->args[1], r->args[2], r->args[3]);
+#pragma GCC diagnostic pop
+}
+
+// Oldest sequence number still in the ring, at or after @p from
+static uint32_t oldest_from(uint32_t from, uint32_t head, uint32_t *skipped)
+{
+    if ((int32_t)(head - from) < 0) from = head;    // from is in the future
+    uint32_t n = head - from;
+    *skipped = n > LOG_RING_CAPACITY ? n - LOG_RING_CAPACITY : 0;
+    return from + *skipped;
+}
+
+// --- Console output ---
+
+typedef struct {
+    uint32_t interval_ms;
+} console_args_t;
+
+static void console_task(void *arg)
+{
+    console_args_t *args = arg;
+    TickType_t interval = pdMS_TO_TICKS(args->interval_ms);
+    uint32_t next = 0;
+    record_t rec;
+    char msg[LINE_MAX];
+
+    free(args);
+    for (;;) {
+        vTaskDelay(interval);
+
+        uint32_t skipped;
+        uint32_t head = log_ring_head();
+        next = oldest_from(next, head, &skipped);
+        if (skipped) metrics_counter_add(&s_console_dropped, skipped);
+
+        for (; next != head; next++) {
+            read_result_t res = read_record(next, &rec);
+            if (res == READ_PENDING) break;     // writer still busy; next round
+            if (res == READ_LOST) {
+                metrics_counter_inc(&s_console_dropped);
+                continue;
+            }
+            format_message(&rec, msg, sizeof(msg));
+            esp_log_write(rec.level, rec.tag, "%c (%lu) %s: %s\n", level_letter(rec.level),
+                          (unsigned long)rec.time_ms, rec.tag, msg);
+        }
+    }
+}
+
+esp_err_t log_ring_start_console(UBaseType_t priority, uint32_t interval_ms)
+{
+    log_ring_register_metrics();
+
+    console_args_t *args = malloc(sizeof(*args));
+    if (!args) return ESP_ERR_NO_MEM;
+    args->interval_ms = interval_ms > 0 ? interval_ms : 1;
+    if (xTaskCreate(console_task, "log_ring", 3072, args, priority, NULL) != pdPASS) {
+        free(args);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// --- /logs ---
+
+esp_err_t log_ring_http_handler(httpd_req_t *req)
+{
+    uint32_t since = 0;
+    char query[32], value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+        since = strtoul(value, NULL, 10);
+    }
+
+    uint32_t skipped;
+    uint32_t head = log_ring_head();
+    uint32_t seq = oldest_from(since, head, &skipped);
+
+    char next_hdr[12];
+    snprintf(next_hdr, sizeof(next_hdr), "%lu", (unsigned long)head);
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_hdr(req, "X-Log-Next", next_hdr);
+
+    resp_writer_t w;
+    resp_writer_init(&w, req);
+    record_t rec;
+    char msg[LINE_MAX], line[LINE_MAX + 48];
+
+    if (skipped) {
+        int n = snprintf(line, sizeof(line), "-- %lu records overwritten --\n", (unsigned long)skipped);
+        resp_writer_write(&w, line, n);
+    }
+    for (; seq != head && w.err == ESP_OK; seq++) {
+        if (read_record(seq, &rec) != READ_OK) continue;
+        format_message(&rec, msg, sizeof(msg));
+        int n = snprintf(line, sizeof(line), "%c (%lu) %s: %s\n", level_letter(rec.level),
+                         (unsigned long)rec.time_ms, rec.tag, msg);
+        resp_writer_write(&w, line, n < (int)sizeof(line) ? n : (int)sizeof(line) - 1);
+    }
+    esp_err_t err = resp_writer_finish(&w);
+    if (err != ESP_OK) ESP_LOGW(TAG, "/logs aborted: %s", esp_err_to_name(err));
+    return err;
+}
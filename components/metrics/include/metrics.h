@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default latency buckets (upper bounds in microseconds) for HTTP handlers
+#define METRICS_HTTP_BUCKETS_US { 1000, 5000, 10000, 25000, 50000, 100000, \
+                                  250000, 500000, 1000000, 2500000, 5000000, 10000000 }
+#define METRICS_MAX_BUCKETS     16
+
+typedef enum {
+    METRICS_TYPE_COUNTER,
+    METRICS_TYPE_GAUGE,
+    METRICS_TYPE_HISTOGRAM,
+} metrics_type_t;
+
+/**
+ * @brief Common header of every metric; linked into the registry.
+ *
+ * Several metrics may share a name if their label sets differ
+ * (e.g. one latency histogram per route); they are exported together.
+ */
+typedef struct metrics_base {
+    struct metrics_base *next;
+    const char *name;
+    const char *help;
+    const char *labels;     // e.g. "route=\"/data\"", or NULL
+    metrics_type_t type;
+} metrics_base_t;
+
+/**
+ * @brief Monotonic counter. Increment is one atomic add, safe from ISRs.
+ */
+typedef struct {
+    metrics_base_t base;
+    _Atomic uint32_t value;
+} metrics_counter_t;
+
+/**
+ * @brief Gauge, either set explicitly or read through @p read at scrape time.
+ */
+typedef struct {
+    metrics_base_t base;
+    _Atomic int32_t value;
+    int64_t (*read)(void);
+} metrics_gauge_t;
+
+/**
+ * @brief Fixed-bucket histogram of microsecond values, exported in seconds.
+ *
+ * The sum is kept in 32 bits and wraps after ~71 minutes of cumulated
+ * observations; Prometheus' rate() treats that like a counter reset.
+ */
+typedef struct {
+    metrics_base_t base;
+    const uint32_t *bounds_us;  // ascending upper bounds, +Inf implied
+    size_t num_bounds;
+    _Atomic uint32_t buckets[METRICS_MAX_BUCKETS + 1];  // non-cumulative
+    _Atomic uint32_t sum_us;
+} metrics_histogram_t;
+
+#define METRICS_COUNTER_INIT(name_, help_) \
+    { .base = { .name = (name_), .help = (help_), .type = METRICS_TYPE_COUNTER } }
+
+#define METRICS_GAUGE_INIT(name_, help_, read_fn_) \
+    { .base = { .name = (name_), .help = (help_), .type = METRICS_TYPE_GAUGE }, .read = (read_fn_) }
+
+/**
+ * @brief Add a metric to the registry exported by metrics_prometheus_handler().
+ *        Metrics must outlive the registry (static storage).
+ */
+void metrics_register(metrics_base_t *metric);
+
+/**
+ * @brief Initialize @p h with @p num_bounds buckets and register it.
+ */
+esp_err_t metrics_histogram_init(metrics_histogram_t *h, const char *name, const char *help,
+                                 const char *labels, const uint32_t *bounds_us, size_t num_bounds);
+
+/**
+ * @brief Register the built-in heap gauges (free, minimum free, largest free block).
+ */
+void metrics_register_system(void);
+
+// Forced inline so IRAM ISRs (e.g. the ADC callback) never call into flash
+__attribute__((always_inline))
+static inline void metrics_counter_add(metrics_counter_t *c, uint32_t n)
+{
+    atomic_fetch_add_explicit(&c->value, n, memory_order_relaxed);
+}
+
+__attribute__((always_inline))
+static inline void metrics_counter_inc(metrics_counter_t *c)
+{
+    atomic_fetch_add_explicit(&c->value, 1, memory_order_relaxed);
+}
+
+__attribute__((always_inline))
+static inline void metrics_gauge_set(metrics_gauge_t *g, int32_t v)
+{
+    atomic_store_explicit(&g->value, v, memory_order_relaxed);
+}
+
+void metrics_histogram_observe(metrics_histogram_t *h, uint32_t value_us);
+
+/**
+ * @brief URI handler exporting every registered metric in Prometheus text format.
+ */
+esp_err_t metrics_prometheus_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,196 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "metrics.h"
+
+static metrics_base_t *s_head = NULL;
+static metrics_base_t *s_tail = NULL;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void metrics_register(metrics_base_t *metric)
+{
+    metric->next = NULL;
+    portENTER_CRITICAL(&s_mux);
+    // Scrapes walk the list unlocked; the node is complete before it is linked
+    if (s_tail) s_tail->next = metric; else s_head = metric;
+    s_tail = metric;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+esp_err_t metrics_histogram_init(metrics_histogram_t *h, const char *name, const char *help,
+                                 const char *labels, const uint32_t *bounds_us, size_t num_bounds)
+{
+    if (num_bounds == 0 || num_bounds > METRICS_MAX_BUCKETS) return ESP_ERR_INVALID_ARG;
+    memset(h, 0, sizeof(*h));
+    h->base.name = name;
+    h->base.help = help;
+    h->base.labels = labels;
+    h->base.type = METRICS_TYPE_HISTOGRAM;
+    h->bounds_us = bounds_us;
+    h->num_bounds = num_bounds;
+    metrics_register(&h->base);
+    return ESP_OK;
+}
+
+void metrics_histogram_observe(metrics_histogram_t *h, uint32_t value_us)
+{
+    size_t i = 0;
+    while (i < h->num_bounds && value_us > h->bounds_us[i]) i++;
+    atomic_fetch_add_explicit(&h->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_us, value_us, memory_order_relaxed);
+}
+
+static int64_t read_heap_free(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static int64_t read_heap_min_free(void)
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+
+static int64_t read_heap_largest_block(void)
+{
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+void metrics_register_system(void)
+{
+    static metrics_gauge_t heap_free = METRICS_GAUGE_INIT(
+        "heap_free_bytes", "Free 8-bit capable heap", read_heap_free);
+    static metrics_gauge_t heap_min_free = METRICS_GAUGE_INIT(
+        "heap_min_free_bytes", "Lowest free heap since boot", read_heap_min_free);
+    static metrics_gauge_t heap_largest = METRICS_GAUGE_INIT(
+        "heap_largest_free_block_bytes", "Largest allocatable block (fragmentation)", read_heap_largest_block);
+
+    metrics_register(&heap_free.base);
+    metrics_register(&heap_min_free.base);
+    metrics_register(&heap_largest.base);
+}
+
+// --- Prometheus text exposition ---
+
+typedef struct {
+    httpd_req_t *req;
+    char buf[512];
+    size_t len;
+    esp_err_t err;
+} writer_t;
+
+static void w_flush(writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) {
+        w->err = httpd_resp_send_chunk(w->req, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void w_printf(writer_t *w, const char *fmt, ...)
+{
+    for (int attempt = 0; attempt < 2 && w->err == ESP_OK; attempt++) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(w->buf + w->len, sizeof(w->buf) - w->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            w->err = ESP_FAIL;
+            return;
+        }
+        if ((size_t)n < sizeof(w->buf) - w->len) {
+            w->len += n;
+            return;
+        }
+        // Did not fit: send what we have and retry on an empty buffer
+        if (w->len == 0) {
+            w->err = ESP_ERR_INVALID_SIZE;
+            return;
+        }
+        w_flush(w);
+    }
+}
+
+// Microseconds as decimal seconds without going through float formatting
+static const char *us_to_seconds(uint32_t us, char *out, size_t len)
+{
+    snprintf(out, len, "%u.%06u", (unsigned)(us / 1000000), (unsigned)(us % 1000000));
+    char *end = out + strlen(out) - 1;
+    while (*end == '0') *end-- = '\0';
+    if (*end == '.') *end = '\0';
+    return out;
+}
+
+static const char *type_name(metrics_type_t type)
+{
+    switch (type) {
+        case METRICS_TYPE_COUNTER: return "counter";
+        case METRICS_TYPE_GAUGE: return "gauge";
+        default: return "histogram";
+    }
+}
+
+static void write_sample(writer_t *w, const metrics_base_t *m)
+{
+    const char *labels = m->labels;
+    const char *open = labels ? "{" : "";
+    const char *close = labels ? "}" : "";
+    if (!labels) labels = "";
+
+    switch (m->type) {
+        case METRICS_TYPE_COUNTER: {
+            const metrics_counter_t *c = (const metrics_counter_t *)m;
+            w_printf(w, "%s%s%s%s %u\n", m->name, open, labels, close,
+                     (unsigned)atomic_load_explicit(&c->value, memory_order_relaxed));
+            break;
+        }
+        case METRICS_TYPE_GAUGE: {
+            const metrics_gauge_t *g = (const metrics_gauge_t *)m;
+            int64_t v = g->read ? g->read() : atomic_load_explicit(&g->value, memory_order_relaxed);
+            w_printf(w, "%s%s%s%s %lld\n", m->name, open, labels, close, (long long)v);
+            break;
+        }
+        case METRICS_TYPE_HISTOGRAM: {
+            metrics_histogram_t *h = (metrics_histogram_t *)m;
+            const char *sep = m->labels ? "," : "";
+            char le[16];
+            uint32_t cumulative = 0;
+            for (size_t i = 0; i < h->num_bounds; i++) {
+                cumulative += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+                w_printf(w, "%s_bucket{%s%sle=\"%s\"} %u\n", m->name, labels, sep,
+                         us_to_seconds(h->bounds_us[i], le, sizeof(le)), (unsigned)cumulative);
+            }
+            cumulative += atomic_load_explicit(&h->buckets[h->num_bounds], memory_order_relaxed);
+            w_printf(w, "%s_bucket{%s%sle=\"+Inf\"} %u\n", m->name, labels, sep, (unsigned)cumulative);
+            w_printf(w, "%s_sum%s%s%s %s\n", m->name, open, labels, close,
+                     us_to_seconds(atomic_load_explicit(&h->sum_us, memory_order_relaxed), le, sizeof(le)));
+            // No separate count: the bucket total is consistent with what was just printed
+            w_printf(w, "%s_count%s%s%s %u\n", m->name, open, labels, close, (unsigned)cumulative);
+            break;
+        }
+    }
+}
+
+esp_err_t metrics_prometheus_handler(httpd_req_t *req)
+{
+    writer_t w = { .req = req, .len = 0, .err = ESP_OK };
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    for (metrics_base_t *m = s_head; m; m = m->next) {
+        // Metrics sharing a name were already written with the first of them
+        bool seen = false;
+        for (metrics_base_t *p = s_head; p != m; p = p->next) {
+            if (strcmp(p->name, m->name) == 0) { seen = true; break; }
+        }
+        if (seen) continue;
+
+        w_printf(&w, "# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, type_name(m->type));
+        for (metrics_base_t *same = m; same; same = same->next) {
+            if (same == m || strcmp(same->name, m->name) == 0) write_sample(&w, same);
+        }
+    }
+    w_flush(&w);
+    if (w.err != ESP_OK) return ESP_FAIL;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
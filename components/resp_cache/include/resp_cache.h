@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Serialize the resource into @p buf.
+ *
+ * @param[out] len Bytes written on success
+ * @return ESP_OK, or an error to keep serving nothing (the next request retries)
+ */
+typedef esp_err_t (*resp_cache_render_fn_t)(char *buf, size_t cap, size_t *len, void *ctx);
+
+/** One rendered response body; refcounted so a refresh never pulls it from under a send. */
+typedef struct resp_cache_body resp_cache_body_t;
+
+/**
+ * @brief A pre-rendered response for a rarely-changing API resource.
+ *
+ * The body is rendered once and served as-is with a strong ETag until the
+ * owner calls resp_cache_refresh() after changing the underlying data.
+ * Requests carrying a matching If-None-Match get 304 Not Modified.
+ */
+typedef struct {
+    const char *content_type;
+    size_t max_len;
+    resp_cache_render_fn_t render;
+    void *ctx;
+    resp_cache_body_t *body;    // NULL until rendered or after a failed render
+    portMUX_TYPE mux;
+    char labels[48];
+    metrics_counter_t served;
+    metrics_counter_t not_modified;
+    metrics_counter_t renders;
+} resp_cache_t;
+
+/**
+ * @brief Set up @p cache and render it for the first time.
+ *
+ * @param name    Label for the exported counters, e.g. the URI
+ * @param max_len Largest body @p render may produce
+ */
+esp_err_t resp_cache_init(resp_cache_t *cache, const char *name, const char *content_type,
+                          size_t max_len, resp_cache_render_fn_t render, void *ctx);
+
+/**
+ * @brief Re-render after the data behind the resource changed.
+ *
+ * Requests already sending the old body finish with it. On failure the
+ * cache is left empty and the next request renders on demand.
+ */
+esp_err_t resp_cache_refresh(resp_cache_t *cache);
+
+/**
+ * @brief Answer @p req from the cache (200 with ETag, or 304).
+ */
+esp_err_t resp_cache_send(resp_cache_t *cache, httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "resp_cache.h"
+
+static const char *TAG = "resp_cache";
+
+struct resp_cache_body {
+    uint32_t refs;
+    size_t len;
+    char etag[12];              // "xxxxxxxx" including the quotes
+    char data[];
+};
+
+// FNV-1a: cheap and good enough to tell two versions of a body apart
+static uint32_t fnv1a(const char *data, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void body_release(resp_cache_t *cache, resp_cache_body_t *body)
+{
+    if (!body) return;
+    portENTER_CRITICAL(&cache->mux);
+    bool last = --body->refs == 0;
+    portEXIT_CRITICAL(&cache->mux);
+    if (last) free(body);
+}
+
+static resp_cache_body_t *body_acquire(resp_cache_t *cache)
+{
+    portENTER_CRITICAL(&cache->mux);
+    resp_cache_body_t *body = cache->body;
+    if (body) body->refs++;
+    portEXIT_CRITICAL(&cache->mux);
+    return body;
+}
+
+// Publish @p body (may be NULL) and drop the cache's reference to the old one
+static void body_swap(resp_cache_t *cache, resp_cache_body_t *body)
+{
+    portENTER_CRITICAL(&cache->mux);
+    resp_cache_body_t *old = cache->body;
+    cache->body = body;
+    portEXIT_CRITICAL(&cache->mux);
+    body_release(cache, old);
+}
+
+esp_err_t resp_cache_refresh(resp_cache_t *cache)
+{
+    resp_cache_body_t *body = malloc(sizeof(*body) + cache->max_len);
+    if (!body) {
+        body_swap(cache, NULL);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t len = 0;
+    esp_err_t err = cache->render(body->data, cache->max_len, &len, cache->ctx);
+    if (err != ESP_OK || len > cache->max_len) {
+        ESP_LOGE(TAG, "Rendering %s failed: %s", cache->labels, esp_err_to_name(err));
+        free(body);
+        body_swap(cache, NULL);
+        return err != ESP_OK ? err : ESP_ERR_INVALID_SIZE;
+    }
+
+    // Give back the unused tail; the body lives until the next refresh
+    resp_cache_body_t *shrunk = realloc(body, sizeof(*body) + len);
+    if (shrunk) body = shrunk;
+    body->refs = 1;
+    body->len = len;
+    snprintf(body->etag, sizeof(body->etag), "\"%08x\"", (unsigned)fnv1a(body->data, len));
+
+    metrics_counter_inc(&cache->renders);
+    body_swap(cache, body);
+    return ESP_OK;
+}
+
+esp_err_t resp_cache_init(resp_cache_t *cache, const char *name, const char *content_type,
+                          size_t max_len, resp_cache_render_fn_t render, void *ctx)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->content_type = content_type;
+    cache->max_len = max_len;
+    cache->render = render;
+    cache->ctx = ctx;
+    cache->mux = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+
+    snprintf(cache->labels, sizeof(cache->labels), "resource=\"%s\"", name);
+    cache->served = (metrics_counter_t)METRICS_COUNTER_INIT(
+        "resp_cache_served_total", "Responses served from a pre-rendered body");
+    cache->not_modified = (metrics_counter_t)METRICS_COUNTER_INIT(
+        "resp_cache_not_modified_total", "Conditional requests answered with 304");
+    cache->renders = (metrics_counter_t)METRICS_COUNTER_INIT(
+        "resp_cache_renders_total", "Times the body was regenerated");
+    cache->served.base.labels = cache->labels;
+    cache->not_modified.base.labels = cache->labels;
+    cache->renders.base.labels = cache->labels;
+    metrics_register(&cache->served.base);
+    metrics_register(&cache->not_modified.base);
+    metrics_register(&cache->renders.base);
+
+    return resp_cache_refresh(cache);
+}
+
+esp_err_t resp_cache_send(resp_cache_t *cache, httpd_req_t *req)
+{
+    resp_cache_body_t *body = body_acquire(cache);
+    if (!body && resp_cache_refresh(cache) == ESP_OK) {
+        body = body_acquire(cache);
+    }
+    if (!body) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Resource unavailable");
+        return ESP_FAIL;
+    }
+
+    // Header values are referenced until the response is sent; the body is held till then
+    esp_err_t err;
+    char if_none_match[64];
+    httpd_resp_set_hdr(req, "ETag", body->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        strstr(if_none_match, body->etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        err = httpd_resp_send(req, NULL, 0);
+        metrics_counter_inc(&cache->not_modified);
+    } else {
+        httpd_resp_set_type(req, cache->content_type);
+        err = httpd_resp_send(req, body->data, body->len);
+        metrics_counter_inc(&cache->served);
+    }
+
+    body_release(cache, body);
+    return err;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Payload per chunk: one TCP segment minus the chunk framing ("5a0\r\n" ... "\r\n")
+#ifdef CONFIG_LWIP_TCP_MSS
+#define RESP_WRITER_CHUNK_SIZE  (CONFIG_LWIP_TCP_MSS - 8)
+#else
+#define RESP_WRITER_CHUNK_SIZE  1432
+#endif
+
+/**
+ * @brief Chunked response writer that coalesces small writes.
+ *
+ * Writes are gathered into segment-sized chunks before they reach
+ * httpd_resp_send_chunk(); writes at least that large go straight
+ * through. The staging buffer comes from buf_pool and is only taken
+ * once a small write actually needs it; when the pool has none free,
+ * writes go out unbuffered rather than from the heap. Lives on the
+ * caller's stack.
+ */
+typedef struct {
+    httpd_req_t *req;
+    char *buf;
+    size_t len;
+    size_t cap;
+    esp_err_t err;              // first error seen, sticky
+} resp_writer_t;
+
+/**
+ * @brief Register the writes/chunks counters with the metrics registry.
+ *        Call once at startup; later calls do nothing.
+ */
+void resp_writer_register_metrics(void);
+
+void resp_writer_init(resp_writer_t *w, httpd_req_t *req);
+
+esp_err_t resp_writer_write(resp_writer_t *w, const void *data, size_t len);
+
+static inline esp_err_t resp_writer_write_str(resp_writer_t *w, const char *str)
+{
+    return resp_writer_write(w, str, strlen(str));
+}
+
+/**
+ * @brief json_stream_flush_fn_t compatible sink; @p ctx is the writer.
+ */
+esp_err_t resp_writer_sink(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Send what is buffered as a chunk now.
+ */
+esp_err_t resp_writer_flush(resp_writer_t *w);
+
+/**
+ * @brief Flush, terminate the chunked response and release the buffer.
+ *
+ * On an earlier error nothing more is sent and that error is returned.
+ * Must be called (or resp_writer_discard()) for every initialised writer.
+ */
+esp_err_t resp_writer_finish(resp_writer_t *w);
+
+/**
+ * @brief Release the buffer without sending anything further.
+ */
+void resp_writer_discard(resp_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
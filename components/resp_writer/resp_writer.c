@@ -0,0 +1,96 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "buf_pool.h"
+#include "metrics.h"
+#include "resp_writer.h"
+
+// Don't hold up a response waiting for a staging buffer; send unbuffered instead
+#define BUF_WAIT_MS     10
+
+// writes / chunks is the coalescing factor
+static metrics_counter_t s_writes = METRICS_COUNTER_INIT(
+    "http_resp_writes_total", "Pieces handed to resp_writer");
+static metrics_counter_t s_chunks = METRICS_COUNTER_INIT(
+    "http_resp_chunks_total", "Chunks resp_writer passed to httpd");
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_registered = false;
+
+void resp_writer_register_metrics(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    bool first = !s_registered;
+    s_registered = true;
+    portEXIT_CRITICAL(&s_mux);
+    if (first) {
+        metrics_register(&s_writes.base);
+        metrics_register(&s_chunks.base);
+    }
+}
+
+void resp_writer_init(resp_writer_t *w, httpd_req_t *req)
+{
+    memset(w, 0, sizeof(*w));
+    w->req = req;
+}
+
+static esp_err_t send_chunk(resp_writer_t *w, const char *data, size_t len)
+{
+    w->err = httpd_resp_send_chunk(w->req, data, len);
+    metrics_counter_inc(&s_chunks);
+    return w->err;
+}
+
+esp_err_t resp_writer_flush(resp_writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) send_chunk(w, w->buf, w->len);
+    w->len = 0;
+    return w->err;
+}
+
+esp_err_t resp_writer_write(resp_writer_t *w, const void *data, size_t len)
+{
+    const char *p = data;
+    metrics_counter_inc(&s_writes);
+
+    while (w->err == ESP_OK && len > 0) {
+        // Big enough for a segment on its own and nothing queued before it
+        if (w->len == 0 && len >= RESP_WRITER_CHUNK_SIZE) {
+            return send_chunk(w, p, len);
+        }
+        if (!w->buf) {
+            w->buf = buf_pool_try_get(pdMS_TO_TICKS(BUF_WAIT_MS));
+            if (!w->buf) return send_chunk(w, p, len);
+            size_t pool_size = buf_pool_buf_size();
+            w->cap = pool_size < RESP_WRITER_CHUNK_SIZE ? pool_size : RESP_WRITER_CHUNK_SIZE;
+        }
+
+        size_t room = w->cap - w->len;
+        size_t k = len < room ? len : room;
+        memcpy(w->buf + w->len, p, k);
+        w->len += k;
+        p += k;
+        len -= k;
+        if (w->len == w->cap) resp_writer_flush(w);
+    }
+    return w->err;
+}
+
+esp_err_t resp_writer_sink(void *ctx, const char *data, size_t len)
+{
+    return resp_writer_write((resp_writer_t *)ctx, data, len);
+}
+
+void resp_writer_discard(resp_writer_t *w)
+{
+    buf_pool_put(w->buf);
+    w->buf = NULL;
+    w->len = 0;
+}
+
+esp_err_t resp_writer_finish(resp_writer_t *w)
+{
+    resp_writer_flush(w);
+    if (w->err == ESP_OK) w->err = httpd_resp_send_chunk(w->req, NULL, 0);
+    resp_writer_discard(w);
+    return w->err;
+}
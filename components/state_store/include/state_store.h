@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Versioned snapshot of a small struct, shared between tasks (seqlock).
+ *
+ * Writers replace the whole value; readers copy it out and retry if a
+ * write overlapped, so they never see a torn value and never hold up a
+ * writer. Writers are serialized by a spinlock held only for the copy-in;
+ * with interrupts masked on that core meanwhile, a reader on the same
+ * core can never observe a write in progress.
+ *
+ * Meant for values of a few hundred bytes at most, read and written
+ * from tasks (not ISRs).
+ */
+typedef struct {
+    _Atomic uint32_t seq;       // odd while a write is in progress
+    portMUX_TYPE writer;
+    size_t size;
+    void *data;
+} state_store_t;
+
+/**
+ * @brief Initialize @p store over @p storage, which holds the initial value
+ *        and must outlive the store. Not thread-safe: call before sharing.
+ */
+void state_store_init(state_store_t *store, void *storage, size_t size);
+
+/**
+ * @brief Replace the value with @p size bytes from @p value.
+ */
+void state_store_write(state_store_t *store, const void *value);
+
+/**
+ * @brief Copy a consistent snapshot into @p out.
+ *
+ * @return Version of the snapshot; it changes with every write
+ */
+uint32_t state_store_read(state_store_t *store, void *out);
+
+/**
+ * @brief Current version, to check for changes without copying.
+ */
+static inline uint32_t state_store_version(state_store_t *store)
+{
+    return atomic_load_explicit(&store->seq, memory_order_acquire) & ~1u;
+}
+
+#ifdef __cplusplus
+}
+#endif
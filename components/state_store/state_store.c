@@ -0,0 +1,34 @@
+#include <string.h>
+#include "state_store.h"
+
+void state_store_init(state_store_t *store, void *storage, size_t size)
+{
+    atomic_init(&store->seq, 0);
+    store->writer = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    store->size = size;
+    store->data = storage;
+}
+
+void state_store_write(state_store_t *store, const void *value)
+{
+    portENTER_CRITICAL(&store->writer);
+    uint32_t seq = atomic_load_explicit(&store->seq, memory_order_relaxed);
+    atomic_store_explicit(&store->seq, seq + 1, memory_order_relaxed);
+    // The odd sequence must be visible before any byte of the new value
+    atomic_thread_fence(memory_order_release);
+    memcpy(store->data, value, store->size);
+    atomic_store_explicit(&store->seq, seq + 2, memory_order_release);
+    portEXIT_CRITICAL(&store->writer);
+}
+
+uint32_t state_store_read(state_store_t *store, void *out)
+{
+    for (;;) {
+        uint32_t before = atomic_load_explicit(&store->seq, memory_order_acquire);
+        if (before & 1) continue;   // write in progress on the other core; it is a short memcpy
+        memcpy(out, store->data, store->size);
+        // The copy must complete before the sequence is checked again
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&store->seq, memory_order_relaxed) == before) return before;
+    }
+}
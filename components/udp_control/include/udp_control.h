@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame layout, all fields little-endian:
+ *
+ *   0  u16 magic      UDP_CONTROL_MAGIC
+ *   2  u8  version    UDP_CONTROL_VERSION
+ *   3  u8  type       UDP_CONTROL_DATA / ACK / CHALLENGE / CONFIRM
+ *   4  u32 session    random per sender instance, echoed in acks
+ *   8  u32 seq        DATA: sequence number (from 1)
+ *                     ACK:  every seq <= this one was received
+ *                     CHALLENGE / CONFIRM: nonce chosen by the receiver
+ *  12  ...            DATA: payload (rest of the datagram)
+ *                     ACK:  u32 bitmap, bit n = seq + 1 + n was received too
+ *
+ * Session ids are random, so the receiver cannot tell a new sender from a
+ * frame of an old session that was delayed in the network. It only switches
+ * sessions after a handshake: a DATA frame from an unknown session gets a
+ * CHALLENGE instead of an ack, and the sender answers with a CONFIRM
+ * carrying the same session and nonce, then sends its frames again. A stale
+ * frame's challenge goes to a sender that no longer uses that session, so
+ * it is never confirmed and the frame never reaches the handler.
+ */
+#define UDP_CONTROL_MAGIC           0x4355      // "UC"
+#define UDP_CONTROL_VERSION         2
+#define UDP_CONTROL_HDR_SIZE        12
+#define UDP_CONTROL_ACK_SIZE        16
+#define UDP_CONTROL_MAX_PAYLOAD     128
+#define UDP_CONTROL_SACK_BITS       32
+#define UDP_CONTROL_MAX_WINDOW      16
+#define UDP_CONTROL_DEFAULT_PORT    3333
+
+typedef enum {
+    UDP_CONTROL_DATA = 1,
+    UDP_CONTROL_ACK = 2,
+    UDP_CONTROL_CHALLENGE = 3,
+    UDP_CONTROL_CONFIRM = 4,
+} udp_control_type_t;
+
+// --- Sender ---
+
+typedef struct {
+    const char *host;           // receiver address
+    uint16_t port;
+    size_t window;              // unacked frames kept for retransmission, <= UDP_CONTROL_MAX_WINDOW
+    uint32_t rto_min_ms;        // retransmit timeout bounds; doubles per retry
+    uint32_t rto_max_ms;
+    uint8_t max_retries;        // then the frame is given up on
+} udp_control_sender_config_t;
+
+#define UDP_CONTROL_SENDER_DEFAULT_CONFIG() {       \
+    .host = "192.168.4.2",                          \
+    .port = UDP_CONTROL_DEFAULT_PORT,               \
+    .window = 8,                                    \
+    .rto_min_ms = 20,                               \
+    .rto_max_ms = 2000,                             \
+    .max_retries = 6,                               \
+}
+
+typedef struct {
+    uint32_t sent;              // frames, first transmissions only
+    uint32_t retransmits;
+    uint32_t acked;
+    uint32_t expired;           // gave up after max_retries
+    uint32_t superseded;        // dropped for a newer frame (window full or too far behind)
+    uint32_t in_flight;
+    uint32_t srtt_us;           // smoothed round trip (frames acked on first try)
+    uint64_t rtt_total_us;      // first send to ack, over acked
+    uint32_t rtt_max_us;
+    uint32_t rtt_last_us;
+} udp_control_sender_stats_t;
+
+typedef struct udp_control_sender udp_control_sender_t;
+
+esp_err_t udp_control_sender_open(const udp_control_sender_config_t *config, udp_control_sender_t **out);
+
+/**
+ * @brief Send one payload as the next sequence number.
+ *
+ * Never blocks. When the window is full, or the oldest unacked frame is
+ * UDP_CONTROL_SACK_BITS sequence numbers behind, that frame is dropped:
+ * control payloads carry the full state, so only the newest matters.
+ */
+esp_err_t udp_control_send(udp_control_sender_t *s, const void *payload, size_t len);
+
+/**
+ * @brief Process acks and challenges and retransmit due frames for up to
+ *        @p timeout_ms.
+ *
+ * Returns early once nothing is in flight.
+ */
+esp_err_t udp_control_sender_poll(udp_control_sender_t *s, uint32_t timeout_ms);
+
+void udp_control_sender_get_stats(udp_control_sender_t *s, udp_control_sender_stats_t *stats);
+
+void udp_control_sender_close(udp_control_sender_t *s);
+
+// --- Receiver ---
+
+/**
+ * @brief Called once per new frame. @p latest is false for a frame that
+ *        arrived after a newer one (reordered); state updates should skip it.
+ */
+typedef void (*udp_control_handler_t)(const uint8_t *payload, size_t len, uint32_t seq, bool latest, void *ctx);
+
+typedef struct {
+    uint32_t frames;
+    uint32_t duplicates;        // already seen, acked again
+    uint32_t reordered;         // delivered with latest = false
+    uint32_t malformed;
+    uint32_t acks_sent;
+    uint32_t challenges;        // frames from a session not confirmed yet, answered with a challenge
+    uint32_t sessions;          // sessions switched to after a confirm
+} udp_control_receiver_stats_t;
+
+/**
+ * @brief Start a task that receives frames on @p port, acks them and calls @p handler.
+ *
+ * One receiver per application, tracking one sender session at a time;
+ * a new session id (sender rebooted or reopened) starts over once the
+ * sender has confirmed it (see the handshake above).
+ */
+esp_err_t udp_control_receiver_start(uint16_t port, udp_control_handler_t handler, void *ctx);
+
+void udp_control_receiver_get_stats(udp_control_receiver_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
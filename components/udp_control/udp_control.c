@@ -0,0 +1,394 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "udp_control.h"
+
+static const char *TAG = "udp_control";
+
+#define RECEIVER_STACK      3072
+#define RECEIVER_PRIORITY   6
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_u32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static uint16_t get_u16(const uint8_t *p) { return p[0] | p[1] << 8; }
+static uint32_t get_u32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+static void put_header(uint8_t *p, udp_control_type_t type, uint32_t session, uint32_t seq)
+{
+    put_u16(p, UDP_CONTROL_MAGIC);
+    p[2] = UDP_CONTROL_VERSION;
+    p[3] = type;
+    put_u32(p + 4, session);
+    put_u32(p + 8, seq);
+}
+
+static bool check_header(const uint8_t *p, size_t len, udp_control_type_t type)
+{
+    return len >= UDP_CONTROL_HDR_SIZE && get_u16(p) == UDP_CONTROL_MAGIC &&
+           p[2] == UDP_CONTROL_VERSION && p[3] == type;
+}
+
+// --- Sender ---
+
+typedef struct {
+    bool in_use;
+    uint8_t retries;
+    uint32_t seq;
+    int64_t first_sent_us;
+    int64_t last_sent_us;
+    size_t len;                 // whole frame
+    uint8_t frame[UDP_CONTROL_HDR_SIZE + UDP_CONTROL_MAX_PAYLOAD];
+} pending_t;
+
+struct udp_control_sender {
+    udp_control_sender_config_t cfg;
+    int sock;
+    uint32_t session;
+    uint32_t confirmed_nonce;   // last challenge answered
+    uint32_t next_seq;
+    uint32_t rto_us;
+    pending_t pending[UDP_CONTROL_MAX_WINDOW];
+    udp_control_sender_stats_t stats;
+};
+
+esp_err_t udp_control_sender_open(const udp_control_sender_config_t *config, udp_control_sender_t **out)
+{
+    if (!config || !config->host || !out || config->window == 0 ||
+        config->window > UDP_CONTROL_MAX_WINDOW || config->rto_min_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u", config->port);
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(config->host, port, &hints, &res) != 0 || res == NULL) return ESP_ERR_NOT_FOUND;
+
+    int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    // Connected UDP socket: send() needs no address and only the receiver's acks come back
+    if (sock < 0 || connect(sock, res->ai_addr, res->ai_addrlen) != 0) {
+        if (sock >= 0) close(sock);
+        freeaddrinfo(res);
+        return ESP_FAIL;
+    }
+    freeaddrinfo(res);
+
+    udp_control_sender_t *s = calloc(1, sizeof(*s));
+    if (!s) {
+        close(sock);
+        return ESP_ERR_NO_MEM;
+    }
+    s->cfg = *config;
+    s->sock = sock;
+    do s->session = esp_random(); while (s->session == 0);     // 0: receiver has no session
+    s->next_seq = 1;
+    s->rto_us = config->rto_min_ms * 4000;  // no RTT sample yet
+    if (s->rto_us > config->rto_max_ms * 1000) s->rto_us = config->rto_max_ms * 1000;
+    *out = s;
+    return ESP_OK;
+}
+
+static uint32_t frame_timeout_us(const udp_control_sender_t *s, const pending_t *p)
+{
+    uint64_t t = (uint64_t)s->rto_us << p->retries;
+    uint64_t max = (uint64_t)s->cfg.rto_max_ms * 1000;
+    return t < max ? t : max;
+}
+
+esp_err_t udp_control_send(udp_control_sender_t *s, const void *payload, size_t len)
+{
+    if (len > UDP_CONTROL_MAX_PAYLOAD) return ESP_ERR_INVALID_SIZE;
+
+    // The receiver tracks UDP_CONTROL_SACK_BITS past its cumulative ack and
+    // slides over anything older, so a frame that far behind is given up on
+    for (size_t i = 0; i < s->cfg.window; i++) {
+        pending_t *c = &s->pending[i];
+        if (c->in_use && s->next_seq - c->seq >= UDP_CONTROL_SACK_BITS) {
+            c->in_use = false;
+            s->stats.superseded++;
+        }
+    }
+
+    // Free slot, or the oldest frame in flight
+    pending_t *p = NULL;
+    for (size_t i = 0; i < s->cfg.window; i++) {
+        pending_t *c = &s->pending[i];
+        if (!c->in_use) { p = c; break; }
+        if (!p || (int32_t)(c->seq - p->seq) < 0) p = c;
+    }
+    if (p->in_use) s->stats.superseded++;
+
+    p->in_use = true;
+    p->retries = 0;
+    p->seq = s->next_seq++;
+    p->len = UDP_CONTROL_HDR_SIZE + len;
+    put_header(p->frame, UDP_CONTROL_DATA, s->session, p->seq);
+    memcpy(p->frame + UDP_CONTROL_HDR_SIZE, payload, len);
+    p->first_sent_us = p->last_sent_us = esp_timer_get_time();
+    s->stats.sent++;
+
+    // A lost first transmission is recovered by the retransmit timer
+    if (send(s->sock, p->frame, p->len, 0) < 0) ESP_LOGD(TAG, "send: errno %d", errno);
+    return ESP_OK;
+}
+
+static void handle_ack(udp_control_sender_t *s, const uint8_t *buf, size_t len)
+{
+    if (len < UDP_CONTROL_ACK_SIZE || !check_header(buf, len, UDP_CONTROL_ACK) ||
+        get_u32(buf + 4) != s->session) {
+        return;
+    }
+    uint32_t cum = get_u32(buf + 8);
+    uint32_t sack = get_u32(buf + 12);
+    int64_t now = esp_timer_get_time();
+
+    for (size_t i = 0; i < s->cfg.window; i++) {
+        pending_t *p = &s->pending[i];
+        if (!p->in_use) continue;
+        uint32_t ahead = p->seq - cum - 1;
+        bool acked = (int32_t)(p->seq - cum) <= 0 || (ahead < UDP_CONTROL_SACK_BITS && (sack & (1u << ahead)));
+        if (!acked) continue;
+
+        p->in_use = false;
+        s->stats.acked++;
+        uint32_t rtt = (uint32_t)(now - p->first_sent_us);
+        s->stats.rtt_total_us += rtt;
+        s->stats.rtt_last_us = rtt;
+        if (rtt > s->stats.rtt_max_us) s->stats.rtt_max_us = rtt;
+        // Karn: a retransmitted frame's ack can't tell which copy it answers
+        if (p->retries == 0) {
+            s->stats.srtt_us = s->stats.srtt_us ? (7 * s->stats.srtt_us + rtt) / 8 : rtt;
+            uint32_t rto = 2 * s->stats.srtt_us;
+            uint32_t lo = s->cfg.rto_min_ms * 1000, hi = s->cfg.rto_max_ms * 1000;
+            s->rto_us = rto < lo ? lo : rto > hi ? hi : rto;
+        }
+    }
+}
+
+// The receiver does not know our session yet and dropped our frames
+static void handle_challenge(udp_control_sender_t *s, const uint8_t *buf)
+{
+    if (get_u32(buf + 4) != s->session) return;
+    uint32_t nonce = get_u32(buf + 8);
+    uint8_t confirm[UDP_CONTROL_HDR_SIZE];
+    put_header(confirm, UDP_CONTROL_CONFIRM, s->session, nonce);
+    if (send(s->sock, confirm, sizeof(confirm), 0) < 0) ESP_LOGD(TAG, "confirm: errno %d", errno);
+
+    // Every frame sent before the confirm answers one challenge; resend the window once
+    if (nonce == s->confirmed_nonce) return;
+    s->confirmed_nonce = nonce;
+    for (size_t i = 0; i < s->cfg.window; i++) {
+        if (s->pending[i].in_use) s->pending[i].last_sent_us = 0;  // due now
+    }
+}
+
+// Retransmit due frames; returns microseconds until the next one is due (INT64_MAX if none)
+static int64_t retransmit_due(udp_control_sender_t *s)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t next = INT64_MAX;
+    for (size_t i = 0; i < s->cfg.window; i++) {
+        pending_t *p = &s->pending[i];
+        if (!p->in_use) continue;
+        int64_t due = p->last_sent_us + frame_timeout_us(s, p);
+        if (due <= now) {
+            if (p->retries >= s->cfg.max_retries) {
+                p->in_use = false;
+                s->stats.expired++;
+                continue;
+            }
+            p->retries++;
+            p->last_sent_us = now;
+            s->stats.retransmits++;
+            if (send(s->sock, p->frame, p->len, 0) < 0) ESP_LOGD(TAG, "resend: errno %d", errno);
+            due = now + frame_timeout_us(s, p);
+        }
+        if (due - now < next) next = due - now;
+    }
+    return next;
+}
+
+esp_err_t udp_control_sender_poll(udp_control_sender_t *s, uint32_t timeout_ms)
+{
+    int64_t end = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    uint8_t buf[UDP_CONTROL_ACK_SIZE + 16];
+
+    for (;;) {
+        int64_t next = retransmit_due(s);
+        int64_t now = esp_timer_get_time();
+        if (next == INT64_MAX || now >= end) return ESP_OK;
+
+        int64_t wait = end - now < next ? end - now : next;
+        struct timeval tv = { .tv_sec = wait / 1000000, .tv_usec = wait % 1000000 };
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(s->sock, &rfds);
+        int rc = select(s->sock + 1, &rfds, NULL, NULL, &tv);
+        if (rc < 0 && errno != EINTR) return ESP_FAIL;
+        if (rc <= 0) continue;
+
+        ssize_t n;
+        while ((n = recv(s->sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            if (check_header(buf, n, UDP_CONTROL_CHALLENGE)) handle_challenge(s, buf);
+            else handle_ack(s, buf, n);
+        }
+    }
+}
+
+void udp_control_sender_get_stats(udp_control_sender_t *s, udp_control_sender_stats_t *stats)
+{
+    *stats = s->stats;
+    stats->in_flight = 0;
+    for (size_t i = 0; i < s->cfg.window; i++) stats->in_flight += s->pending[i].in_use;
+}
+
+void udp_control_sender_close(udp_control_sender_t *s)
+{
+    if (!s) return;
+    close(s->sock);
+    free(s);
+}
+
+// --- Receiver ---
+
+typedef struct {
+    int sock;
+    udp_control_handler_t handler;
+    void *ctx;
+    uint32_t session;           // confirmed; 0 until the first sender confirms
+    uint32_t candidate;         // session challenged, not confirmed yet
+    uint32_t nonce;             // sent in the challenge to candidate
+    uint32_t base;              // every seq <= base received
+    uint32_t sack;              // bit n: base + 1 + n received
+    uint32_t latest;            // highest seq delivered
+} receiver_t;
+
+static receiver_t s_rx = { .sock = -1 };
+static udp_control_receiver_stats_t s_rx_stats;
+
+// Record @p seq; false if it was already seen
+static bool rx_mark(receiver_t *r, uint32_t seq)
+{
+    if ((int32_t)(seq - r->base) <= 0) return false;
+    uint32_t ahead = seq - r->base - 1;
+    if (ahead < UDP_CONTROL_SACK_BITS && (r->sack & (1u << ahead))) return false;
+
+    // Too far ahead for the bitmap: the frames skipped over count as lost
+    if (ahead >= UDP_CONTROL_SACK_BITS) {
+        uint32_t shift = ahead - UDP_CONTROL_SACK_BITS + 1;
+        r->sack = shift >= 32 ? 0 : r->sack >> shift;
+        r->base += shift;
+        ahead -= shift;
+    }
+    r->sack |= 1u << ahead;
+    while (r->sack & 1) {
+        r->base++;
+        r->sack >>= 1;
+    }
+    return true;
+}
+
+static void receiver_task(void *arg)
+{
+    receiver_t *r = arg;
+    uint8_t buf[UDP_CONTROL_HDR_SIZE + UDP_CONTROL_MAX_PAYLOAD];
+    uint8_t ack[UDP_CONTROL_ACK_SIZE];
+
+    for (;;) {
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(r->sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (n < 0) {
+            if (errno != EINTR) vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (check_header(buf, n, UDP_CONTROL_CONFIRM)) {
+            if (r->candidate != 0 && get_u32(buf + 4) == r->candidate && get_u32(buf + 8) == r->nonce) {
+                r->session = r->candidate;
+                r->candidate = 0;
+                r->base = r->sack = r->latest = 0;
+                s_rx_stats.sessions++;
+            }
+            continue;
+        }
+        if (!check_header(buf, n, UDP_CONTROL_DATA) || get_u32(buf + 8) == 0) {
+            s_rx_stats.malformed++;
+            continue;
+        }
+
+        uint32_t session = get_u32(buf + 4);
+        uint32_t seq = get_u32(buf + 8);
+        if (session != r->session) {
+            // New sender or a delayed frame of an old session: only a live sender confirms
+            if (session != r->candidate) {
+                r->candidate = session;
+                r->nonce = esp_random() | 1;
+            }
+            put_header(ack, UDP_CONTROL_CHALLENGE, session, r->nonce);
+            if (sendto(r->sock, ack, UDP_CONTROL_HDR_SIZE, 0, (struct sockaddr *)&from, from_len) > 0) {
+                s_rx_stats.challenges++;
+            }
+            continue;
+        }
+
+        if (rx_mark(r, seq)) {
+            s_rx_stats.frames++;
+            bool latest = (int32_t)(seq - r->latest) > 0;
+            if (latest) r->latest = seq; else s_rx_stats.reordered++;
+            r->handler(buf + UDP_CONTROL_HDR_SIZE, n - UDP_CONTROL_HDR_SIZE, seq, latest, r->ctx);
+        } else {
+            s_rx_stats.duplicates++;    // our ack was lost; send it again
+        }
+
+        put_header(ack, UDP_CONTROL_ACK, r->session, r->base);
+        put_u32(ack + UDP_CONTROL_HDR_SIZE, r->sack);
+        if (sendto(r->sock, ack, sizeof(ack), 0, (struct sockaddr *)&from, from_len) == sizeof(ack)) {
+            s_rx_stats.acks_sent++;
+        }
+    }
+}
+
+esp_err_t udp_control_receiver_start(uint16_t port, udp_control_handler_t handler, void *ctx)
+{
+    if (!handler) return ESP_ERR_INVALID_ARG;
+    if (s_rx.sock >= 0) return ESP_ERR_INVALID_STATE;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return ESP_FAIL;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "bind port %u: errno %d", port, errno);
+        close(sock);
+        return ESP_FAIL;
+    }
+
+    s_rx.sock = sock;
+    s_rx.handler = handler;
+    s_rx.ctx = ctx;
+    if (xTaskCreate(receiver_task, "udp_control", RECEIVER_STACK, &s_rx, RECEIVER_PRIORITY, NULL) != pdPASS) {
+        close(sock);
+        s_rx.sock = -1;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Listening on UDP port %u", port);
+    return ESP_OK;
+}
+
+void udp_control_receiver_get_stats(udp_control_receiver_stats_t *stats)
+{
+    *stats = s_rx_stats;
+}
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Generate a uri_router table with a minimal perfect hash from a route file.
+
+    python gen_routes.py <routes.txt> <output.inc> [--prefix NAME]
+
+Route file, one route per line ('#' starts a comment):
+
+    METHOD  PATH               HANDLER                  [inline|offload]
+    GET     /api/status        api_status_get_handler
+    GET     /api/item/{id}     item_get_handler         offload
+
+The output defines `static const uri_router_table_t uri_router_table`
+(`<NAME>_table` with --prefix, so several tables fit one source file);
+include it after the handlers it names are declared.
+"""
+import argparse
+import sys
+
+# http_parser's enum http_method, which httpd_method_t aliases
+METHODS = {'DELETE': 0, 'GET': 1, 'HEAD': 2, 'POST': 3, 'PUT': 4, 'OPTIONS': 6, 'PATCH': 28}
+MODES = {'inline': 'HTTPD_WORKERS_INLINE', 'offload': 'HTTPD_WORKERS_OFFLOAD'}
+EMPTY = 0xffff
+MAX_KEY = 128               # URI_ROUTER_MAX_KEY
+
+
+def route_hash(seed, method, key):
+    """Must match uri_router_hash()."""
+    h = 2166136261 ^ ((seed * 0x9e3779b1) & 0xffffffff)
+    h = ((h ^ (method & 0xff)) * 16777619) & 0xffffffff
+    for b in key.encode():
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    # FNV's low bits only depend on the low bits of the input; mix before '% num_slots'
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xffffffff
+    h ^= h >> 13
+    return h
+
+
+def parse(path):
+    routes = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            fields = line.split('#', 1)[0].split()
+            if not fields:
+                continue
+            where = '%s:%d' % (path, lineno)
+            if len(fields) not in (3, 4):
+                sys.exit('%s: expected METHOD PATH HANDLER [MODE]' % where)
+            method, pattern, handler = fields[:3]
+            mode = fields[3] if len(fields) == 4 else 'inline'
+            if method not in METHODS or mode not in MODES or not pattern.startswith('/'):
+                sys.exit('%s: bad method, mode or path' % where)
+
+            segments = pattern[1:].split('/')
+            mask = 0
+            key = []
+            for i, seg in enumerate(segments):
+                if seg.startswith('{') and seg.endswith('}'):
+                    if i >= 32:
+                        sys.exit('%s: parameter beyond segment 31' % where)
+                    mask |= 1 << i
+                    key.append('*')
+                else:
+                    key.append(seg)
+            key = '/' + '/'.join(key)
+            if len(key) >= MAX_KEY:
+                sys.exit('%s: path too long' % where)
+            if any(r['method'] == method and r['key'] == key and r['mask'] == mask for r in routes):
+                sys.exit('%s: duplicate route' % where)
+            routes.append({'method': method, 'pattern': pattern, 'key': key, 'mask': mask,
+                           'handler': handler, 'mode': mode})
+    if len(routes) >= EMPTY:
+        sys.exit('too many routes')
+    return routes
+
+
+def perfect_hash(routes):
+    """Hash and displace: returns (slots, displacements)."""
+    n = len(routes)
+    num_slots = max(1, n + n // 4)
+    num_buckets = max(1, (n + 3) // 4)
+    keys = [(METHODS[r['method']], r['key']) for r in routes]
+
+    buckets = [[] for _ in range(num_buckets)]
+    for i, (m, k) in enumerate(keys):
+        buckets[route_hash(0, m, k) % num_buckets].append(i)
+
+    slots = [EMPTY] * num_slots
+    disp = [0] * num_buckets
+    for b in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for d in range(1, 0x10000):
+            wanted = [route_hash(d, *keys[i]) % num_slots for i in buckets[b]]
+            if len(set(wanted)) == len(wanted) and all(slots[s] == EMPTY for s in wanted):
+                for i, s in zip(buckets[b], wanted):
+                    slots[s] = i
+                disp[b] = d
+                break
+        else:
+            sys.exit('no displacement found; add slots')
+    return slots, disp
+
+
+def c_str(s):
+    return '"%s"' % s.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def emit(routes, slots, disp, src, prefix):
+    masks = sorted({r['mask'] for r in routes}, key=lambda m: (bin(m).count('1'), m)) or [0]
+    out = ['// Generated by gen_routes.py from %s - do not edit' % src, '']
+    out.append('static const uri_router_route_t %s_routes[] = {' % prefix)
+    for r in routes:
+        out.append('    { HTTP_%s, %s, %s, 0x%x, %s, %s },' % (
+            r['method'], c_str(r['pattern']), c_str(r['key']), r['mask'], r['handler'], MODES[r['mode']]))
+    out.append('};')
+    out.append('')
+    out.append('static const uint16_t %s_slots[] = { %s };' % (prefix, ', '.join('0x%x' % s for s in slots)))
+    out.append('static const uint16_t %s_disp[] = { %s };' % (prefix, ', '.join(str(d) for d in disp)))
+    out.append('static const uint32_t %s_masks[] = { %s };' % (prefix, ', '.join('0x%x' % m for m in masks)))
+    out.append('')
+    out.append('static const uri_router_table_t %s_table = {' % prefix)
+    out.append('    .routes = %s_routes, .num_routes = %d,' % (prefix, len(routes)))
+    out.append('    .slots = %s_slots, .num_slots = %d,' % (prefix, len(slots)))
+    out.append('    .disp = %s_disp, .num_buckets = %d,' % (prefix, len(disp)))
+    out.append('    .masks = %s_masks, .num_masks = %d,' % (prefix, len(masks)))
+    out.append('};')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('routes')
+    parser.add_argument('output')
+    parser.add_argument('--prefix', default='uri_router',
+                        help='identifier prefix of the generated arrays and table')
+    args = parser.parse_args()
+
+    routes = parse(args.routes)
+    if not routes:
+        sys.exit('%s: no routes' % args.routes)
+    slots, disp = perfect_hash(routes)
+    with open(args.output, 'w') as f:
+        f.write(emit(routes, slots, disp, args.routes.replace('\\', '/').split('/')[-1], args.prefix))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "httpd_workers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest normalized lookup key ("/api/item/*"); longer URIs never match
+#define URI_ROUTER_MAX_KEY      128
+
+/**
+ * @brief One route of a generated table. Produced by gen_routes.py.
+ */
+typedef struct {
+    httpd_method_t method;
+    const char *pattern;        // as written in the route file, e.g. "/api/item/{id}"
+    const char *key;            // parameters replaced by '*', e.g. "/api/item/*"
+    uint32_t param_mask;        // bit n: path segment n is a parameter
+    esp_err_t (*handler)(httpd_req_t *req);
+    httpd_workers_mode_t mode;  // OFFLOAD runs the handler on an httpd_workers task
+} uri_router_route_t;
+
+/**
+ * @brief Route table with its minimal perfect hash (hash-and-displace).
+ *
+ * slot = hash(key, disp[hash(key, 0) % num_buckets]) % num_slots, and
+ * slots[slot] is the route index (0xffff when empty), so a lookup costs
+ * one or two hashes and one string compare per parameter shape in
+ * @c masks, however many routes there are.
+ */
+typedef struct {
+    const uri_router_route_t *routes;
+    uint16_t num_routes;
+    const uint16_t *slots;
+    uint16_t num_slots;
+    const uint16_t *disp;
+    uint16_t num_buckets;
+    const uint32_t *masks;      // distinct param_mask values, static routes (0) first
+    uint8_t num_masks;
+} uri_router_table_t;
+
+/**
+ * @brief Serve every route of @p table through one catch-all handler per method.
+ *
+ * The server must be started with uri_match_fn = httpd_uri_match_wildcard,
+ * and httpd_workers_start() called first for offloaded routes. Every route
+ * is an httpd_workers route (httpd_workers_add_route()), so it shows up on
+ * the workers stats handler and in the per-route metrics like a route
+ * registered with httpd_workers_register_uri().
+ */
+esp_err_t uri_router_start(httpd_handle_t server, const uri_router_table_t *table);
+
+/**
+ * @brief Find the route for @p method and @p uri (query string ignored).
+ *
+ * @return route, or NULL if nothing matches
+ */
+const uri_router_route_t *uri_router_lookup(const uri_router_table_t *table,
+                                            httpd_method_t method, const char *uri);
+
+/**
+ * @brief Copy path parameter @p name ("id" for "{id}") of the current request.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the route has no such parameter,
+ *         ESP_ERR_INVALID_SIZE if @p buf is too small
+ */
+esp_err_t uri_router_param(httpd_req_t *req, const char *name, char *buf, size_t len);
+
+/**
+ * @brief Key hash shared with gen_routes.py: FNV-1a over the method and key, then mixed.
+ */
+uint32_t uri_router_hash(uint32_t seed, httpd_method_t method, const char *key, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
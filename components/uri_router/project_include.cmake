@@ -0,0 +1,27 @@
+# uri_router_generate
+#
+# Generate a uri_router table (see gen_routes.py) from routes_file into
+# the component's build directory as <name>.inc, and make it includable
+# from the component's sources. Call after idf_component_register().
+# PREFIX renames the generated table (default uri_router_table) to
+# <PREFIX>_table, for components with more than one.
+set(URI_ROUTER_GEN ${CMAKE_CURRENT_LIST_DIR}/gen_routes.py CACHE INTERNAL "")
+
+function(uri_router_generate routes_file name)
+    cmake_parse_arguments(arg "" "PREFIX" "" "${ARGN}")
+    if(NOT arg_PREFIX)
+        set(arg_PREFIX uri_router)
+    endif()
+    idf_build_get_property(python PYTHON)
+    get_filename_component(routes_full "${routes_file}" ABSOLUTE)
+    set(output ${CMAKE_CURRENT_BINARY_DIR}/${name}.inc)
+
+    add_custom_command(OUTPUT ${output}
+        COMMAND ${python} ${URI_ROUTER_GEN} ${routes_full} ${output} --prefix ${arg_PREFIX}
+        DEPENDS ${routes_full} ${URI_ROUTER_GEN}
+        COMMENT "Generating URI router ${name}.inc from ${routes_file}"
+        VERBATIM)
+    add_custom_target(${COMPONENT_NAME}_${name} DEPENDS ${output})
+    add_dependencies(${COMPONENT_LIB} ${COMPONENT_NAME}_${name})
+    target_include_directories(${COMPONENT_LIB} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+endfunction()
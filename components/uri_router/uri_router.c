@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "uri_router.h"
+
+static const char *TAG = "uri_router";
+
+#define EMPTY_SLOT      0xffff
+#define MAX_METHODS     8
+
+static const uri_router_table_t *s_table = NULL;
+static httpd_workers_route_t **s_routes = NULL;    // httpd_workers side of each table route
+
+uint32_t uri_router_hash(uint32_t seed, httpd_method_t method, const char *key, size_t len)
+{
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b1u);
+    h = (h ^ ((uint32_t)method & 0xff)) * 16777619u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)key[i]) * 16777619u;
+    }
+    // FNV's low bits only depend on the low bits of the input; mix before '% num_slots'
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+}
+
+// Path of @p uri with the segments in @p mask replaced by '*'; -1 if the shape does not fit
+static int normalize(const char *uri, uint32_t mask, char *out, size_t cap)
+{
+    const char *p = uri;
+    size_t n = 0;
+    uint32_t seg = 0;
+
+    if (*p != '/') return -1;
+    while (*p != '\0' && *p != '?' && *p != '#') {
+        const char *start = ++p;    // skip the '/'
+        while (*p != '\0' && *p != '/' && *p != '?' && *p != '#') p++;
+        size_t seg_len = p - start;
+        bool param = seg < 32 && (mask & (1u << seg));
+        if (param && seg_len == 0) return -1;
+
+        size_t need = 1 + (param ? 1 : seg_len);
+        if (n + need >= cap) return -1;
+        out[n++] = '/';
+        if (param) {
+            out[n++] = '*';
+        } else {
+            memcpy(out + n, start, seg_len);
+            n += seg_len;
+        }
+        seg++;
+    }
+    if (seg < 32 && (mask >> seg) != 0) return -1;  // parameter past the end of the path
+    out[n] = '\0';
+    return (int)n;
+}
+
+static int lookup_index(const uri_router_table_t *t, httpd_method_t method, const char *uri)
+{
+    char key[URI_ROUTER_MAX_KEY];
+    if (t->num_routes == 0) return -1;
+
+    for (size_t m = 0; m < t->num_masks; m++) {
+        int len = normalize(uri, t->masks[m], key, sizeof(key));
+        if (len < 0) continue;
+
+        uint32_t h0 = uri_router_hash(0, method, key, len);
+        uint32_t d = t->disp[h0 % t->num_buckets];
+        uint16_t idx = t->slots[uri_router_hash(d, method, key, len) % t->num_slots];
+        if (idx == EMPTY_SLOT) continue;
+
+        const uri_router_route_t *r = &t->routes[idx];
+        if (r->method == method && r->param_mask == t->masks[m] && strcmp(r->key, key) == 0) {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+const uri_router_route_t *uri_router_lookup(const uri_router_table_t *table,
+                                            httpd_method_t method, const char *uri)
+{
+    int idx = lookup_index(table, method, uri);
+    return idx < 0 ? NULL : &table->routes[idx];
+}
+
+static esp_err_t dispatch(httpd_req_t *req)
+{
+    int idx = lookup_index(s_table, req->method, req->uri);
+    if (idx < 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+        return ESP_OK;  // keep the connection
+    }
+    // Inline or offloaded, with the same stats and metrics as httpd_workers_register_uri()
+    return httpd_workers_run(s_routes[idx], req);
+}
+
+esp_err_t uri_router_start(httpd_handle_t server, const uri_router_table_t *table)
+{
+    if (s_table) return ESP_ERR_INVALID_STATE;
+
+    s_routes = calloc(table->num_routes, sizeof(*s_routes));
+    if (!s_routes && table->num_routes > 0) return ESP_ERR_NO_MEM;
+    s_table = table;
+
+    httpd_method_t methods[MAX_METHODS];
+    size_t num_methods = 0;
+    for (size_t i = 0; i < table->num_routes; i++) {
+        const uri_router_route_t *r = &table->routes[i];
+        esp_err_t err = httpd_workers_add_route(r->pattern, r->handler, r->mode, &s_routes[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to add %s: %s", r->pattern, esp_err_to_name(err));
+            return err;
+        }
+
+        size_t m = 0;
+        while (m < num_methods && methods[m] != r->method) m++;
+        if (m == num_methods && num_methods < MAX_METHODS) methods[num_methods++] = r->method;
+    }
+
+    for (size_t m = 0; m < num_methods; m++) {
+        httpd_uri_t uri = { .uri = "/*", .method = methods[m], .handler = dispatch };
+        esp_err_t err = httpd_register_uri_handler(server, &uri);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register catch-all: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+    ESP_LOGI(TAG, "%u routes, %u methods, %u parameter shapes", (unsigned)table->num_routes,
+             (unsigned)num_methods, (unsigned)table->num_masks);
+    return ESP_OK;
+}
+
+esp_err_t uri_router_param(httpd_req_t *req, const char *name, char *buf, size_t len)
+{
+    int idx = s_table ? lookup_index(s_table, req->method, req->uri) : -1;
+    if (idx < 0) return ESP_ERR_NOT_FOUND;
+
+    // Index of the "{name}" segment in the pattern
+    const char *p = s_table->routes[idx].pattern;
+    size_t name_len = strlen(name);
+    int seg = -1, k = 0;
+    while (*p == '/') {
+        const char *start = ++p;
+        while (*p != '\0' && *p != '/') p++;
+        if ((size_t)(p - start) == name_len + 2 && start[0] == '{' &&
+            strncmp(start + 1, name, name_len) == 0) {
+            seg = k;
+            break;
+        }
+        k++;
+    }
+    if (seg < 0) return ESP_ERR_NOT_FOUND;
+
+    // Same segment of the request path
+    const char *u = req->uri;
+    for (k = 0; *u == '/'; k++) {
+        const char *start = ++u;
+        while (*u != '\0' && *u != '/' && *u != '?' && *u != '#') u++;
+        if (k == seg) {
+            size_t n = u - start;
+            if (n >= len) return ESP_ERR_INVALID_SIZE;
+            memcpy(buf, start, n);
+            buf[n] = '\0';
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "file_cache.h"
+
+static const char *TAG = "file_cache";
+
+struct file_cache_entry {
+    struct file_cache_entry *prev;  // towards most recently used
+    struct file_cache_entry *next;  // towards least recently used
+    char *path;
+    uint8_t *data;
+    size_t size;
+    uint32_t refs;
+    bool linked;                    // false once evicted/invalidated
+};
+
+static SemaphoreHandle_t s_lock = NULL;
+static file_cache_entry_t *s_head = NULL;  // most recently used
+static file_cache_entry_t *s_tail = NULL;  // least recently used
+static size_t s_max_entry = 0;
+static file_cache_stats_t s_stats = {0};
+// Bumped by every invalidation; a load that started before one is not inserted
+static uint32_t s_generation = 0;
+
+static void entry_free(file_cache_entry_t *e)
+{
+    free(e->path);
+    free(e->data);
+    free(e);
+}
+
+static void lru_unlink(file_cache_entry_t *e)
+{
+    if (e->prev) e->prev->next = e->next; else s_head = e->next;
+    if (e->next) e->next->prev = e->prev; else s_tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void lru_push_front(file_cache_entry_t *e)
+{
+    e->prev = NULL;
+    e->next = s_head;
+    if (s_head) s_head->prev = e; else s_tail = e;
+    s_head = e;
+}
+
+// Remove from the index; memory goes away now or on the last release
+static void entry_drop(file_cache_entry_t *e)
+{
+    lru_unlink(e);
+    e->linked = false;
+    s_stats.entries--;
+    s_stats.bytes_used -= e->size;
+    if (e->refs == 0) entry_free(e);
+}
+
+static file_cache_entry_t *lookup(const char *path)
+{
+    for (file_cache_entry_t *e = s_head; e; e = e->next) {
+        if (strcmp(e->path, path) == 0) return e;
+    }
+    return NULL;
+}
+
+// Evict least recently used, unreferenced entries until @p need bytes fit
+static bool make_room(size_t need)
+{
+    file_cache_entry_t *e = s_tail;
+    while (e && s_stats.bytes_used + need > s_stats.bytes_budget) {
+        file_cache_entry_t *prev = e->prev;
+        if (e->refs == 0) {
+            ESP_LOGD(TAG, "Evicting %s (%u bytes)", e->path, (unsigned)e->size);
+            entry_drop(e);
+            s_stats.evictions++;
+        }
+        e = prev;
+    }
+    return s_stats.bytes_used + need <= s_stats.bytes_budget;
+}
+
+// Read @p path into a new entry. If it cannot be cached, *fd is left open
+// at offset 0 for the caller to stream from (or -1 if the open failed).
+static file_cache_entry_t *load_file(const char *path, int *fd_out)
+{
+    int fd = open(path, O_RDONLY, 0);
+    *fd_out = fd;
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size > s_max_entry) {
+        return NULL;
+    }
+
+    file_cache_entry_t *e = calloc(1, sizeof(*e));
+    if (e) {
+        e->size = (size_t)st.st_size;
+        e->path = strdup(path);
+        e->data = malloc(e->size ? e->size : 1);
+    }
+    if (!e || !e->path || !e->data) {
+        ESP_LOGW(TAG, "No memory to cache %s", path);
+        if (e) entry_free(e);
+        return NULL;
+    }
+
+    size_t got = 0;
+    while (got < e->size) {
+        ssize_t n = read(fd, e->data + got, e->size - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    if (got != e->size) {
+        ESP_LOGE(TAG, "Short read on %s", path);
+        entry_free(e);
+        // Let the caller retry from the start on the same handle
+        if (lseek(fd, 0, SEEK_SET) == (off_t)-1) {
+            close(fd);
+            *fd_out = -1;
+        }
+        return NULL;
+    }
+    close(fd);
+    *fd_out = -1;
+    return e;
+}
+
+esp_err_t file_cache_init(size_t budget_bytes, size_t max_entry_bytes)
+{
+    if (s_lock) return ESP_ERR_INVALID_STATE;
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) return ESP_ERR_NO_MEM;
+    s_stats.bytes_budget = budget_bytes;
+    s_max_entry = max_entry_bytes < budget_bytes ? max_entry_bytes : budget_bytes;
+    ESP_LOGI(TAG, "File cache: budget %u bytes, max entry %u bytes",
+             (unsigned)budget_bytes, (unsigned)s_max_entry);
+    return ESP_OK;
+}
+
+const file_cache_entry_t *file_cache_acquire(const char *path, int *fd)
+{
+    if (!s_lock) {
+        *fd = open(path, O_RDONLY, 0);
+        return NULL;
+    }
+    *fd = -1;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    file_cache_entry_t *e = lookup(path);
+    if (e) {
+        lru_unlink(e);
+        lru_push_front(e);
+        e->refs++;
+        s_stats.hits++;
+        xSemaphoreGive(s_lock);
+        return e;
+    }
+    s_stats.misses++;
+    uint32_t generation = s_generation;
+    xSemaphoreGive(s_lock);
+
+    // Read outside the lock so a slow flash read does not stall other hits
+    file_cache_entry_t *loaded = load_file(path, fd);
+    if (!loaded) return NULL;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    e = lookup(path);
+    if (e) {
+        // Someone else loaded it meanwhile, after any invalidation we could have missed
+        entry_free(loaded);
+    } else if (generation != s_generation) {
+        // Invalidated while we were reading: this copy may predate the write
+        e = loaded;
+    } else if (make_room(loaded->size)) {
+        e = loaded;
+        e->linked = true;
+        lru_push_front(e);
+        s_stats.entries++;
+        s_stats.bytes_used += e->size;
+    } else {
+        // Everything is pinned; serve this copy once without caching it
+        e = loaded;
+    }
+    e->refs++;
+    xSemaphoreGive(s_lock);
+    return e;
+}
+
+void file_cache_release(const file_cache_entry_t *entry)
+{
+    if (!entry) return;
+    file_cache_entry_t *e = (file_cache_entry_t *)entry;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (--e->refs == 0 && !e->linked) entry_free(e);
+    xSemaphoreGive(s_lock);
+}
+
+const uint8_t *file_cache_data(const file_cache_entry_t *entry)
+{
+    return entry->data;
+}
+
+size_t file_cache_size(const file_cache_entry_t *entry)
+{
+    return entry->size;
+}
+
+void file_cache_invalidate(const char *path)
+{
+    if (!s_lock) return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_generation++;
+    file_cache_entry_t *e = lookup(path);
+    if (e) {
+        entry_drop(e);
+        s_stats.invalidations++;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+void file_cache_invalidate_all(void)
+{
+    if (!s_lock) return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_generation++;
+    while (s_head) {
+        entry_drop(s_head);
+        s_stats.invalidations++;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t file_cache_write_file(const char *path, const void *data, size_t len)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        ESP_LOGE(TAG, "Failed to open %s for writing", path);
+        return ESP_FAIL;
+    }
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, (const uint8_t *)data + done, len - done);
+        if (n <= 0) break;
+        done += n;
+    }
+    int closed = close(fd);
+    // Invalidate even on failure: the file has changed either way
+    file_cache_invalidate(path);
+    if (done != len || closed != 0) {
+        ESP_LOGE(TAG, "Short write on %s", path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void file_cache_get_stats(file_cache_stats_t *stats)
+{
+    if (!s_lock) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
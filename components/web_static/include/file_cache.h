@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A file held in RAM by the cache. Read-only for callers.
+ */
+typedef struct file_cache_entry file_cache_entry_t;
+
+/**
+ * @brief Cache counters, as returned by file_cache_get_stats().
+ */
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t invalidations;
+    uint32_t entries;
+    size_t bytes_used;
+    size_t bytes_budget;
+} file_cache_stats_t;
+
+/**
+ * @brief Create the cache. Until this is called file_cache_acquire() always misses.
+ *
+ * @param budget_bytes    Total RAM the cached file contents may occupy
+ * @param max_entry_bytes Files larger than this are never cached
+ */
+esp_err_t file_cache_init(size_t budget_bytes, size_t max_entry_bytes);
+
+/**
+ * @brief Look up @p path, loading it from the filesystem on a miss.
+ *
+ * The returned entry stays valid until file_cache_release(), even if it is
+ * evicted or invalidated in the meantime.
+ *
+ * @param path Absolute VFS path
+ * @param fd   When NULL is returned: set to a descriptor open on @p path at
+ *             offset 0, which the caller streams from and closes, or -1 if
+ *             the file could not be opened. Set to -1 otherwise.
+ *
+ * @return entry, or NULL if the cache is disabled, the file is missing or
+ *         too large to cache (caller reads the file through @p fd).
+ */
+const file_cache_entry_t *file_cache_acquire(const char *path, int *fd);
+
+/**
+ * @brief Drop a reference obtained from file_cache_acquire().
+ */
+void file_cache_release(const file_cache_entry_t *entry);
+
+const uint8_t *file_cache_data(const file_cache_entry_t *entry);
+size_t file_cache_size(const file_cache_entry_t *entry);
+
+/**
+ * @brief Forget the cached copy of @p path. Call after writing the file.
+ *
+ * A load of @p path that was already reading the old contents is served
+ * once to its own request but not kept.
+ */
+void file_cache_invalidate(const char *path);
+
+/**
+ * @brief Forget every cached file, e.g. after reformatting the partition.
+ */
+void file_cache_invalidate_all(void);
+
+/**
+ * @brief Replace the contents of @p path and invalidate its cached copy.
+ *
+ * Use this for every write to a served filesystem so the cache never
+ * outlives the file it holds.
+ */
+esp_err_t file_cache_write_file(const char *path, const void *data, size_t len);
+
+void file_cache_get_stats(file_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum number of byte ranges honoured in a single Range header.
+// Requests asking for more are answered with the full file.
+#define WEB_STATIC_MAX_RANGES       8
+
+/**
+ * @brief One satisfiable byte range, both ends inclusive.
+ */
+typedef struct {
+    size_t start;
+    size_t end;
+} web_static_range_t;
+
+/**
+ * @brief Parse the value of an HTTP Range header against a file of known size.
+ *
+ * Supports "bytes=a-b", "bytes=a-" and "bytes=-n" specs, comma separated.
+ * Unsatisfiable specs inside a list are dropped, as RFC 9110 allows.
+ *
+ * @param hdr        Header value, e.g. "bytes=0-499,1000-"
+ * @param file_size  Size of the resource in bytes
+ * @param ranges     Output array
+ * @param max_ranges Capacity of @p ranges
+ *
+ * @return number of ranges written (> 0),
+ *         0 if the header should be ignored and the whole file sent,
+ *         -1 if no range is satisfiable (caller answers 416).
+ */
+int web_static_parse_range(const char *hdr, size_t file_size,
+                           web_static_range_t *ranges, int max_ranges);
+
+/**
+ * @brief Return a MIME type for a path based on its extension.
+ */
+const char *web_static_mime_type(const char *filepath);
+
+/**
+ * @brief Send a file from a mounted filesystem as the response to @p req.
+ *
+ * Honours the Range request header: single ranges are answered with
+ * 206 Partial Content, multiple ranges with multipart/byteranges, and
+ * the file is lseek()'d to each range instead of being read from 0.
+ * Always advertises "Accept-Ranges: bytes". Files found in the mapped
+ * asset partition (see web_static_mount_assets()) or held by the RAM
+ * cache (see file_cache.h) are sent straight from memory; other files
+ * are streamed through a buffer from buf_pool.
+ *
+ * @param req          Request being answered
+ * @param filepath     Absolute VFS path, e.g. "/storage/index.html"
+ * @param content_type MIME type, or NULL to derive it from the extension
+ *
+ * @return ESP_OK when the whole response was sent, ESP_FAIL otherwise.
+ *         On failure an error response has been sent or the session closed.
+ */
+esp_err_t web_static_send_file(httpd_req_t *req, const char *filepath, const char *content_type);
+
+/**
+ * @brief Serve files under @p fs_prefix from a read-only asset partition.
+ *
+ * Maps @p partition_label (built by asset_fs_create_partition_image())
+ * once; afterwards "/storage/index.html" with fs_prefix "/storage" is
+ * answered from "/index.html" in the bundle, and only files missing
+ * there fall back to the filesystem. Bundle files carry an ETag from
+ * their content hash (304 on If-None-Match) and, when the bundle has
+ * one, go out as the precompressed gzip variant to clients that accept it.
+ */
+esp_err_t web_static_mount_assets(const char *partition_label, const char *fs_prefix);
+
+/**
+ * @brief URI handler reporting file cache, I/O buffer pool and heap
+ *        (free / largest free block) counters as JSON.
+ */
+esp_err_t web_static_stats_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,365 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "web_static.h"
+#include "file_cache.h"
+#include "buf_pool.h"
+#include "json_stream.h"
+#include "asset_fs.h"
+#include "resp_writer.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "web_static";
+
+#define MULTIPART_BOUNDARY "ESP32_BYTERANGE_BOUNDARY"
+
+// How long a request waits for a pooled I/O buffer before using the heap
+#define IO_BUF_WAIT_MS      50
+
+// Filesystem prefix whose files are looked up in the asset partition first
+static const char *s_asset_prefix = NULL;
+static size_t s_asset_prefix_len = 0;
+
+int web_static_parse_range(const char *hdr, size_t file_size,
+                           web_static_range_t *ranges, int max_ranges)
+{
+    if (hdr == NULL || strncmp(hdr, "bytes=", 6) != 0) {
+        return 0; // Unknown unit, ignore the header
+    }
+
+    const char *p = hdr + 6;
+    int count = 0;
+    bool any_spec = false;
+
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '\0') break;
+
+        bool has_first = false, has_last = false;
+        unsigned long long first = 0, last = 0;
+        char *endp;
+
+        if (isdigit((unsigned char)*p)) {
+            first = strtoull(p, &endp, 10);
+            has_first = true;
+            p = endp;
+        }
+        if (*p != '-') return 0; // Malformed, ignore the header
+        p++;
+        if (isdigit((unsigned char)*p)) {
+            last = strtoull(p, &endp, 10);
+            has_last = true;
+            p = endp;
+        }
+        while (*p == ' ' || *p == '\t') p++;
+        if ((*p != ',' && *p != '\0') || (!has_first && !has_last)) return 0;
+        if (has_first && has_last && last < first) return 0;
+        any_spec = true;
+
+        web_static_range_t r;
+        if (!has_first) {
+            // Suffix range: the last N bytes
+            if (last == 0 || file_size == 0) continue;
+            r.start = (last >= file_size) ? 0 : file_size - (size_t)last;
+            r.end = file_size - 1;
+        } else {
+            if (first >= file_size) continue;
+            r.start = (size_t)first;
+            r.end = (!has_last || last >= file_size) ? file_size - 1 : (size_t)last;
+        }
+
+        if (count == max_ranges) return 0; // Too many ranges, send the whole file
+        ranges[count++] = r;
+    }
+
+    if (!any_spec) return 0;
+    return count > 0 ? count : -1;
+}
+
+const char *web_static_mime_type(const char *filepath)
+{
+    const char *ext = strrchr(filepath, '.');
+    if (ext == NULL) return "text/plain";
+    if (strcasecmp(ext, ".html") == 0 || strcasecmp(ext, ".htm") == 0) return "text/html";
+    if (strcasecmp(ext, ".js") == 0) return "application/javascript";
+    if (strcasecmp(ext, ".css") == 0) return "text/css";
+    if (strcasecmp(ext, ".png") == 0) return "image/png";
+    if (strcasecmp(ext, ".ico") == 0) return "image/x-icon";
+    if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0) return "image/jpeg";
+    if (strcasecmp(ext, ".json") == 0) return "application/json";
+    if (strcasecmp(ext, ".bin") == 0) return "application/octet-stream";
+    return "text/plain";
+}
+
+// Where response bytes come from: memory (mapped flash or a cache entry) or an open file
+typedef struct {
+    const uint8_t *data;
+    const file_cache_entry_t *cached;
+    int fd;
+    char *chunk;
+} file_source_t;
+
+// Stream [start, start + len) of the file through @p w
+static esp_err_t send_span(resp_writer_t *w, const file_source_t *src, size_t start, size_t len)
+{
+    if (src->data) {
+        // Straight from memory, no staging copy
+        const char *data = (const char *)src->data + start;
+        if (len > 0 && resp_writer_write(w, data, len) != ESP_OK) {
+            ESP_LOGE(TAG, "File sending failed!");
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    int fd = src->fd;
+    char *chunk = src->chunk;
+    // Whole segments per read, so full reads pass through the writer unsplit
+    size_t chunk_size = buf_pool_buf_size();
+    if (chunk_size > RESP_WRITER_CHUNK_SIZE) chunk_size -= chunk_size % RESP_WRITER_CHUNK_SIZE;
+    if (lseek(fd, (off_t)start, SEEK_SET) == (off_t)-1) {
+        ESP_LOGE(TAG, "Seek to %u failed", (unsigned)start);
+        return ESP_FAIL;
+    }
+    while (len > 0) {
+        size_t want = len < chunk_size ? len : chunk_size;
+        ssize_t read_bytes = read(fd, chunk, want);
+        if (read_bytes <= 0) {
+            ESP_LOGE(TAG, "Error reading file (ret %d)", (int)read_bytes);
+            return ESP_FAIL;
+        }
+        if (resp_writer_write(w, chunk, read_bytes) != ESP_OK) {
+            ESP_LOGE(TAG, "File sending failed!");
+            return ESP_FAIL;
+        }
+        len -= read_bytes;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t send_multipart(httpd_req_t *req, resp_writer_t *w, const file_source_t *src,
+                                const web_static_range_t *ranges, int nranges,
+                                size_t file_size, const char *content_type)
+{
+    char part_hdr[160];
+
+    httpd_resp_set_status(req, "206 Partial Content");
+    httpd_resp_set_type(req, "multipart/byteranges; boundary=" MULTIPART_BOUNDARY);
+
+    for (int i = 0; i < nranges; i++) {
+        int n = snprintf(part_hdr, sizeof(part_hdr),
+                         "\r\n--" MULTIPART_BOUNDARY "\r\n"
+                         "Content-Type: %s\r\n"
+                         "Content-Range: bytes %u-%u/%u\r\n\r\n",
+                         content_type, (unsigned)ranges[i].start,
+                         (unsigned)ranges[i].end, (unsigned)file_size);
+        if (n < 0 || n >= (int)sizeof(part_hdr)) return ESP_FAIL;
+        // Part headers are coalesced with the data that follows them
+        if (resp_writer_write(w, part_hdr, n) != ESP_OK) return ESP_FAIL;
+        if (send_span(w, src, ranges[i].start,
+                      ranges[i].end - ranges[i].start + 1) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return resp_writer_write_str(w, "\r\n--" MULTIPART_BOUNDARY "--\r\n");
+}
+
+esp_err_t web_static_mount_assets(const char *partition_label, const char *fs_prefix)
+{
+    esp_err_t err = asset_fs_mount(partition_label);
+    if (err == ESP_OK) {
+        s_asset_prefix = fs_prefix;
+        s_asset_prefix_len = strlen(fs_prefix);
+    }
+    return err;
+}
+
+// Find @p filepath in the mapped asset partition
+static bool find_asset(const char *filepath, asset_fs_file_t *asset)
+{
+    if (!s_asset_prefix || strncmp(filepath, s_asset_prefix, s_asset_prefix_len) != 0) {
+        return false;
+    }
+    return asset_fs_find(filepath + s_asset_prefix_len, asset);
+}
+
+// True if header @p field of @p req is present and contains @p token
+static bool hdr_contains(httpd_req_t *req, const char *field, const char *token)
+{
+    char value[96];
+    return httpd_req_get_hdr_value_str(req, field, value, sizeof(value)) == ESP_OK &&
+           strstr(value, token) != NULL;
+}
+
+esp_err_t web_static_send_file(httpd_req_t *req, const char *filepath, const char *content_type)
+{
+    file_source_t src = { .data = NULL, .cached = NULL, .fd = -1, .chunk = NULL };
+    size_t file_size;
+    asset_fs_file_t asset;
+    char etag[sizeof(asset.etag) + 3];  // referenced by the response headers until sent
+
+    if (find_asset(filepath, &asset)) {
+        // Mapped read-only flash: nothing to cache or buffer, and a content hash for free
+        src.data = asset.data;
+        file_size = asset.size;
+        strcpy(etag, asset.etag);
+        if (asset.gz_data) {
+            httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+            // Ranges always refer to the plain representation
+            if (httpd_req_get_hdr_value_len(req, "Range") == 0 &&
+                hdr_contains(req, "Accept-Encoding", "gzip")) {
+                httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+                src.data = asset.gz_data;
+                file_size = asset.gz_size;
+                strcpy(etag + strlen(etag) - 1, "-gz\""); // distinct tag per encoding
+            }
+        }
+        httpd_resp_set_hdr(req, "ETag", etag);
+        if (hdr_contains(req, "If-None-Match", etag)) {
+            httpd_resp_set_status(req, "304 Not Modified");
+            return httpd_resp_send(req, NULL, 0);
+        }
+    } else if ((src.cached = file_cache_acquire(filepath, &src.fd)) != NULL) {
+        src.data = file_cache_data(src.cached);
+        file_size = file_cache_size(src.cached);
+    } else {
+        // Not cacheable: stream from the handle the cache already opened
+        if (src.fd == -1) {
+            ESP_LOGE(TAG, "Failed to open %s", filepath);
+            httpd_resp_send_404(req);
+            return ESP_FAIL;
+        }
+        struct stat st;
+        if (fstat(src.fd, &st) != 0) {
+            ESP_LOGE(TAG, "Failed to stat %s", filepath);
+            close(src.fd);
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
+        }
+        file_size = (size_t)st.st_size;
+    }
+    if (content_type == NULL) content_type = web_static_mime_type(filepath);
+
+    web_static_range_t ranges[WEB_STATIC_MAX_RANGES];
+    int nranges = 0;
+    char range_hdr[128];
+    size_t hdr_len = httpd_req_get_hdr_value_len(req, "Range");
+    if (hdr_len > 0 && hdr_len < sizeof(range_hdr) &&
+        httpd_req_get_hdr_value_str(req, "Range", range_hdr, sizeof(range_hdr)) == ESP_OK) {
+        nranges = web_static_parse_range(range_hdr, file_size, ranges, WEB_STATIC_MAX_RANGES);
+    }
+
+    // Header values are referenced, not copied, until the first chunk goes out
+    char content_range[48];
+    esp_err_t err = ESP_OK;
+    httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+
+    if (nranges < 0) {
+        snprintf(content_range, sizeof(content_range), "bytes */%u", (unsigned)file_size);
+        httpd_resp_set_status(req, "416 Range Not Satisfiable");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+        httpd_resp_send(req, NULL, 0);
+        goto done;
+    }
+
+    if (!src.data) {
+        src.chunk = (char *)buf_pool_get(pdMS_TO_TICKS(IO_BUF_WAIT_MS));
+        if (!src.chunk) {
+            ESP_LOGE(TAG, "Failed to allocate scratch buffer");
+            httpd_resp_send_500(req);
+            err = ESP_FAIL;
+            goto done;
+        }
+    }
+
+    resp_writer_t w;
+    resp_writer_init(&w, req);
+    if (nranges == 0) {
+        httpd_resp_set_type(req, content_type);
+        err = send_span(&w, &src, 0, file_size);
+    } else if (nranges == 1) {
+        snprintf(content_range, sizeof(content_range), "bytes %u-%u/%u",
+                 (unsigned)ranges[0].start, (unsigned)ranges[0].end, (unsigned)file_size);
+        httpd_resp_set_status(req, "206 Partial Content");
+        httpd_resp_set_type(req, content_type);
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+        err = send_span(&w, &src, ranges[0].start, ranges[0].end - ranges[0].start + 1);
+    } else {
+        err = send_multipart(req, &w, &src, ranges, nranges, file_size, content_type);
+    }
+
+    if (err == ESP_OK) err = resp_writer_finish(&w);
+    else resp_writer_discard(&w);
+    if (err != ESP_OK) {
+        httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+    } else {
+        ESP_LOGI(TAG, "File '%s' sent (%d range(s), %s)", filepath, nranges,
+                 src.cached ? "cached" : src.data ? "mapped" : "flash");
+    }
+
+done:
+    if (src.cached) file_cache_release(src.cached);
+    if (src.fd != -1) close(src.fd);
+    buf_pool_put(src.chunk);
+    return err;
+}
+
+esp_err_t web_static_stats_handler(httpd_req_t *req)
+{
+    file_cache_stats_t cs;
+    buf_pool_stats_t ps;
+    char resp[480];
+    json_stream_t js;
+
+    file_cache_get_stats(&cs);
+    buf_pool_get_stats(&ps);
+
+    json_stream_init(&js, resp, sizeof(resp));
+    json_stream_negotiate(&js, req);  // JSON, or CBOR for Accept: application/cbor
+    json_stream_begin_object(&js);
+
+    json_stream_key(&js, "cache");
+    json_stream_begin_object(&js);
+    json_stream_kv_uint(&js, "hits", cs.hits);
+    json_stream_kv_uint(&js, "misses", cs.misses);
+    json_stream_kv_uint(&js, "evictions", cs.evictions);
+    json_stream_kv_uint(&js, "invalidations", cs.invalidations);
+    json_stream_kv_uint(&js, "entries", cs.entries);
+    json_stream_kv_uint(&js, "bytes_used", cs.bytes_used);
+    json_stream_kv_uint(&js, "bytes_budget", cs.bytes_budget);
+    json_stream_end_object(&js);
+
+    json_stream_key(&js, "buf_pool");
+    json_stream_begin_object(&js);
+    json_stream_kv_uint(&js, "acquired", ps.acquired);
+    json_stream_kv_uint(&js, "waited", ps.waited);
+    json_stream_kv_uint(&js, "exhausted", ps.exhausted);
+    json_stream_kv_uint(&js, "fallback_failed", ps.fallback_failed);
+    json_stream_kv_uint(&js, "try_failed", ps.try_failed);
+    json_stream_kv_uint(&js, "in_use", ps.in_use);
+    json_stream_kv_uint(&js, "in_use_max", ps.in_use_max);
+    json_stream_kv_uint(&js, "count", ps.count);
+    json_stream_kv_uint(&js, "buf_size", ps.buf_size);
+    json_stream_end_object(&js);
+
+    // Free vs largest free block shows how fragmented the heap has become
+    json_stream_key(&js, "heap");
+    json_stream_begin_object(&js);
+    json_stream_kv_uint(&js, "free", heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    json_stream_kv_uint(&js, "min_free", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    json_stream_kv_uint(&js, "largest_free_block", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    json_stream_end_object(&js);
+
+    json_stream_end_object(&js);
+    if (json_stream_finish(&js) != ESP_OK) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    return httpd_resp_send(req, resp, json_stream_len(&js));
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Station reconnect policy as a pure state machine: no Wi-Fi calls, no
+ * timers, no clock. The caller feeds it events with the current time and
+ * a random number, and carries out the returned action: call
+ * esp_wifi_connect() / esp_wifi_disconnect(), and (re)arm or stop a
+ * one-shot timer whose expiry is fed back with wifi_reconnect_timer().
+ * Nothing here blocks, so it can run in the default event loop, and the
+ * same code runs on the host against simulated events.
+ *
+ *   IDLE --start--> CONNECTING --got IP--> CONNECTED
+ *                    |      ^                  |
+ *     disconnected / |      | timer            | disconnected
+ *     connect timeout v     |                  v
+ *                    BACKOFF <-----------------+
+ *
+ * Retry n (from 1) waits backoff_min_ms * 2^(n-1), capped at
+ * backoff_max_ms, each randomised by +-jitter_pct so stations that lost
+ * the same AP do not retry in lockstep.
+ */
+
+// Reconnect time buckets (upper bounds, milliseconds); one more for anything longer
+#define WIFI_RECONNECT_BUCKETS_MS   { 250, 500, 1000, 2500, 5000, 10000, 30000, 60000 }
+#define WIFI_RECONNECT_NUM_BUCKETS  8
+
+typedef struct {
+    uint32_t backoff_min_ms;    // wait before the first retry
+    uint32_t backoff_max_ms;    // retry period while the AP stays away
+    uint8_t jitter_pct;         // 0..100
+    uint32_t connect_timeout_ms;    // an attempt without an address by then has failed
+} wifi_reconnect_config_t;
+
+#define WIFI_RECONNECT_DEFAULT_CONFIG() {           \
+    .backoff_min_ms = 250,                          \
+    .backoff_max_ms = 5000,                         \
+    .jitter_pct = 25,                               \
+    .connect_timeout_ms = 15000,                    \
+}
+
+typedef enum {
+    WIFI_RECONNECT_IDLE,
+    WIFI_RECONNECT_CONNECTING,
+    WIFI_RECONNECT_BACKOFF,
+    WIFI_RECONNECT_CONNECTED,
+} wifi_reconnect_state_t;
+
+typedef struct {
+    uint32_t disconnects;       // connection lost after having an address
+    uint32_t attempts;          // connects requested, the first included
+    uint32_t failures;          // attempts ended by a disconnect or the timeout
+    uint32_t timeouts;
+    uint32_t reconnects;        // address regained after a disconnect
+    uint64_t reconnect_total_us;    // disconnect to address, over reconnects
+    uint32_t reconnect_max_us;
+    uint32_t reconnect_last_us;
+    uint32_t buckets[WIFI_RECONNECT_NUM_BUCKETS + 1];   // reconnect times, non-cumulative
+    uint32_t first_connect_us;  // start to the first address
+} wifi_reconnect_stats_t;
+
+/**
+ * @brief What the caller must do after an event, in this order.
+ */
+typedef struct {
+    bool disconnect;            // esp_wifi_disconnect()
+    bool connect;               // esp_wifi_connect()
+    bool stop_timer;
+    uint64_t timer_us;          // > 0: arm the timer for this long (after stopping it)
+    uint32_t timer_seq;         // pass back to wifi_reconnect_timer() when it fires
+} wifi_reconnect_action_t;
+
+/**
+ * @brief Machine state. Lives in caller storage; not thread-safe, so feed
+ *        all events from one task or under one lock.
+ */
+typedef struct {
+    wifi_reconnect_config_t config;
+    wifi_reconnect_state_t state;
+    uint32_t failures;          // in a row, since the last address
+    uint32_t timer_seq;         // of the armed timer; older expiries are ignored
+    int64_t started_us;
+    int64_t down_since_us;      // 0 while no disconnect is being recovered from
+    bool connected_once;
+    wifi_reconnect_stats_t stats;
+} wifi_reconnect_t;
+
+void wifi_reconnect_init(wifi_reconnect_t *rc, const wifi_reconnect_config_t *config);
+
+/**
+ * @brief WIFI_EVENT_STA_START: connect now.
+ */
+wifi_reconnect_action_t wifi_reconnect_start(wifi_reconnect_t *rc, int64_t now_us);
+
+/**
+ * @brief WIFI_EVENT_STA_DISCONNECTED: retry after the backoff.
+ */
+wifi_reconnect_action_t wifi_reconnect_disconnected(wifi_reconnect_t *rc, int64_t now_us, uint32_t random);
+
+/**
+ * @brief IP_EVENT_STA_GOT_IP: connected; the backoff starts over.
+ */
+wifi_reconnect_action_t wifi_reconnect_got_ip(wifi_reconnect_t *rc, int64_t now_us);
+
+/**
+ * @brief The timer armed with @p seq expired: retry, or give up on a stuck attempt.
+ */
+wifi_reconnect_action_t wifi_reconnect_timer(wifi_reconnect_t *rc, uint32_t seq, int64_t now_us, uint32_t random);
+
+/**
+ * @brief Delay before retry @p failures (1 for the first), with jitter from @p random.
+ */
+uint32_t wifi_reconnect_backoff_ms(const wifi_reconnect_config_t *config, uint32_t failures, uint32_t random);
+
+#ifdef __cplusplus
+}
+#endif
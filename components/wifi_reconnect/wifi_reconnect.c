@@ -0,0 +1,120 @@
+#include <string.h>
+#include "wifi_reconnect.h"
+
+static const uint32_t s_bucket_ms[WIFI_RECONNECT_NUM_BUCKETS] = WIFI_RECONNECT_BUCKETS_MS;
+
+static void arm(wifi_reconnect_t *rc, wifi_reconnect_action_t *a, uint32_t ms)
+{
+    a->stop_timer = true;
+    a->timer_us = (uint64_t)ms * 1000;
+    a->timer_seq = ++rc->timer_seq;
+}
+
+static void connect_now(wifi_reconnect_t *rc, wifi_reconnect_action_t *a)
+{
+    rc->state = WIFI_RECONNECT_CONNECTING;
+    rc->stats.attempts++;
+    a->connect = true;
+    arm(rc, a, rc->config.connect_timeout_ms);
+}
+
+static void back_off(wifi_reconnect_t *rc, wifi_reconnect_action_t *a, uint32_t random)
+{
+    rc->state = WIFI_RECONNECT_BACKOFF;
+    rc->failures++;
+    arm(rc, a, wifi_reconnect_backoff_ms(&rc->config, rc->failures, random));
+}
+
+uint32_t wifi_reconnect_backoff_ms(const wifi_reconnect_config_t *config, uint32_t failures, uint32_t random)
+{
+    uint64_t ms = config->backoff_min_ms;
+    for (uint32_t i = 1; i < failures && ms < config->backoff_max_ms; i++) ms *= 2;
+    if (ms > config->backoff_max_ms) ms = config->backoff_max_ms;
+
+    // Uniform in [ms - jitter, ms + jitter]
+    uint64_t jitter = ms * (config->jitter_pct > 100 ? 100 : config->jitter_pct) / 100;
+    if (jitter > 0) ms = ms - jitter + random % (2 * jitter + 1);
+    return ms > 0 ? (uint32_t)ms : 1;
+}
+
+void wifi_reconnect_init(wifi_reconnect_t *rc, const wifi_reconnect_config_t *config)
+{
+    memset(rc, 0, sizeof(*rc));
+    rc->config = *config;
+    rc->state = WIFI_RECONNECT_IDLE;
+}
+
+wifi_reconnect_action_t wifi_reconnect_start(wifi_reconnect_t *rc, int64_t now_us)
+{
+    wifi_reconnect_action_t a = { 0 };
+    if (rc->state != WIFI_RECONNECT_IDLE) return a;
+    rc->started_us = now_us;
+    connect_now(rc, &a);
+    return a;
+}
+
+wifi_reconnect_action_t wifi_reconnect_disconnected(wifi_reconnect_t *rc, int64_t now_us, uint32_t random)
+{
+    wifi_reconnect_action_t a = { 0 };
+    switch (rc->state) {
+    case WIFI_RECONNECT_CONNECTED:
+        rc->stats.disconnects++;
+        rc->down_since_us = now_us;
+        rc->failures = 0;
+        back_off(rc, &a, random);
+        break;
+    case WIFI_RECONNECT_CONNECTING:
+        rc->stats.failures++;
+        back_off(rc, &a, random);
+        break;
+    default:
+        break;                  // already waiting, or not started
+    }
+    return a;
+}
+
+wifi_reconnect_action_t wifi_reconnect_got_ip(wifi_reconnect_t *rc, int64_t now_us)
+{
+    wifi_reconnect_action_t a = { 0 };
+    if (rc->state == WIFI_RECONNECT_IDLE || rc->state == WIFI_RECONNECT_CONNECTED) return a;
+
+    rc->state = WIFI_RECONNECT_CONNECTED;
+    rc->failures = 0;
+    a.stop_timer = true;
+    rc->timer_seq++;            // an expiry already on its way is stale now
+
+    if (!rc->connected_once) {
+        rc->connected_once = true;
+        rc->stats.first_connect_us = (uint32_t)(now_us - rc->started_us);
+    }
+    if (rc->down_since_us != 0) {
+        uint32_t us = (uint32_t)(now_us - rc->down_since_us);
+        rc->down_since_us = 0;
+        rc->stats.reconnects++;
+        rc->stats.reconnect_total_us += us;
+        rc->stats.reconnect_last_us = us;
+        if (us > rc->stats.reconnect_max_us) rc->stats.reconnect_max_us = us;
+        size_t b = 0;
+        while (b < WIFI_RECONNECT_NUM_BUCKETS && us > s_bucket_ms[b] * 1000) b++;
+        rc->stats.buckets[b]++;
+    }
+    return a;
+}
+
+wifi_reconnect_action_t wifi_reconnect_timer(wifi_reconnect_t *rc, uint32_t seq, int64_t now_us, uint32_t random)
+{
+    wifi_reconnect_action_t a = { 0 };
+    if (seq != rc->timer_seq) return a;
+
+    if (rc->state == WIFI_RECONNECT_BACKOFF) {
+        connect_now(rc, &a);
+    } else if (rc->state == WIFI_RECONNECT_CONNECTING) {
+        // Associated without an address, or no answer at all: drop it and retry.
+        // The disconnect event this causes arrives in BACKOFF and is ignored.
+        rc->stats.timeouts++;
+        rc->stats.failures++;
+        a.disconnect = true;
+        back_off(rc, &a, random);
+    }
+    return a;
+}
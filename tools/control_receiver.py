@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Stand-in for the Task3 receiver, to exercise senders on a PC.
+
+Serves the receiver's HTTP API (POST /control, GET /message) with
+keep-alive and pipelining, checks control messages the same way the
+firmware does, and prints how many requests each connection carried.
+Optional --delay-ms adds per-request service time and --close-every
+closes connections after N requests, to exercise reconnects.
+
+Examples:
+    python tools/control_receiver.py --port 8080
+    python tools/http_bench.py --host 127.0.0.1 --port 8080 --profile receiver --pipeline 4
+"""
+import argparse
+import json
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+MESSAGE_MAX = 99    # global_message[100] on the receiver
+
+
+class State:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.toggle = False
+        self.message = 'Initial message'
+        self.accepted = 0
+        self.rejected = 0
+        self.requests = 0
+        self.connections = 0
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'   # keep-alive unless the client says otherwise
+    server_version = 'control-receiver'
+    disable_nagle_algorithm = True  # headers and body are separate writes
+
+    def setup(self):
+        super().setup()
+        self.served = 0
+        with self.server.state.lock:
+            self.server.state.connections += 1
+
+    def finish(self):
+        super().finish()
+        if self.server.verbose:
+            print('connection %s:%d closed after %d requests' % (self.client_address + (self.served,)))
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def reply(self, status, body, content_type='text/plain'):
+        data = body.encode()
+        self.served += 1
+        close = self.server.close_every and self.served % self.server.close_every == 0
+        if self.server.delay:
+            time.sleep(self.server.delay)
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        self.send_header('Content-Length', str(len(data)))
+        if close:
+            self.send_header('Connection', 'close')
+            self.close_connection = True
+        self.end_headers()
+        self.wfile.write(data)
+        with self.server.state.lock:
+            self.server.state.requests += 1
+
+    def do_POST(self):
+        length = int(self.headers.get('Content-Length', 0))
+        body = self.rfile.read(length)
+        if self.path.split('?')[0] != '/control':
+            self.reply(404, 'Not found')
+            return
+        try:
+            msg = json.loads(body)
+            ok = isinstance(msg.get('toggle'), bool) and isinstance(msg.get('message'), str)
+        except (ValueError, AttributeError):
+            ok = False
+        st = self.server.state
+        with st.lock:
+            if ok:
+                st.toggle = msg['toggle']
+                st.message = msg['message'][:MESSAGE_MAX]
+                st.accepted += 1
+            else:
+                st.rejected += 1
+        if ok:
+            self.reply(200, 'Data received and processed')
+        else:
+            self.reply(400, 'Invalid JSON format')
+
+    def do_GET(self):
+        path = self.path.split('?')[0]
+        if path == '/message':
+            with self.server.state.lock:
+                message = self.server.state.message
+            self.reply(200, message)
+        elif path == '/metrics':
+            st = self.server.state
+            with st.lock:
+                text = ('control_messages_total %d\ncontrol_rejected_total %d\n'
+                        'connections_total %d\nrequests_total %d\n' %
+                        (st.accepted, st.rejected, st.connections, st.requests))
+            self.reply(200, text)
+        else:
+            self.reply(404, 'Not found')
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--bind', default='127.0.0.1')
+    ap.add_argument('--port', type=int, default=8080)
+    ap.add_argument('--delay-ms', type=float, default=0.0, help='service time added to every request')
+    ap.add_argument('--close-every', type=int, default=0, help='close each connection after N requests')
+    ap.add_argument('--verbose', action='store_true', help='print requests per connection')
+    args = ap.parse_args()
+
+    server = ThreadingHTTPServer((args.bind, args.port), Handler)
+    server.daemon_threads = True
+    server.state = State()
+    server.delay = args.delay_ms / 1000.0
+    server.close_every = args.close_every
+    server.verbose = args.verbose
+    print('listening on %s:%d' % (args.bind, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    st = server.state
+    print('\n%d requests on %d connections (%.1f per connection), %d accepted, %d rejected' % (
+        st.requests, st.connections, st.requests / max(1, st.connections), st.accepted, st.rejected))
+
+
+if __name__ == '__main__':
+    main()
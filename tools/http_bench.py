@@ -0,0 +1,350 @@
+#!/usr/bin/env python3
+"""Closed-loop HTTP load generator for the firmware web servers.
+
+N workers each send requests back to back, picked from a weighted mix,
+over keep-alive connections (or a new connection per request), or
+--pipeline requests at a time on one connection. Prints throughput and
+latency percentiles per request and overall.
+
+Results can be saved with --json and compared against an earlier run
+with --compare, which exits with status 1 when throughput drops or p99
+grows by more than --tolerance. Keep host, mix, concurrency and duration
+the same between the runs being compared.
+
+Examples:
+    # Task2 (connected to its AP), built-in mix
+    python tools/http_bench.py --host 192.168.4.1 --profile task2 \
+        --concurrency 4 --duration 30 --json before.json
+
+    # Same run on a later commit, flag regressions
+    python tools/http_bench.py --host 192.168.4.1 --profile task2 \
+        --concurrency 4 --duration 30 --compare before.json
+
+    # Control messages pipelined 4 deep against the stand-in receiver
+    python tools/control_receiver.py --port 8080 &
+    python tools/http_bench.py --host 127.0.0.1 --port 8080 \
+        --req 'POST /control 1 {"toggle":true,"message":"bench"}' --pipeline 4
+
+    # The shared handlers built for the host (Task3/bench, linux target)
+    HTTP_LOAD_SERVE=1 Task3/bench/build/transport_bench.elf &
+    python tools/http_bench.py --host 127.0.0.1 --port 8081 --profile bench
+
+    # Custom mix: METHOD PATH [WEIGHT] [BODY]
+    python tools/http_bench.py --host 192.168.4.2 \
+        --req 'GET /message 3' \
+        --req 'POST /control 1 {"toggle":true,"message":"bench"}'
+"""
+import argparse
+import http.client
+import json
+import random
+import socket
+import subprocess
+import threading
+import time
+
+# Request mixes for the three servers in this repo and the host build of their
+# shared handlers (Task3/bench): (method, path, weight, body)
+PROFILES = {
+    'bench': [
+        ('GET', '/index.html', 4, None),
+        ('GET', '/big.bin', 1, None),
+        ('GET', '/stats', 4, None),
+        ('GET', '/workers', 1, None),
+        ('GET', '/metrics', 1, None),
+        ('POST', '/control', 4, '{"toggle":true,"message":"bench"}'),
+    ],
+    'task2': [
+        ('GET', '/data', 10, None),
+        ('GET', '/data?since=0&max=64&timeout=0', 3, None),
+        ('GET', '/stats', 1, None),
+        ('GET', '/', 1, None),
+    ],
+    'receiver': [
+        ('GET', '/message', 5, None),
+        ('POST', '/control', 5, '{"toggle":true,"message":"bench"}'),
+    ],
+    'ota': [
+        ('GET', '/api/status', 10, None),
+        ('GET', '/api/stats', 1, None),
+        ('GET', '/', 1, None),
+    ],
+}
+
+
+def percentile(samples, p):
+    if not samples:
+        return float('nan')
+    s = sorted(samples)
+    k = min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))
+    return s[k]
+
+
+def parse_req(spec):
+    parts = spec.split(None, 3)
+    if len(parts) < 2:
+        raise argparse.ArgumentTypeError('expected "METHOD PATH [WEIGHT] [BODY]": %r' % spec)
+    weight = int(parts[2]) if len(parts) > 2 else 1
+    body = parts[3] if len(parts) > 3 else None
+    return (parts[0].upper(), parts[1], weight, body)
+
+
+class Stats:
+    def __init__(self, mix):
+        self.lock = threading.Lock()
+        self.latencies = {key(r): [] for r in mix}
+        self.errors = {key(r): 0 for r in mix}
+        self.bytes = 0
+        self.connects = 0
+
+
+def key(req):
+    return '%s %s' % (req[0], req[1])
+
+
+def worker(args, mix, seed, start_at, stop_at, stats):
+    rng = random.Random(seed)
+    weights = [r[2] for r in mix]
+    conn = None
+    while True:
+        now = time.perf_counter()
+        if now >= stop_at:
+            break
+        req = rng.choices(mix, weights)[0]
+        method, path, _, body = req
+        headers = {}
+        if body is not None:
+            headers['Content-Type'] = content_type(body)
+        if not args.keep_alive:
+            headers['Connection'] = 'close'
+        t0 = time.perf_counter()
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+                with stats.lock:
+                    stats.connects += 1
+            conn.request(method, path, body=body, headers=headers)
+            resp = conn.getresponse()
+            data = resp.read()
+            ok = resp.status < 400
+            if not args.keep_alive or resp.will_close:
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            ok = False
+            data = b''
+            if conn is not None:
+                conn.close()
+            conn = None
+        elapsed_ms = (time.perf_counter() - t0) * 1000.0
+
+        if t0 < start_at:
+            continue  # warm-up
+        with stats.lock:
+            if ok:
+                stats.latencies[key(req)].append(elapsed_ms)
+                stats.bytes += len(data)
+            else:
+                stats.errors[key(req)] += 1
+        if not ok:
+            time.sleep(0.05)
+    if conn is not None:
+        conn.close()
+
+
+def content_type(body):
+    return 'application/json' if body.startswith('{') else 'application/x-www-form-urlencoded'
+
+
+def encode_request(args, req):
+    method, path, _, body = req
+    data = (body or '').encode()
+    head = '%s %s HTTP/1.1\r\nHost: %s\r\n' % (method, path, args.host)
+    if body is not None:
+        head += 'Content-Type: %s\r\nContent-Length: %d\r\n' % (content_type(body), len(data))
+    return head.encode() + b'\r\n' + data
+
+
+def read_response(f):
+    """Read one Content-Length delimited response; returns (status, body, will_close)."""
+    status_line = f.readline()
+    if not status_line:
+        raise ConnectionError('connection closed')
+    status = int(status_line.split()[1])
+    length, will_close = 0, status_line.startswith(b'HTTP/1.0')
+    while True:
+        line = f.readline().strip()
+        if not line:
+            break
+        name, _, value = line.partition(b':')
+        name = name.strip().lower()
+        if name == b'content-length':
+            length = int(value)
+        elif name == b'connection':
+            will_close = value.strip().lower() == b'close'
+        elif name == b'transfer-encoding':
+            raise http.client.HTTPException('chunked responses are not supported with --pipeline')
+    return status, f.read(length), will_close
+
+
+def pipelined_worker(args, mix, seed, start_at, stop_at, stats):
+    """Write --pipeline requests back to back, then read their responses."""
+    rng = random.Random(seed)
+    weights = [r[2] for r in mix]
+    sock = f = None
+    while time.perf_counter() < stop_at:
+        batch = [rng.choices(mix, weights)[0] for _ in range(args.pipeline)]
+        t0 = time.perf_counter()
+        results = []
+        try:
+            if sock is None:
+                sock = socket.create_connection((args.host, args.port), timeout=args.timeout)
+                sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                f = sock.makefile('rb')
+                with stats.lock:
+                    stats.connects += 1
+            sock.sendall(b''.join(encode_request(args, r) for r in batch))
+            for req in batch:
+                status, data, will_close = read_response(f)
+                results.append((req, status < 400, data, (time.perf_counter() - t0) * 1000.0))
+                if will_close:
+                    break
+        except (OSError, ValueError, IndexError, http.client.HTTPException):
+            will_close = True
+        if (len(results) < len(batch) or will_close) and sock is not None:
+            sock.close()
+            sock = f = None
+        # Requests after a close or failure count as errors; the server never answered them
+        results += [(req, False, b'', 0.0) for req in batch[len(results):]]
+
+        if t0 < start_at:
+            continue  # warm-up
+        with stats.lock:
+            for req, ok, data, elapsed_ms in results:
+                if ok:
+                    stats.latencies[key(req)].append(elapsed_ms)
+                    stats.bytes += len(data)
+                else:
+                    stats.errors[key(req)] += 1
+    if sock is not None:
+        sock.close()
+
+
+def summarize(samples, errors, duration):
+    return {
+        'requests': len(samples),
+        'errors': errors,
+        'rps': len(samples) / duration,
+        'p50_ms': percentile(samples, 50),
+        'p90_ms': percentile(samples, 90),
+        'p99_ms': percentile(samples, 99),
+        'max_ms': max(samples) if samples else float('nan'),
+    }
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'],
+                                       stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def print_row(name, r):
+    print('%-44s %7d %5d %8.1f %8.1f %8.1f %8.1f %8.1f' % (
+        name, r['requests'], r['errors'], r['rps'], r['p50_ms'], r['p90_ms'], r['p99_ms'], r['max_ms']))
+
+
+def compare(result, baseline, tolerance):
+    """Print deltas against @baseline; return True if anything regressed."""
+    regressed = False
+    print('\nvs %s (tolerance %.0f%%):' % (baseline.get('commit') or 'baseline', tolerance * 100))
+    rows = [('total', result['total'], baseline.get('total'))]
+    rows += [(k, v, baseline.get('requests', {}).get(k)) for k, v in result['requests'].items()]
+    for name, cur, old in rows:
+        if not old or not old['requests'] or not cur['requests']:
+            continue
+        d_rps = cur['rps'] / old['rps'] - 1.0
+        d_p99 = cur['p99_ms'] / old['p99_ms'] - 1.0 if old['p99_ms'] > 0 else 0.0
+        bad = d_rps < -tolerance or d_p99 > tolerance
+        regressed |= bad
+        print('%-44s rps %+6.1f%%  p99 %+6.1f%%%s' % (name, d_rps * 100, d_p99 * 100,
+                                                      '  REGRESSION' if bad else ''))
+    return regressed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--host', default='192.168.4.1')
+    ap.add_argument('--port', type=int, default=80)
+    ap.add_argument('--profile', choices=sorted(PROFILES), help='built-in request mix')
+    ap.add_argument('--req', action='append', type=parse_req, default=[],
+                    help='"METHOD PATH [WEIGHT] [BODY]", repeatable; replaces --profile')
+    ap.add_argument('--concurrency', type=int, default=4, help='parallel workers')
+    ap.add_argument('--no-keep-alive', dest='keep_alive', action='store_false',
+                    help='open a new connection for every request')
+    ap.add_argument('--pipeline', type=int, default=1,
+                    help='requests written back to back per connection before reading responses')
+    ap.add_argument('--duration', type=float, default=20.0, help='measured seconds')
+    ap.add_argument('--warmup', type=float, default=2.0, help='seconds excluded from the results')
+    ap.add_argument('--timeout', type=float, default=10.0, help='socket timeout, seconds')
+    ap.add_argument('--seed', type=int, default=1, help='request mix RNG seed')
+    ap.add_argument('--json', help='write results to this file')
+    ap.add_argument('--compare', help='results file of an earlier run')
+    ap.add_argument('--tolerance', type=float, default=0.10,
+                    help='allowed relative throughput drop / p99 growth for --compare')
+    args = ap.parse_args()
+
+    mix = args.req or PROFILES.get(args.profile)
+    if not mix:
+        ap.error('give --profile or at least one --req')
+
+    if args.pipeline > 1 and not args.keep_alive:
+        ap.error('--pipeline needs keep-alive')
+
+    stats = Stats(mix)
+    start_at = time.perf_counter() + args.warmup
+    stop_at = start_at + args.duration
+    target = pipelined_worker if args.pipeline > 1 else worker
+    threads = [threading.Thread(target=target, args=(args, mix, args.seed + i, start_at, stop_at, stats),
+                                daemon=True) for i in range(args.concurrency)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    per_req = {k: summarize(v, stats.errors[k], args.duration) for k, v in stats.latencies.items()}
+    all_samples = [x for v in stats.latencies.values() for x in v]
+    total = summarize(all_samples, sum(stats.errors.values()), args.duration)
+
+    print('%-44s %7s %5s %8s %8s %8s %8s %8s' % ('request', 'ok', 'err', 'req/s', 'p50 ms', 'p90 ms',
+                                                 'p99 ms', 'max ms'))
+    for k, r in per_req.items():
+        print_row(k, r)
+    print_row('total', total)
+    print('%d connections, %.1f KB/s received' % (stats.connects, stats.bytes / 1024.0 / args.duration))
+
+    result = {
+        'commit': git_commit(),
+        'config': {'host': args.host, 'port': args.port, 'concurrency': args.concurrency,
+                   'keep_alive': args.keep_alive, 'pipeline': args.pipeline, 'duration': args.duration, 'seed': args.seed,
+                   'mix': [list(r) for r in mix]},
+        'connections': stats.connects,
+        'total': total,
+        'requests': per_req,
+    }
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(result, f, indent=2)
+
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+        if baseline.get('config', {}).get('mix') != result['config']['mix']:
+            print('warning: request mix differs from the baseline')
+        if compare(result, baseline, args.tolerance):
+            raise SystemExit(1)
+
+
+if __name__ == '__main__':
+    main()
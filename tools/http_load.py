@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Measure latency of a small endpoint while large downloads run concurrently.
+
+Example (Task2 board, connected to its AP):
+    python tools/http_load.py --host 192.168.4.1 --downloaders 3 \
+        --download-path /my_img.jpeg --probe-path /data --duration 30
+"""
+import argparse
+import http.client
+import threading
+import time
+
+
+def percentile(samples, p):
+    if not samples:
+        return float('nan')
+    s = sorted(samples)
+    k = min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))
+    return s[k]
+
+
+def downloader(args, stop, stats, lock):
+    conn = None
+    while not stop.is_set():
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+            conn.request('GET', args.download_path)
+            resp = conn.getresponse()
+            body = resp.read()
+            with lock:
+                stats['downloads'] += 1
+                stats['download_bytes'] += len(body)
+        except (OSError, http.client.HTTPException):
+            with lock:
+                stats['download_errors'] += 1
+            if conn is not None:
+                conn.close()
+            conn = None
+            time.sleep(0.1)
+    if conn is not None:
+        conn.close()
+
+
+def prober(args, stop, latencies, stats, lock):
+    conn = None
+    while not stop.is_set():
+        t0 = time.perf_counter()
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+            conn.request('GET', args.probe_path)
+            conn.getresponse().read()
+            with lock:
+                latencies.append((time.perf_counter() - t0) * 1000.0)
+        except (OSError, http.client.HTTPException):
+            with lock:
+                stats['probe_errors'] += 1
+            if conn is not None:
+                conn.close()
+            conn = None
+        time.sleep(args.probe_interval)
+    if conn is not None:
+        conn.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--host', default='192.168.4.1')
+    ap.add_argument('--port', type=int, default=80)
+    ap.add_argument('--downloaders', type=int, default=2, help='concurrent large downloads')
+    ap.add_argument('--download-path', default='/my_img.jpeg')
+    ap.add_argument('--probe-path', default='/data')
+    ap.add_argument('--probe-interval', type=float, default=0.05, help='seconds between probes')
+    ap.add_argument('--duration', type=float, default=20.0, help='seconds')
+    ap.add_argument('--timeout', type=float, default=10.0, help='socket timeout, seconds')
+    args = ap.parse_args()
+
+    stop = threading.Event()
+    lock = threading.Lock()
+    latencies = []
+    stats = {'downloads': 0, 'download_bytes': 0, 'download_errors': 0, 'probe_errors': 0}
+
+    threads = [threading.Thread(target=downloader, args=(args, stop, stats, lock), daemon=True)
+               for _ in range(args.downloaders)]
+    threads.append(threading.Thread(target=prober, args=(args, stop, latencies, stats, lock), daemon=True))
+    for t in threads:
+        t.start()
+    time.sleep(args.duration)
+    stop.set()
+    for t in threads:
+        t.join(args.timeout)
+
+    print('%s latency over %d requests (ms): p50=%.1f p90=%.1f p99=%.1f max=%.1f, errors=%d' % (
+        args.probe_path, len(latencies), percentile(latencies, 50), percentile(latencies, 90),
+        percentile(latencies, 99), max(latencies) if latencies else float('nan'), stats['probe_errors']))
+    print('%s: %d downloads, %.1f KB/s, errors=%d' % (
+        args.download_path, stats['downloads'], stats['download_bytes'] / 1024.0 / args.duration,
+        stats['download_errors']))
+
+
+if __name__ == '__main__':
+    main()
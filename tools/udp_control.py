@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""Both ends of the udp_control protocol, for benchmarking on a PC.
+
+    serve   stand-in receiver: acks frames, suppresses duplicates
+    bench   sender: keeps --window frames in flight, retransmits on
+            timeout, reports command latency (send to ack) and messages/s
+
+Frames match components/udp_control/include/udp_control.h, including the
+challenge/confirm handshake before a new session is accepted. --loss drops
+that fraction of outgoing datagrams on either side to exercise
+retransmits. To compare with the HTTP path on the same host:
+
+    python tools/udp_control.py serve --port 3333 &
+    python tools/udp_control.py bench --host 127.0.0.1 --port 3333 --window 8
+
+    python tools/control_receiver.py --port 8080 &
+    python tools/http_bench.py --host 127.0.0.1 --port 8080 --concurrency 1 \\
+        --req 'POST /control 1 {"toggle":true,"message":"bench"}'
+
+The bench end also works against the receiver firmware (port 3333).
+"""
+import argparse
+import random
+import select
+import socket
+import struct
+import time
+
+MAGIC = 0x4355
+VERSION = 2
+DATA, ACK, CHALLENGE, CONFIRM = 1, 2, 3, 4
+HDR = struct.Struct('<HBBII')       # magic, version, type, session, seq
+SACK_BITS = 32
+
+
+def control_payload(toggle, message):
+    msg = message.encode()[:99]
+    return bytes([int(toggle), len(msg)]) + msg
+
+
+def percentile(samples, p):
+    s = sorted(samples)
+    return s[min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))] if s else float('nan')
+
+
+def lossy_send(sock, data, addr, loss):
+    if random.random() < loss:
+        return
+    if addr:
+        sock.sendto(data, addr)
+    else:
+        sock.send(data)
+
+
+def serve(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    print('listening on udp %s:%d' % (args.bind, args.port))
+    session = candidate = nonce = None
+    base = sack = 0
+    frames = dups = 0
+    try:
+        while True:
+            data, addr = sock.recvfrom(2048)
+            if len(data) < HDR.size:
+                continue
+            magic, version, ftype, sess, seq = HDR.unpack_from(data)
+            if magic != MAGIC or version != VERSION:
+                continue
+            if ftype == CONFIRM:
+                if candidate is not None and (sess, seq) == (candidate, nonce):
+                    session, candidate, base, sack = sess, None, 0, 0
+                continue
+            if ftype != DATA or seq == 0:
+                continue
+            if sess != session:                 # new sender or a stale frame: challenge it
+                if sess != candidate:
+                    candidate, nonce = sess, random.getrandbits(32) | 1
+                lossy_send(sock, HDR.pack(MAGIC, VERSION, CHALLENGE, sess, nonce), addr, args.loss)
+                continue
+            ahead = seq - base - 1
+            if seq <= base or (ahead < SACK_BITS and sack >> ahead & 1):
+                dups += 1
+            else:
+                if ahead >= SACK_BITS:          # skipped frames count as lost
+                    shift = ahead - SACK_BITS + 1
+                    sack, base, ahead = sack >> shift, base + shift, ahead - shift
+                sack |= 1 << ahead
+                while sack & 1:
+                    base, sack = base + 1, sack >> 1
+                frames += 1
+            lossy_send(sock, HDR.pack(MAGIC, VERSION, ACK, session, base) + struct.pack('<I', sack),
+                       addr, args.loss)
+    except KeyboardInterrupt:
+        print('\n%d frames, %d duplicates' % (frames, dups))
+
+
+def bench(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.connect((args.host, args.port))
+    session = random.getrandbits(32) or 1
+    confirmed = None
+    pending = {}                # seq -> [frame, first_sent, last_sent, retries]
+    latencies = []
+    sent = retransmits = expired = superseded = 0
+    next_seq = 1
+    rto = args.rto_ms / 1000.0
+    start = time.perf_counter()
+    stop = start + args.duration
+
+    while time.perf_counter() < stop or pending:
+        now = time.perf_counter()
+        if now >= stop + 2.0:
+            break
+        for seq in [s for s in pending if next_seq - s >= SACK_BITS]:
+            del pending[seq]
+            superseded += 1
+        while now < stop and len(pending) < args.window:
+            frame = HDR.pack(MAGIC, VERSION, DATA, session, next_seq) + \
+                control_payload(next_seq & 1, 'Message #%d' % next_seq)
+            pending[next_seq] = [frame, now, now, 0]
+            lossy_send(sock, frame, None, args.loss)
+            next_seq += 1
+            sent += 1
+
+        for seq, p in list(pending.items()):
+            if now - p[2] >= rto * (1 << p[3]):
+                if p[3] >= args.max_retries:
+                    del pending[seq]
+                    expired += 1
+                    continue
+                p[2], p[3] = now, p[3] + 1
+                retransmits += 1
+                lossy_send(sock, p[0], None, args.loss)
+
+        if select.select([sock], [], [], rto / 2)[0]:
+            data = sock.recv(64)
+            if len(data) < HDR.size:
+                continue
+            magic, version, ftype, sess, cum = HDR.unpack_from(data)
+            if magic != MAGIC or sess != session:
+                continue
+            if ftype == CHALLENGE:
+                lossy_send(sock, HDR.pack(MAGIC, VERSION, CONFIRM, session, cum), None, args.loss)
+                if cum != confirmed:            # resend the window once the session is accepted
+                    confirmed = cum
+                    for p in pending.values():
+                        p[2] = 0.0
+                continue
+            if ftype != ACK or len(data) < HDR.size + 4:
+                continue
+            (bits,) = struct.unpack_from('<I', data, HDR.size)
+            t = time.perf_counter()
+            for seq in list(pending):
+                ahead = seq - cum - 1
+                if seq <= cum or (ahead < SACK_BITS and bits >> ahead & 1):
+                    latencies.append((t - pending.pop(seq)[1]) * 1000.0)
+
+    elapsed = min(time.perf_counter(), stop) - start
+    print('%d sent, %d acked, %d retransmits, %d expired, %d superseded' % (
+        sent, len(latencies), retransmits, expired, superseded))
+    print('%.1f msg/s acked, latency p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms' % (
+        len(latencies) / elapsed, percentile(latencies, 50), percentile(latencies, 90),
+        percentile(latencies, 99), max(latencies) if latencies else float('nan')))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest='cmd', required=True)
+    s = sub.add_parser('serve', help='stand-in receiver')
+    s.add_argument('--bind', default='127.0.0.1')
+    s.add_argument('--port', type=int, default=3333)
+    s.add_argument('--loss', type=float, default=0.0, help='fraction of acks dropped')
+    b = sub.add_parser('bench', help='sender / load generator')
+    b.add_argument('--host', default='192.168.4.2')
+    b.add_argument('--port', type=int, default=3333)
+    b.add_argument('--window', type=int, default=1, help='frames in flight')
+    b.add_argument('--duration', type=float, default=10.0)
+    b.add_argument('--rto-ms', type=float, default=20.0, help='retransmit timeout, doubles per retry')
+    b.add_argument('--max-retries', type=int, default=6)
+    b.add_argument('--loss', type=float, default=0.0, help='fraction of frames dropped')
+    args = ap.parse_args()
+    if args.cmd == 'serve':
+        serve(args)
+    else:
+        bench(args)
+
+
+if __name__ == '__main__':
+    main()